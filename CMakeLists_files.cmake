@@ -6,19 +6,34 @@ list( APPEND MAIN_SOURCE_FILES
         opm/test_util/summaryRegressionTest.cpp
         opm/test_util/summaryComparator.cpp
         opm/test_util/EclFilesComparator.cpp
+        opm/test_util/DeviationKernels.cpp
+        opm/test_util/TimeAlignment.cpp
         opm/output/eclipse/EclipseGridInspector.cpp
         opm/output/eclipse/EclipseIO.cpp
+        opm/output/eclipse/EGridIO.cpp
+        opm/output/eclipse/HydrocarbonPoreVolume.cpp
         opm/output/eclipse/LinearisedOutputTable.cpp
+        opm/output/eclipse/MappedEclFile.cpp
+        opm/output/eclipse/OutputQueue.cpp
+        opm/output/eclipse/Parallel.cpp
         opm/output/eclipse/RestartIO.cpp
+        opm/output/eclipse/StagingArea.cpp
+        opm/output/eclipse/Statistics.cpp
         opm/output/eclipse/Summary.cpp
+        opm/output/eclipse/SummaryWriter.cpp
         opm/output/eclipse/Tables.cpp
         opm/output/eclipse/RegionCache.cpp
+        opm/output/eclipse/RegionReduction.cpp
         opm/output/data/Solution.cpp
+        opm/output/data/IndexedWells.cpp
+        opm/output/data/RatesTable.cpp
     )
 
 list (APPEND PUBLIC_HEADER_FILES
         opm/output/OutputWriter.hpp
         opm/output/data/Wells.hpp
+        opm/output/data/IndexedWells.hpp
+        opm/output/data/RatesTable.hpp
         opm/output/data/Cells.hpp
         opm/test_util/summaryRegressionTest.hpp
         opm/test_util/summaryIntegrationTest.hpp
@@ -26,14 +41,26 @@ list (APPEND PUBLIC_HEADER_FILES
         opm/output/eclipse/EclipseGridInspector.hpp
         opm/output/eclipse/EclipseIOUtil.hpp
         opm/output/eclipse/EclipseIO.hpp
+        opm/output/eclipse/EGridIO.hpp
+        opm/output/eclipse/HydrocarbonPoreVolume.hpp
         opm/output/eclipse/LinearisedOutputTable.hpp
+        opm/output/eclipse/MappedEclFile.hpp
+        opm/output/eclipse/OutputQueue.hpp
         opm/output/eclipse/RestartIO.hpp
         opm/output/eclipse/RestartValue.hpp
+        opm/output/eclipse/StagingArea.hpp
+        opm/output/eclipse/Statistics.hpp
         opm/output/eclipse/Summary.hpp
+        opm/output/eclipse/SummaryWriter.hpp
         opm/output/eclipse/Tables.hpp        
+        opm/output/eclipse/UnitConversion.hpp
         opm/output/eclipse/RegionCache.hpp
+        opm/output/eclipse/RegionReduction.hpp
+        opm/output/eclipse/Parallel.hpp
         opm/output/data/Solution.hpp
         opm/test_util/EclFilesComparator.hpp
+        opm/test_util/DeviationKernels.hpp
+        opm/test_util/TimeAlignment.hpp
         opm/test_util/summaryRegressionTest.hpp
         opm/test_util/summaryComparator.hpp
     )
@@ -41,6 +68,8 @@ list (APPEND PUBLIC_HEADER_FILES
 list (APPEND EXAMPLE_SOURCE_FILES
         test_util/compareECL.cpp
         test_util/compareSummary.cpp
+        test_util/summaryBenchmark.cpp
+        test_util/convertBenchmark.cpp
     )
 
 # programs listed here will not only be compiled, but also marked for
@@ -52,13 +81,23 @@ list (APPEND PROGRAM_SOURCE_FILES
 
 list (APPEND TEST_SOURCE_FILES
         tests/test_compareSummary.cpp
+        tests/test_DeviationKernels.cpp
         tests/test_EclFilesComparator.cpp
         tests/test_EclipseIO.cpp
+        tests/test_EGridIO.cpp
+        tests/test_HydrocarbonPoreVolume.cpp
         tests/test_LinearisedOutputTable.cpp
+        tests/test_MappedEclFile.cpp
+        tests/test_OutputQueue.cpp
+        tests/test_Parallel.cpp
         tests/test_Restart.cpp
         tests/test_RFT.cpp
+        tests/test_StagingArea.cpp
+        tests/test_Statistics.cpp
         tests/test_Summary.cpp
         tests/test_Tables.cpp
+        tests/test_TimeAlignment.cpp
+        tests/test_UnitConversion.cpp
         tests/test_Wells.cpp
         tests/test_writenumwells.cpp
         tests/test_Solution.cpp
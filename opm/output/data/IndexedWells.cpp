@@ -0,0 +1,225 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+
+#include <opm/output/data/IndexedWells.hpp>
+
+
+namespace Opm {
+namespace data {
+
+const int IndexedWells::npos;
+const std::size_t IndexedWells::no_row;
+
+IndexedWells::IndexedWells( const WellRates& wells ) {
+    std::size_t num_completions = 0;
+    for( const auto& pair : wells )
+        num_completions += pair.second.completions.size();
+
+    this->names.reserve( wells.size() );
+    this->entries.reserve( wells.size() );
+    this->name_index.reserve( wells.size() );
+    this->completion_data.reserve( num_completions );
+    this->well_table.reserve( wells.size() );
+    this->completion_table.reserve( num_completions );
+    this->completion_index.reserve( num_completions );
+
+    for( const auto& pair : wells )
+        this->add( pair.first, pair.second );
+}
+
+
+int IndexedWells::add( const std::string& name, const Well& well ) {
+    const int well_id = this->entries.size();
+    if( !this->name_index.emplace( name, well_id ).second )
+        throw std::invalid_argument( "Well " + name + " has already been added" );
+
+    this->names.push_back( name );
+    this->entries.push_back( { well.rates,
+                               well.bhp,
+                               well.thp,
+                               well.temperature,
+                               well.control,
+                               this->completion_data.size(),
+                               well.completions.size() } );
+    this->well_table.push_back( well.rates );
+
+    for( const auto& completion : well.completions ) {
+        /*
+          If a well has several completions with the same active index
+          the first one is found, this is the same as the std::find_if()
+          lookup in WellRates::get().
+        */
+        this->completion_index.emplace( completion_key( well_id, completion.index ),
+                                        this->completion_data.size() );
+        this->completion_data.push_back( completion );
+        this->completion_table.push_back( completion.rates );
+    }
+
+    return well_id;
+}
+
+
+std::size_t IndexedWells::size() const {
+    return this->entries.size();
+}
+
+
+std::size_t IndexedWells::numCompletions() const {
+    return this->completion_data.size();
+}
+
+
+int IndexedWells::id( const std::string& name ) const {
+    const auto iter = this->name_index.find( name );
+    if( iter == this->name_index.end() )
+        return npos;
+
+    return iter->second;
+}
+
+
+const std::string& IndexedWells::name( int well_id ) const {
+    return this->names.at( well_id );
+}
+
+
+const Rates& IndexedWells::rates( int well_id ) const {
+    return this->entries[ well_id ].rates;
+}
+
+
+double IndexedWells::bhp( int well_id ) const {
+    return this->entries[ well_id ].bhp;
+}
+
+
+double IndexedWells::thp( int well_id ) const {
+    return this->entries[ well_id ].thp;
+}
+
+
+double IndexedWells::temperature( int well_id ) const {
+    return this->entries[ well_id ].temperature;
+}
+
+
+int IndexedWells::control( int well_id ) const {
+    return this->entries[ well_id ].control;
+}
+
+
+bool IndexedWells::flowing( int well_id ) const {
+    return this->entries[ well_id ].rates.any();
+}
+
+
+const Completion* IndexedWells::completions_begin( int well_id ) const {
+    return this->completion_data.data() + this->entries[ well_id ].completion_offset;
+}
+
+
+const Completion* IndexedWells::completions_end( int well_id ) const {
+    return this->completions_begin( well_id ) + this->entries[ well_id ].num_completions;
+}
+
+
+const Completion* IndexedWells::completion( int well_id, Completion::active_index active_index ) const {
+    const auto row = this->completion_row( well_id, active_index );
+    if( row == no_row )
+        return nullptr;
+
+    return &this->completion_data[ row ];
+}
+
+
+std::size_t IndexedWells::completion_row( int well_id, Completion::active_index active_index ) const {
+    if( well_id == npos ) return no_row;
+
+    const auto iter = this->completion_index.find( completion_key( well_id, active_index ) );
+    if( iter == this->completion_index.end() )
+        return no_row;
+
+    return iter->second;
+}
+
+
+const RatesTable& IndexedWells::well_rates() const {
+    return this->well_table;
+}
+
+
+const RatesTable& IndexedWells::completion_rates() const {
+    return this->completion_table;
+}
+
+
+double IndexedWells::get( int well_id, Rates::opt m ) const {
+    if( well_id == npos ) return 0.0;
+
+    return this->entries[ well_id ].rates.get( m, 0.0 );
+}
+
+
+double IndexedWells::get( int well_id, Completion::active_index active_index, Rates::opt m ) const {
+    if( well_id == npos ) return 0.0;
+
+    const auto* c = this->completion( well_id, active_index );
+    if( !c ) return 0.0;
+
+    return c->rates.get( m, 0.0 );
+}
+
+
+double IndexedWells::get( const std::string& well_name, Rates::opt m ) const {
+    return this->get( this->id( well_name ), m );
+}
+
+
+double IndexedWells::get( const std::string& well_name, Completion::active_index active_index, Rates::opt m ) const {
+    return this->get( this->id( well_name ), active_index, m );
+}
+
+
+WellRates IndexedWells::wells() const {
+    WellRates wells;
+    for( std::size_t well_id = 0; well_id < this->entries.size(); well_id++ ) {
+        const auto& entry = this->entries[ well_id ];
+        auto& well = wells[ this->names[ well_id ] ];
+
+        well.rates = entry.rates;
+        well.bhp = entry.bhp;
+        well.thp = entry.thp;
+        well.temperature = entry.temperature;
+        well.control = entry.control;
+        well.completions.assign( this->completions_begin( well_id ),
+                                 this->completions_end( well_id ) );
+    }
+
+    return wells;
+}
+
+
+std::uint64_t IndexedWells::completion_key( int well_id, Completion::active_index active_index ) {
+    return (std::uint64_t( well_id ) << 32) | std::uint64_t( active_index & 0xFFFFFFFF );
+}
+
+}
+}
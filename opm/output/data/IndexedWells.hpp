@@ -0,0 +1,134 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_INDEXED_WELLS_HPP
+#define OPM_OUTPUT_INDEXED_WELLS_HPP
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <opm/output/data/RatesTable.hpp>
+#include <opm/output/data/Wells.hpp>
+
+namespace Opm {
+
+    namespace data {
+
+    /*
+      The IndexedWells class is a flat alternative to the map based
+      data::Wells container. The well names are interned to dense
+      integer ids 0, 1, 2, ... in the order the wells are added, the
+      well data is stored in one vector indexed by the id and the
+      completions of all the wells are stored contiguously in one
+      vector. Lookup of a completion from (well id, active index) goes
+      through a hash table which is built when the wells are added, so
+      both well and completion lookup is O(1).
+
+      In addition the rates are stored column wise in two RatesTable
+      instances: one with a row for each well, where the row is the well
+      id, and one with a row for each completion, where the row is the
+      position of the completion in the contiguous completion storage.
+      Summing a phase over a set of wells or completions is then a
+      reduction over one array.
+
+      The class can be created from a data::Wells instance, and the
+      get() methods with well name arguments have the same semantics
+      as the corresponding methods in data::WellRates; that way the
+      simulator can continue to assemble data::Wells and the output
+      layer can convert once per timestep.
+    */
+
+    class IndexedWells {
+    public:
+        static const int npos = -1;
+        static const std::size_t no_row = std::size_t( -1 );
+
+        IndexedWells() = default;
+        explicit IndexedWells( const WellRates& wells );
+
+        /// Add a well; returns the id of the new well. Throws
+        /// std::invalid_argument if the well has already been added.
+        int add( const std::string& name, const Well& well );
+
+        std::size_t size() const;
+        std::size_t numCompletions() const;
+
+        /// The id of the well, or npos if the well is not present.
+        int id( const std::string& name ) const;
+        const std::string& name( int id ) const;
+
+        const Rates& rates( int id ) const;
+        double bhp( int id ) const;
+        double thp( int id ) const;
+        double temperature( int id ) const;
+        int control( int id ) const;
+        bool flowing( int id ) const;
+
+        /// The completions of well id are the elements
+        /// [completions_begin( id ), completions_end( id )).
+        const Completion* completions_begin( int id ) const;
+        const Completion* completions_end( int id ) const;
+
+        /// The completion in cell active_index of well id, or nullptr
+        /// if the well has no such completion.
+        const Completion* completion( int id, Completion::active_index active_index ) const;
+
+        /// The row of the completion in completion_rates(), or no_row
+        /// if the well has no such completion.
+        std::size_t completion_row( int id, Completion::active_index active_index ) const;
+
+        const RatesTable& well_rates() const;
+        const RatesTable& completion_rates() const;
+
+        double get( int id, Rates::opt m ) const;
+        double get( int id, Completion::active_index active_index, Rates::opt m ) const;
+        double get( const std::string& well_name, Rates::opt m ) const;
+        double get( const std::string& well_name, Completion::active_index active_index, Rates::opt m ) const;
+
+        /// Convert back to the map based container.
+        WellRates wells() const;
+
+    private:
+        struct well_entry {
+            Rates rates;
+            double bhp;
+            double thp;
+            double temperature;
+            int control;
+            std::size_t completion_offset;
+            std::size_t num_completions;
+        };
+
+        static std::uint64_t completion_key( int id, Completion::active_index active_index );
+
+        std::vector< std::string > names;
+        std::vector< well_entry > entries;
+        std::vector< Completion > completion_data;
+        RatesTable well_table;
+        RatesTable completion_table;
+        std::unordered_map< std::string, int > name_index;
+        std::unordered_map< std::uint64_t, std::size_t > completion_index;
+    };
+
+    }
+}
+
+#endif //OPM_OUTPUT_INDEXED_WELLS_HPP
@@ -0,0 +1,203 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+#include <string>
+
+#include <opm/output/data/RatesTable.hpp>
+
+
+namespace Opm {
+namespace data {
+
+namespace {
+
+/*
+  The reductions use four independent partial sums. Without
+  -ffast-math the compiler is not allowed to reorder a single floating
+  point accumulation, with four accumulators the loop bodies are
+  independent and can be vectorized - and the summation order, and
+  thereby the result, is still fixed.
+*/
+
+struct identity {
+    double operator()( double v ) const { return v; }
+};
+
+struct positive {
+    double operator()( double v ) const { return v > 0 ? v : 0.0; }
+};
+
+struct non_positive {
+    double operator()( double v ) const { return v > 0 ? 0.0 : v; }
+};
+
+template< typename F >
+double reduce( const double* values, std::size_t size, F f ) {
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    std::size_t i = 0;
+
+    for( ; i + 4 <= size; i += 4 ) {
+        s0 += f( values[ i ] );
+        s1 += f( values[ i + 1 ] );
+        s2 += f( values[ i + 2 ] );
+        s3 += f( values[ i + 3 ] );
+    }
+
+    for( ; i < size; i++ )
+        s0 += f( values[ i ] );
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+template< typename F >
+double reduce( const double* values, const std::vector< std::size_t >& rows, F f ) {
+    const auto size = rows.size();
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    std::size_t i = 0;
+
+    for( ; i + 4 <= size; i += 4 ) {
+        s0 += f( values[ rows[ i ] ] );
+        s1 += f( values[ rows[ i + 1 ] ] );
+        s2 += f( values[ rows[ i + 2 ] ] );
+        s3 += f( values[ rows[ i + 3 ] ] );
+    }
+
+    for( ; i < size; i++ )
+        s0 += f( values[ rows[ i ] ] );
+
+    return (s0 + s1) + (s2 + s3);
+}
+
+}
+
+
+const constexpr std::size_t RatesTable::num_columns;
+
+
+std::size_t RatesTable::column_index( Rates::opt m ) {
+    const auto bits = static_cast< Rates::enum_size >( m );
+    if( bits == 0 || (bits & (bits - 1)) != 0 || bits >= (1U << num_columns) )
+        throw std::invalid_argument( "Unknown value type '" + std::to_string( bits ) + "'" );
+
+    std::size_t index = 0;
+    while( (bits >> index) != 1 )
+        index++;
+
+    return index;
+}
+
+
+std::size_t RatesTable::size() const {
+    return this->masks.size();
+}
+
+
+void RatesTable::reserve( std::size_t num_rows ) {
+    for( auto& column : this->columns )
+        column.reserve( num_rows );
+
+    this->masks.reserve( num_rows );
+}
+
+
+void RatesTable::clear() {
+    for( auto& column : this->columns )
+        column.clear();
+
+    this->masks.clear();
+}
+
+
+std::size_t RatesTable::push_back( const Rates& rates ) {
+    Rates::enum_size mask = 0;
+    for( std::size_t index = 0; index < num_columns; index++ ) {
+        const auto m = static_cast< Rates::opt >( 1U << index );
+        if( rates.has( m ) )
+            mask |= static_cast< Rates::enum_size >( m );
+
+        this->columns[ index ].push_back( rates.get( m, 0.0 ) );
+    }
+
+    this->masks.push_back( mask );
+    return this->masks.size() - 1;
+}
+
+
+bool RatesTable::has( std::size_t row, Rates::opt m ) const {
+    const auto bits = static_cast< Rates::enum_size >( m );
+    return (this->masks[ row ] & bits) == bits;
+}
+
+
+double RatesTable::get( std::size_t row, Rates::opt m, double default_value ) const {
+    if( !this->has( row, m ) ) return default_value;
+
+    return this->columns[ column_index( m ) ][ row ];
+}
+
+
+Rates RatesTable::rates( std::size_t row ) const {
+    Rates rates;
+    for( std::size_t index = 0; index < num_columns; index++ ) {
+        const auto m = static_cast< Rates::opt >( 1U << index );
+        if( this->has( row, m ) )
+            rates.set( m, this->columns[ index ][ row ] );
+    }
+
+    return rates;
+}
+
+
+const double* RatesTable::column( Rates::opt m ) const {
+    return this->columns[ column_index( m ) ].data();
+}
+
+
+double RatesTable::sum( Rates::opt m ) const {
+    return reduce( this->column( m ), this->size(), identity() );
+}
+
+
+double RatesTable::sum( Rates::opt m, const rows& index_set ) const {
+    return reduce( this->column( m ), index_set, identity() );
+}
+
+
+double RatesTable::injected( Rates::opt m ) const {
+    return reduce( this->column( m ), this->size(), positive() );
+}
+
+
+double RatesTable::injected( Rates::opt m, const rows& index_set ) const {
+    return reduce( this->column( m ), index_set, positive() );
+}
+
+
+double RatesTable::produced( Rates::opt m ) const {
+    return -reduce( this->column( m ), this->size(), non_positive() );
+}
+
+
+double RatesTable::produced( Rates::opt m, const rows& index_set ) const {
+    return -reduce( this->column( m ), index_set, non_positive() );
+}
+
+}
+}
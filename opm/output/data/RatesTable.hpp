@@ -0,0 +1,82 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_RATES_TABLE_HPP
+#define OPM_OUTPUT_RATES_TABLE_HPP
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include <opm/output/data/Wells.hpp>
+
+namespace Opm {
+
+    namespace data {
+
+    /*
+      The RatesTable class stores a sequence of data::Rates instances
+      column wise, i.e. with one contiguous array of doubles for each
+      Rates::opt value and one presence mask for each row. Values which
+      are not set are stored as 0.0, so the reductions below can run
+      straight through a column without looking at the masks; that is
+      the same result as summing Rates::get( m, 0.0 ) over the rows.
+
+      The sign based reductions follow the convention of the summary
+      evaluators: a positive rate is injection and a non-positive rate
+      is production, and production is returned as a positive number.
+    */
+
+    class RatesTable {
+    public:
+        static const constexpr std::size_t num_columns = 11;
+        using rows = std::vector< std::size_t >;
+
+        std::size_t size() const;
+        void reserve( std::size_t num_rows );
+        void clear();
+
+        /// Append a row; returns the index of the new row.
+        std::size_t push_back( const Rates& rates );
+
+        bool has( std::size_t row, Rates::opt m ) const;
+        double get( std::size_t row, Rates::opt m, double default_value ) const;
+        Rates rates( std::size_t row ) const;
+
+        /// The values of m for all the rows.
+        const double* column( Rates::opt m ) const;
+
+        double sum( Rates::opt m ) const;
+        double sum( Rates::opt m, const rows& index_set ) const;
+        double injected( Rates::opt m ) const;
+        double injected( Rates::opt m, const rows& index_set ) const;
+        double produced( Rates::opt m ) const;
+        double produced( Rates::opt m, const rows& index_set ) const;
+
+        static std::size_t column_index( Rates::opt m );
+
+    private:
+        std::array< std::vector< double >, num_columns > columns;
+        std::vector< Rates::enum_size > masks;
+    };
+
+    }
+}
+
+#endif //OPM_OUTPUT_RATES_TABLE_HPP
@@ -32,6 +32,10 @@ bool Solution::has(const std::string& keyword) const {
     return this->count( keyword ) > 0;
 }
 
+bool Solution::isSI() const {
+    return this->si;
+}
+
 std::vector<double>& Solution::data(const std::string& keyword) {
     return this->at( keyword ).data;
 }
@@ -48,6 +52,24 @@ std::pair< Solution::iterator, bool > Solution::insert( std::string name,
     return this->emplace( name, CellData{ m, std::move( xs ), type } );
 }
 
+void data::Solution::assign( const Solution& other ) {
+    for( auto iter = this->begin(); iter != this->end(); ) {
+        if( other.has( iter->first ) )
+            ++iter;
+        else
+            iter = this->erase( iter );
+    }
+
+    for( const auto& elm : other ) {
+        auto& field = (*this)[ elm.first ];
+        field.dim = elm.second.dim;
+        field.target = elm.second.target;
+        field.data.assign( elm.second.data.begin(), elm.second.data.end() );
+    }
+
+    this->si = other.si;
+}
+
 void data::Solution::convertToSI( const UnitSystem& units ) {
     if (this->si) return;
 
@@ -40,6 +40,10 @@ class Solution : public std::map< std::string, data::CellData > {
 
         bool has( const std::string& ) const;
 
+        /// true if the data is in SI units, i.e. not converted with
+        /// convertFromSI().
+        bool isSI() const;
+
         /*
          * Get the data field of the struct matching the requested key. Will
          * throw std::out_of_range if they key does not exist.
@@ -52,6 +56,14 @@ class Solution : public std::map< std::string, data::CellData > {
                                             std::vector< double >,
                                             TargetType );
 
+        /*
+         * Make this solution a copy of other. The data vectors of the
+         * keywords which are already present are reused, so copying a
+         * solution with the same keywords and sizes as the previous one
+         * does not allocate.
+         */
+        void assign( const Solution& other );
+
         void convertToSI( const UnitSystem& );
         void convertFromSI( const UnitSystem& );
 
@@ -0,0 +1,273 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+#include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
+#include <opm/parser/eclipse/EclipseState/Grid/NNC.hpp>
+
+#include <opm/output/eclipse/EGridIO.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
+#include <opm/output/eclipse/Statistics.hpp>
+
+#include <ert/ecl/EclKW.hpp>
+#include <ert/ecl/ecl_endian_flip.h>
+#include <ert/ecl/ecl_grid.h>
+#include <ert/ecl/ecl_kw.h>
+#include <ert/ecl/ecl_kw_magic.h>
+
+namespace Opm {
+namespace EGridIO {
+
+namespace {
+
+    /* number of elements in one data block of an INTE keyword */
+    const std::size_t block_size = 1000;
+
+    void put_int( char* p, std::int32_t value ) {
+        const auto v = static_cast< std::uint32_t >( value );
+        p[ 0 ] = char( v >> 24 );
+        p[ 1 ] = char( v >> 16 );
+        p[ 2 ] = char( v >> 8 );
+        p[ 3 ] = char( v );
+    }
+
+    /*
+      Write an INTE keyword to an unformatted file, with element i given
+      by value( i ). The header and the data blocks are written as
+      separate records, encoded big endian like ecl_kw_fwrite().
+    */
+    template< typename F >
+    void write_int_keyword( fortio_type* fortio, const char* name, std::size_t size, F value ) {
+        using out::statistics::phase;
+
+        char header[ 16 ];
+        std::memset( header, ' ', 8 );
+        std::memcpy( header, name, std::min< std::size_t >( 8, std::strlen( name ) ));
+        put_int( header + 8, std::int32_t( size ) );
+        std::memcpy( header + 12, "INTE", 4 );
+        {
+            out::statistics::scoped_write write( phase::egrid_write );
+            fortio_fwrite_record( fortio, header, sizeof header );
+        }
+
+        char block[ 4 * block_size ];
+        for( std::size_t first = 0; first < size; first += block_size ) {
+            const auto count = std::min( block_size, size - first );
+            for( std::size_t i = 0; i < count; i++ )
+                put_int( block + 4 * i, value( first + i ) );
+
+            out::statistics::scoped_write write( phase::egrid_write, 0 );
+            fortio_fwrite_record( fortio, block, int( 4 * count ) );
+        }
+    }
+
+    void truncate( const std::string& filename, std::size_t offset ) {
+        if( ::truncate( filename.c_str(), off_t( offset ) ) != 0 )
+            throw std::runtime_error( "Could not truncate EGRID file " + filename );
+    }
+
+    /*
+      If ERT has written an empty set of NNC keywords for the grid, the
+      keywords are cut off so that the NNC keywords are not repeated.
+    */
+    void drop_empty_unformatted_nnc( const std::string& filename ) {
+        std::size_t offset = 0;
+        {
+            out::MappedEclFile file( filename );
+            const auto& keywords = file.keywords();
+            const auto size = keywords.size();
+            if( size < 3 ) return;
+
+            const auto& head = keywords[ size - 3 ];
+            const auto& nnc1 = keywords[ size - 2 ];
+            const auto& nnc2 = keywords[ size - 1 ];
+            if( head.name != NNCHEAD_KW || nnc1.name != NNC1_KW || nnc2.name != NNC2_KW
+                || nnc1.count != 0 || nnc2.count != 0 )
+                return;
+
+            offset = head.offset;
+        }
+
+        truncate( filename, offset );
+    }
+
+    /* The name of a keyword header in a formatted file, e.g. 'NNC1    '. */
+    bool read_name( std::istream& stream, std::string& name ) {
+        char quote;
+        if( !(stream >> quote) || quote != '\'' )
+            return false;
+
+        if( !std::getline( stream, name, '\'' ) )
+            return false;
+
+        name.erase( name.find_last_not_of( ' ' ) + 1 );
+        return true;
+    }
+
+    bool read_header( std::istream& stream, const char* name, int& count ) {
+        std::string kw, type;
+        return read_name( stream, kw ) && kw == name
+            && ( stream >> count ) && count >= 0
+            && read_name( stream, type ) && type == "INTE";
+    }
+
+    /*
+      As above for a formatted file. The NNC keywords written by ERT
+      are short - NNCHEAD has NNCHEAD_SIZE elements, NNC1 and NNC2 are
+      empty - so only the tail of the file is read.
+    */
+    void drop_empty_formatted_nnc( const std::string& filename ) {
+        std::ifstream stream( filename, std::ios::binary | std::ios::ate );
+        if( !stream )
+            return;
+
+        const std::size_t size = stream.tellg();
+        const auto tail_size = std::min< std::size_t >( size, 4096 );
+        std::string tail( tail_size, ' ' );
+        stream.seekg( size - tail_size );
+        if( !stream.read( &tail[ 0 ], tail_size ) )
+            return;
+
+        const auto head = tail.rfind( "'" NNCHEAD_KW );
+        if( head == std::string::npos )
+            return;
+
+        const auto line = tail.rfind( '\n', head );
+        if( line == std::string::npos && tail_size < size )
+            return;
+
+        std::istringstream keywords( tail.substr( head ) );
+        int count;
+        if( !read_header( keywords, NNCHEAD_KW, count ) )
+            return;
+
+        for( int i = 0, value; i < count; i++ )
+            if( !(keywords >> value) )
+                return;
+
+        int nnc1, nnc2;
+        if( !read_header( keywords, NNC1_KW, nnc1 ) || nnc1 != 0
+            || !read_header( keywords, NNC2_KW, nnc2 ) || nnc2 != 0 )
+            return;
+
+        if( !(keywords >> std::ws).eof() )
+            return;
+
+        const auto begin = line == std::string::npos ? 0 : line + 1;
+        truncate( filename, size - tail_size + begin );
+    }
+
+}
+
+
+void writeNNC( fortio_type* fortio, const NNC& nnc ) {
+    const auto& data = nnc.nncdata();
+    if( data.empty() ) return;
+
+    if( data.size() > std::size_t( INT_MAX ) )
+        throw std::invalid_argument( "Too many non neighbour connections for the EGRID file" );
+
+    const auto num_nnc = int( data.size() );
+    std::vector< int > nnchead( NNCHEAD_SIZE, 0 );
+    nnchead[ NNCHEAD_NUMNNC_INDEX ] = num_nnc;
+    nnchead[ NNCHEAD_LGR_INDEX ] = 0;
+
+    /* ECLIPSE cell indices are one based */
+    const auto cell1 = [&data]( std::size_t i ) { return std::int32_t( data[ i ].cell1 + 1 ); };
+    const auto cell2 = [&data]( std::size_t i ) { return std::int32_t( data[ i ].cell2 + 1 ); };
+
+    if( fortio_fmt_file( fortio ) ) {
+        std::vector< int > nnc1( num_nnc ), nnc2( num_nnc );
+        for( std::size_t i = 0; i < data.size(); i++ ) {
+            nnc1[ i ] = cell1( i );
+            nnc2[ i ] = cell2( i );
+        }
+
+        ERT::EclKW< int > nnchead_kw( NNCHEAD_KW, nnchead );
+        ERT::EclKW< int > nnc1_kw( NNC1_KW, nnc1 );
+        ERT::EclKW< int > nnc2_kw( NNC2_KW, nnc2 );
+
+        /* The NNC1 and NNC2 vectors and the three ERT keywords. */
+        out::statistics::add_allocations( out::statistics::phase::egrid_write, 5 );
+
+        out::statistics::scoped_write write( out::statistics::phase::egrid_write, 3 );
+        ecl_kw_fwrite( nnchead_kw.get(), fortio );
+        ecl_kw_fwrite( nnc1_kw.get(), fortio );
+        ecl_kw_fwrite( nnc2_kw.get(), fortio );
+        return;
+    }
+
+    write_int_keyword( fortio, NNCHEAD_KW, nnchead.size(),
+                       [&nnchead]( std::size_t i ) { return std::int32_t( nnchead[ i ] ); } );
+    write_int_keyword( fortio, NNC1_KW, data.size(), cell1 );
+    write_int_keyword( fortio, NNC2_KW, data.size(), cell2 );
+}
+
+
+void save( const std::string& filename,
+           const EclipseGrid& grid,
+           const NNC& nnc,
+           ert_ecl_unit_enum output_units,
+           bool formatted ) {
+    /*
+      ecl_grid_fwrite_EGRID2() only reads the grid, but is not declared
+      with a const grid pointer.
+    */
+    {
+        out::statistics::scoped_write write( out::statistics::phase::egrid_write, 0 );
+        ecl_grid_fwrite_EGRID2( const_cast< ecl_grid_type* >( grid.c_ptr() ),
+                                filename.c_str(),
+                                output_units );
+    }
+
+    if( nnc.nncdata().empty() ) return;
+
+    if( formatted )
+        drop_empty_formatted_nnc( filename );
+    else
+        drop_empty_unformatted_nnc( filename );
+
+    auto* fortio = fortio_open_append( filename.c_str(), formatted, ECL_ENDIAN_FLIP );
+    if( !fortio )
+        throw std::runtime_error( "Could not open EGRID file " + filename + " to append the NNC keywords" );
+
+    try {
+        writeNNC( fortio, nnc );
+    } catch( ... ) {
+        fortio_fclose( fortio );
+        throw;
+    }
+
+    fortio_fclose( fortio );
+}
+
+}
+}
@@ -0,0 +1,64 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_EGRID_IO_HPP
+#define OPM_OUTPUT_EGRID_IO_HPP
+
+#include <string>
+
+#include <ert/ecl/ecl_util.h>
+#include <ert/ecl/fortio.h>
+
+namespace Opm {
+
+class EclipseGrid;
+class NNC;
+
+namespace EGridIO {
+
+/*
+  EGridIO::save() writes the grid to an EGRID file, followed by the non
+  neighbour connections as the keywords NNCHEAD, NNC1 and NNC2. The NNC
+  keywords are written straight from the NNC container, in container
+  order - the same order as the TRANNNC keyword in the INIT file. The
+  grid object is not modified, so save() can run concurrently with
+  other output which reads the grid, e.g. the INIT file.
+
+  In unformatted files the cell indices of NNC1 and NNC2 are encoded
+  and written one 1000 element data block at a time, so the memory use
+  does not depend on the number of connections. Formatted files are
+  written with ERT, holding one keyword in memory.
+
+  The grid must not have local grid refinements, the NNC keywords are
+  appended after the global grid; empty NNC keywords written by ERT at
+  the end of the file are replaced, in formatted and unformatted files.
+*/
+
+void save( const std::string& filename,
+           const EclipseGrid& grid,
+           const NNC& nnc,
+           ert_ecl_unit_enum output_units,
+           bool formatted );
+
+void writeNNC( fortio_type* fortio, const NNC& nnc );
+
+}
+}
+
+#endif //OPM_OUTPUT_EGRID_IO_HPP
@@ -41,8 +41,17 @@
 #include <opm/output/eclipse/Summary.hpp>
 #include <opm/output/eclipse/Tables.hpp>
 #include <opm/output/eclipse/RestartIO.hpp>
+#include <opm/output/eclipse/EGridIO.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
+#include <opm/output/eclipse/OutputQueue.hpp>
+#include <opm/output/eclipse/Parallel.hpp>
+#include <opm/output/eclipse/StagingArea.hpp>
+#include <opm/output/eclipse/Statistics.hpp>
+#include <opm/output/eclipse/UnitConversion.hpp>
 
 #include <cstdlib>
+#include <future>
+#include <stdexcept>
 #include <memory>     // unique_ptr
 #include <utility>    // move
 
@@ -60,6 +69,8 @@
 #include <ert/util/util.h>
 #include <ert/ecl/fortio.h>
 
+#include <sys/stat.h>
+
 #define OPM_XWEL      "OPM_XWEL"
 #define OPM_IWEL      "OPM_IWEL"
 
@@ -74,28 +85,128 @@ void writeKeyword( ERT::FortIO& fortio ,
                    const std::string& keywordName,
                    const std::vector<int> &data ) {
     ERT::EclKW< int > kw( keywordName, data );
+    out::statistics::add_allocations( out::statistics::phase::init_write );
+    out::statistics::scoped_write write( out::statistics::phase::init_write );
     kw.fwrite( fortio );
 }
 
 /*
   This overload hardcodes the common assumption that properties which
   are stored internally as double values in OPM should be stored as
-  float values in the ECLIPSE formatted binary files.
+  float values in the ECLIPSE formatted binary files. The values are
+  converted to output units and narrowed to float in one pass straight
+  into the keyword buffer.
 */
 
 void writeKeyword( ERT::FortIO& fortio ,
                    const std::string& keywordName,
-                   const std::vector<double> &data) {
+                   const std::vector<double> &data,
+                   const out::UnitConversion& conversion = out::UnitConversion()) {
 
-    ERT::EclKW< float > kw( keywordName, data );
+    ERT::EclKW< float > kw( keywordName, data.size() );
+    out::statistics::add_allocations( out::statistics::phase::init_write );
+    conversion.apply( data.data(), data.size(), ecl_kw_get_float_ptr( kw.get() ));
+    out::statistics::scoped_write write( out::statistics::phase::init_write );
     kw.fwrite( fortio );
+}
+
+
+/*
+  A grid property with one value per global cell which is written to
+  the INIT file for the active cells only.
+*/
+template< typename T >
+struct global_property {
+    std::string name;
+    const std::vector< T >* data;
+    out::UnitConversion conversion;
+};
+
+/*
+  The global index of each active cell; gathering with this index is
+  the same as compressedCopy() and compressedVector(), but the index is
+  only built once for all the properties.
+*/
+std::vector< size_t > active_cells( const EclipseGrid& grid ) {
+    std::vector< size_t > cells;
+    cells.reserve( grid.getNumActive() );
+    for( size_t global_index = 0; global_index < grid.getCartesianSize(); global_index++ )
+        if( grid.cellActive( global_index ) )
+            cells.push_back( global_index );
+
+    return cells;
+}
+
+void gather( const global_property< double >& prop, const std::vector< size_t >& cells, float* output ) {
+    prop.conversion.gather( prop.data->data(), cells.data(), cells.size(), output );
+}
 
+void gather( const global_property< int >& prop, const std::vector< size_t >& cells, int* output ) {
+    const auto* input = prop.data->data();
+    for( size_t i = 0; i < cells.size(); i++ )
+        output[ i ] = input[ cells[ i ] ];
 }
 
+/*
+  Write the active cell values of the properties as keywords, in the
+  order of the properties; doubles are converted to output units and
+  narrowed to float. The keywords are filled in parallel in batches of
+  one keyword per thread, and each batch is written on the calling
+  thread before the next is filled, so at most one batch of keywords is
+  held in memory.
+*/
+template< typename T, typename Output >
+void writeActive( ERT::FortIO& fortio,
+                  const std::vector< global_property< T > >& properties,
+                  const std::vector< size_t >& cells,
+                  size_t global_size ) {
+
+    for( const auto& prop : properties ) {
+        if( prop.data->size() != global_size )
+            throw std::invalid_argument( "The property " + prop.name
+                                         + " does not have one value per cell in the grid" );
+    }
+
+    const auto num_props = properties.size();
+    const auto batch_size = std::min( num_props,
+                                      out::parallel::num_threads( num_props * cells.size(), 1 << 16 ));
+
+    for( size_t first = 0; first < num_props; first += batch_size ) {
+        const auto size = std::min( batch_size, num_props - first );
+        std::vector< std::unique_ptr< ERT::EclKW< Output > > > keywords;
+        for( size_t p = 0; p < size; p++ )
+            keywords.emplace_back( new ERT::EclKW< Output >( properties[ first + p ].name, cells.size() ) );
+        out::statistics::add_allocations( out::statistics::phase::init_write, size );
+
+        out::parallel::run( size, [&]( size_t p ) {
+            auto* output = static_cast< Output* >( ecl_kw_get_ptr( keywords[ p ]->get() ));
+            gather( properties[ first + p ], cells, output );
+        });
+
+        for( const auto& kw : keywords ) {
+            out::statistics::scoped_write write( out::statistics::phase::init_write );
+            kw->fwrite( fortio );
+        }
+    }
+}
 
 
 
 
+
+/*
+  The RFT file is opened on the first RFT report step and kept open
+  for the rest of the run; the file is flushed after each report step.
+  If the first RFT report step written is not the first RFT output of
+  the wells - i.e. this is a restarted run - the file is appended to.
+
+  The active index and the depth of the completion cells are looked up
+  in the grid once for every completion set of a well, and only when
+  the completion set changes. The pressure and saturations are then
+  gathered for the completion cells, and only the gathered values are
+  converted to output units.
+*/
+
 class RFT {
     public:
     RFT( const std::string&  output_dir,
@@ -108,10 +219,34 @@ class RFT {
                             time_t current_time,
                             double days,
                             const UnitSystem& units,
-                            data::Solution cells);
+                            const data::Solution& cells);
     private:
+        struct cell {
+            size_t i, j, k;
+            size_t active_index;
+            double depth;
+        };
+
+        struct well_cells {
+            const CompletionSet* completions = nullptr;
+            std::vector< cell > cells;
+        };
+
+        const std::vector< cell >& completion_cells( const Well& well,
+                                                     const EclipseGrid& grid,
+                                                     int report_step );
+
+        void gather( const data::Solution& solution,
+                     const std::string& keyword,
+                     const std::vector< cell >& well_cells,
+                     const UnitSystem& units,
+                     std::vector< double >& values ) const;
+
         std::string filename;
         bool fmt_file;
+        ERT::ert_unique_ptr< fortio_type, fortio_fclose > fortio;
+        std::map< std::string, well_cells > cell_cache;
+        std::vector< double > pressure, swat, sgas;
 };
 
 
@@ -123,61 +258,112 @@ class RFT {
 {}
 
 
+const std::vector< RFT::cell >& RFT::completion_cells( const Well& well,
+                                                       const EclipseGrid& grid,
+                                                       int report_step ) {
+    const auto& completions = well.getCompletions( report_step );
+    auto& entry = this->cell_cache[ well.name() ];
+    if( entry.completions == &completions )
+        return entry.cells;
+
+    entry.completions = &completions;
+    entry.cells.clear();
+    for( const auto& completion : completions ) {
+        const size_t i = size_t( completion.getI() );
+        const size_t j = size_t( completion.getJ() );
+        const size_t k = size_t( completion.getK() );
+
+        if( !grid.cellActive( i, j, k ) ) continue;
+
+        entry.cells.push_back( { i, j, k,
+                                 grid.activeIndex( i, j, k ),
+                                 grid.getCellDepth( i, j, k ) } );
+    }
+
+    return entry.cells;
+}
+
+
+void RFT::gather( const data::Solution& solution,
+                  const std::string& keyword,
+                  const std::vector< cell >& well_cells,
+                  const UnitSystem& units,
+                  std::vector< double >& values ) const {
+    const auto& elm = solution.at( keyword );
+    if( values.capacity() < well_cells.size() )
+        out::statistics::add_allocations( out::statistics::phase::rft_write );
+    values.resize( well_cells.size() );
+    for( size_t c = 0; c < well_cells.size(); c++ )
+        values[ c ] = elm.data[ well_cells[ c ].active_index ];
+
+    if( solution.isSI() ) {
+        const out::UnitConversion conversion( units, elm.dim );
+        conversion.apply( values.data(), values.size(), values.data() );
+    }
+}
+
+
 void RFT::writeTimeStep( std::vector< const Well* > wells,
                          const EclipseGrid& grid,
                          int report_step,
                          time_t current_time,
                          double days,
                          const UnitSystem& units,
-                         data::Solution cells) {
+                         const data::Solution& cells) {
     using rft = ERT::ert_unique_ptr< ecl_rft_node_type, ecl_rft_node_free >;
-    const std::vector<double>& pressure = cells.data("PRESSURE");
-    const std::vector<double>& swat = cells.data("SWAT");
-    const std::vector<double>& sgas = cells.has("SGAS") ? cells.data("SGAS") : std::vector<double>( pressure.size() , 0 );
-    fortio_type * fortio;
-    int first_report_step = report_step;
-
-    for (const auto* well : wells)
-        first_report_step = std::min( first_report_step, well->firstRFTOutput());
+    using out::statistics::phase;
+    out::statistics::scoped_timer timer( phase::rft_write );
+    const bool has_sgas = cells.has( "SGAS" );
+
+    if( !this->fortio ) {
+        int first_report_step = report_step;
+        for (const auto* well : wells)
+            first_report_step = std::min( first_report_step, well->firstRFTOutput());
+
+        if (report_step > first_report_step)
+            this->fortio.reset( fortio_open_append( filename.c_str() , fmt_file , ECL_ENDIAN_FLIP ) );
+        else
+            this->fortio.reset( fortio_open_writer( filename.c_str() , fmt_file , ECL_ENDIAN_FLIP ) );
+
+        if( !this->fortio )
+            throw std::runtime_error( "Could not open RFT file " + filename );
+    }
 
-    if (report_step > first_report_step)
-        fortio = fortio_open_append( filename.c_str() , fmt_file , ECL_ENDIAN_FLIP );
-    else
-        fortio = fortio_open_writer( filename.c_str() , fmt_file , ECL_ENDIAN_FLIP );
+    const auto start_offset = fortio_ftell( this->fortio.get() );
 
-    cells.convertFromSI( units );
     for ( const auto& well : wells ) {
         if( !( well->getRFTActive( report_step )
             || well->getPLTActive( report_step ) ) )
             continue;
 
+        const auto& well_cells = this->completion_cells( *well, grid, report_step );
+        this->gather( cells, "PRESSURE", well_cells, units, this->pressure );
+        this->gather( cells, "SWAT", well_cells, units, this->swat );
+        if( has_sgas )
+            this->gather( cells, "SGAS", well_cells, units, this->sgas );
+
         auto* rft_node = ecl_rft_node_alloc_new( well->name().c_str(), "RFT",
                 current_time, days );
 
-        for( const auto& completion : well->getCompletions( report_step ) ) {
-            const size_t i = size_t( completion.getI() );
-            const size_t j = size_t( completion.getJ() );
-            const size_t k = size_t( completion.getK() );
-
-            if( !grid.cellActive( i, j, k ) ) continue;
-
-            const auto index = grid.activeIndex( i, j, k );
-            const double depth = grid.getCellDepth( i, j, k );
-            const double press = pressure[ index ];
-            const double satwat = swat[ index ];
-            const double satgas = sgas[ index ];
+        for( size_t c = 0; c < well_cells.size(); c++ ) {
+            const auto& wc = well_cells[ c ];
+            const double satgas = has_sgas ? this->sgas[ c ] : 0.0;
 
             auto* cell = ecl_rft_cell_alloc_RFT(
-                            i, j, k, depth, press, satwat, satgas );
+                            wc.i, wc.j, wc.k, wc.depth, this->pressure[ c ], this->swat[ c ], satgas );
 
             ecl_rft_node_append_cell( rft_node, cell );
         }
 
         rft ecl_node( rft_node );
-        ecl_rft_node_fwrite( ecl_node.get(), fortio, units.getEclType() );
+
+        /* One RFT node - i.e. the keywords of one well - is counted as one keyword. */
+        out::statistics::scoped_write write( phase::rft_write );
+        ecl_rft_node_fwrite( ecl_node.get(), this->fortio.get(), units.getEclType() );
     }
 
-    fortio_fclose( fortio );
+    fortio_fflush( this->fortio.get() );
+    out::statistics::add_bytes( phase::rft_write, fortio_ftell( this->fortio.get() ) - start_offset );
 }
 
 inline std::string uppercase( std::string x ) {
@@ -192,8 +378,22 @@ inline std::string uppercase( std::string x ) {
 class EclipseIO::Impl {
     public:
     Impl( const EclipseState&, EclipseGrid, const Schedule&, const SummaryConfig& );
-        void writeINITFile( const data::Solution& simProps, std::map<std::string, std::vector<int> > int_data, const NNC& nnc) const;
+        void writeINITFile( const data::Solution& simProps, const std::map<std::string, std::vector<int> >& int_data, const NNC& nnc) const;
         void writeEGRIDFile( const NNC& nnc ) const;
+        void writeTimeStep( int report_step,
+                            bool isSubstep,
+                            double seconds_elapsed,
+                            const data::Solution& cells,
+                            const data::IndexedWells& wells,
+                            const std::map<std::string, double>& misc_summary_values,
+                            const std::map<std::string, std::vector<double>>& extra_restart,
+                            bool write_double);
+        void flush();
+        void push( int report_step,
+                   bool isSubstep,
+                   double seconds_elapsed,
+                   out::StagingArea::handle step,
+                   bool write_double );
 
         const EclipseState& es;
         EclipseGrid grid;
@@ -202,7 +402,15 @@ class EclipseIO::Impl {
         std::string baseName;
         out::Summary summary;
         RFT rft;
+        std::unique_ptr< out::MappedEclFile::IndexWriter > restart_index;
         bool output_enabled;
+        /*
+          Declared last; the queue must be destroyed - i.e. the
+          pending output written - before the summary and rft
+          members are destroyed.
+        */
+        std::unique_ptr< out::StagingArea > staging;
+        std::unique_ptr< out::OutputQueue > output_queue;
 };
 
 EclipseIO::Impl::Impl( const EclipseState& eclipseState,
@@ -220,7 +428,8 @@ EclipseIO::Impl::Impl( const EclipseState& eclipseState,
 {}
 
 
-void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, std::map<std::string, std::vector<int> > int_data, const NNC& nnc) const {
+void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, const std::map<std::string, std::vector<int> >& int_data, const NNC& nnc) const {
+    out::statistics::scoped_timer timer( out::statistics::phase::init_write );
     const auto& units = this->es.getUnits();
     const IOConfig& ioConfig = this->es.cfg().io();
 
@@ -251,22 +460,30 @@ void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, std::map<st
                 ecl_data[global_index] = 0;
 
 
-        ecl_init_file_fwrite_header( fortio.get(),
-                                     this->grid.c_ptr(),
-                                     NULL,
-                                     units.getEclType(),
-                                     this->es.runspec( ).eclPhaseMask( ),
-                                     this->schedule.posixStartTime( ));
+        {
+            out::statistics::scoped_write write( out::statistics::phase::init_write, 0 );
+            ecl_init_file_fwrite_header( fortio.get(),
+                                         this->grid.c_ptr(),
+                                         NULL,
+                                         units.getEclType(),
+                                         this->es.runspec( ).eclPhaseMask( ),
+                                         this->schedule.posixStartTime( ));
+        }
 
-        units.from_si( UnitSystem::measure::volume, ecl_data );
-        writeKeyword( fortio, "PORV" , ecl_data );
+        writeKeyword( fortio, "PORV" , ecl_data, out::UnitConversion( units, UnitSystem::measure::volume ));
     }
 
     // Writing quantities which are calculated by the grid to the INIT file.
-    ecl_grid_fwrite_depth( this->grid.c_ptr() , fortio.get() , units.getEclType( ) );
-    ecl_grid_fwrite_dims( this->grid.c_ptr() , fortio.get() , units.getEclType( ) );
+    {
+        out::statistics::scoped_write write( out::statistics::phase::init_write, 0 );
+        ecl_grid_fwrite_depth( this->grid.c_ptr() , fortio.get() , units.getEclType( ) );
+        ecl_grid_fwrite_dims( this->grid.c_ptr() , fortio.get() , units.getEclType( ) );
+    }
+
+    const auto cells = active_cells( this->grid );
 
-    // Write properties from the input deck.
+    // Write properties from the input deck, and the properties which
+    // have been initialized by the simulator.
     {
         const auto& properties = this->es.get3DProperties().getDoubleProperties();
         using double_kw = std::pair<std::string, UnitSystem::measure>;
@@ -286,24 +503,25 @@ void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, std::map<st
         // that "NTG" is included in the properties container.
         properties.assertKeyword("NTG");
 
+        std::vector< global_property< double > > double_props;
         for (const auto& kw_pair : doubleKeywords) {
             if (properties.hasKeyword( kw_pair.first)) {
                 const auto& opm_property = properties.getKeyword(kw_pair.first);
-                auto ecl_data = opm_property.compressedCopy( this->grid );
-
-                units.from_si( kw_pair.second, ecl_data );
-                writeKeyword( fortio, kw_pair.first, ecl_data );
+                double_props.push_back( { kw_pair.first,
+                                          &opm_property.getData(),
+                                          out::UnitConversion( units, kw_pair.second ) } );
             }
         }
-    }
-
 
-    // Write properties which have been initialized by the simulator.
-    {
         for (const auto& prop : simProps) {
-            auto ecl_data = this->grid.compressedVector( prop.second.data );
-            writeKeyword( fortio, prop.first, ecl_data );
+            const auto conversion = simProps.isSI()
+                                  ? out::UnitConversion( units, prop.second.dim )
+                                  : out::UnitConversion();
+
+            double_props.push_back( { prop.first, &prop.second.data, conversion } );
         }
+
+        writeActive< double, float >( fortio, double_props, cells, this->grid.getCartesianSize() );
     }
 
     // Write tables
@@ -314,6 +532,10 @@ void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, std::map<st
         tables.addPVTW( this->es.getTableManager().getPvtwTable() );
         tables.addDensity( this->es.getTableManager().getDensityTable( ) );
         tables.addSatFunc(this->es);
+
+        /* TABDIMS and TAB, which fwrite() allocates as ERT keywords. */
+        out::statistics::add_allocations( out::statistics::phase::init_write, 2 );
+        out::statistics::scoped_write write( out::statistics::phase::init_write, 2 );
         fwrite(tables, fortio);
     }
 
@@ -330,10 +552,11 @@ void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, std::map<st
         properties.assertKeyword("EQLNUM");
         properties.assertKeyword("FIPNUM");
 
-        for (const auto& property : properties) {
-            auto ecl_data = property.compressedCopy( this->grid );
-            writeKeyword( fortio , property.getKeywordName() , ecl_data );
-        }
+        std::vector< global_property< int > > int_props;
+        for (const auto& property : properties)
+            int_props.push_back( { property.getKeywordName(), &property.getData(), {} } );
+
+        writeActive< int, int >( fortio, int_props, cells, this->grid.getCartesianSize() );
     }
 
 
@@ -356,13 +579,16 @@ void EclipseIO::Impl::writeINITFile( const data::Solution& simProps, std::map<st
         for( const NNCdata& nd : nnc.nncdata() )
             tran.push_back( nd.trans );
 
-        units.from_si( UnitSystem::measure::transmissibility , tran );
-        writeKeyword( fortio, "TRANNNC" , tran );
+        writeKeyword( fortio, "TRANNNC" , tran, out::UnitConversion( units, UnitSystem::measure::transmissibility ));
     }
+
+    /* The file is written from scratch, the position is the size. */
+    out::statistics::add_bytes( out::statistics::phase::init_write, fortio_ftell( fortio.get() ));
 }
 
 
 void EclipseIO::Impl::writeEGRIDFile( const NNC& nnc ) const {
+    out::statistics::scoped_timer timer( out::statistics::phase::egrid_write );
     const auto& ioConfig = this->es.getIOConfig();
 
     std::string  egridFile( ERT::EclFilename( this->outputDir,
@@ -370,14 +596,15 @@ void EclipseIO::Impl::writeEGRIDFile( const NNC& nnc ) const {
                                               ECL_EGRID_FILE,
                                               ioConfig.getFMTOUT() ));
 
-    {
-        int idx = 0;
-        auto* ecl_grid = const_cast< ecl_grid_type* >( this->grid.c_ptr() );
-        for (const NNCdata& n : nnc.nncdata())
-            ecl_grid_add_self_nnc( ecl_grid, n.cell1, n.cell2, idx++);
+    EGridIO::save( egridFile,
+                   this->grid,
+                   nnc,
+                   this->es.getDeckUnitSystem().getEclType(),
+                   ioConfig.getFMTOUT() );
 
-        ecl_grid_fwrite_EGRID2(ecl_grid, egridFile.c_str(), this->es.getDeckUnitSystem().getEclType() );
-    }
+    struct stat file_info;
+    if( ::stat( egridFile.c_str(), &file_info ) == 0 )
+        out::statistics::add_bytes( out::statistics::phase::egrid_write, file_info.st_size );
 }
 
 /*
@@ -385,20 +612,36 @@ int_data: Writes key(string) and integers vector to INIT file as eclipse keyword
 - Key: Max 8 chars.   
 - Wrong input: invalid_argument exception.                                   
 */
-void EclipseIO::writeInitial( data::Solution simProps, std::map<std::string, std::vector<int> > int_data, const NNC& nnc) {
+void EclipseIO::writeInitial( const data::Solution& simProps, const std::map<std::string, std::vector<int> >& int_data, const NNC& nnc) {
     if( !this->impl->output_enabled )
         return;
 
+    this->impl->flush();
     {
         const auto& es = this->impl->es;
         const IOConfig& ioConfig = es.cfg().io();
 
-        simProps.convertFromSI( es.getUnits() );
-        if( ioConfig.getWriteINITFile() )
-            this->impl->writeINITFile( simProps , int_data, nnc );
+        /*
+          Neither writer modifies the grid, so the EGRID file is
+          written on a separate thread while the INIT file is written.
+        */
+        std::future< void > egrid;
+        if( ioConfig.getWriteEGRIDFile( ) ) {
+            const auto& impl = *this->impl;
+            egrid = std::async( std::launch::async, [&impl, &nnc]() { impl.writeEGRIDFile( nnc ); } );
+        }
+
+        if( ioConfig.getWriteINITFile() ) {
+            try {
+                this->impl->writeINITFile( simProps , int_data, nnc );
+            } catch( ... ) {
+                if( egrid.valid() ) egrid.wait();
+                throw;
+            }
+        }
 
-        if( ioConfig.getWriteEGRIDFile( ) )
-            this->impl->writeEGRIDFile( nnc );
+        if( egrid.valid() )
+            egrid.get();
     }
 
     this->impl->summary.set_initial( simProps );
@@ -407,45 +650,40 @@ void EclipseIO::writeInitial( data::Solution simProps, std::map<std::string, std
 
 void  EclipseIO::overwriteInitialOIP( const data::Solution& simProps )
 {
+    this->impl->flush();
     this->impl->summary.set_initial( simProps );
 }
 
 // implementation of the writeTimeStep method
-void EclipseIO::writeTimeStep(int report_step,
-                              bool  isSubstep,
-                              double secs_elapsed,
-                              data::Solution cells,
-                              data::Wells wells,
-                              std::map<std::string, double> misc_summary_values,
-                              std::map<std::string, std::vector<double>> extra_restart,
-			      bool write_double)
+void EclipseIO::Impl::writeTimeStep(int report_step,
+                                    bool  isSubstep,
+                                    double secs_elapsed,
+                                    const data::Solution& cells,
+                                    const data::IndexedWells& wells,
+                                    const std::map<std::string, double>& misc_summary_values,
+                                    const std::map<std::string, std::vector<double>>& extra_restart,
+                                    bool write_double)
  {
-
-    if( !this->impl->output_enabled )
-        return;
-
-
-    const auto& es = this->impl->es;
-    const auto& grid = this->impl->grid;
-    const auto& schedule = this->impl->schedule;
-    const auto& units = es.getUnits();
-    const auto& ioConfig = es.getIOConfig();
-    const auto& restart = es.cfg().restart();
+    const auto& units = this->es.getUnits();
+    const auto& ioConfig = this->es.getIOConfig();
+    const auto& restart = this->es.cfg().restart();
 
 
 
     /*
-      Summary data is written unconditionally for every timestep.
+      Summary data is written unconditionally for every timestep. The
+      wells are indexed once by the caller and shared by the summary
+      and the restart output.
     */
     {
-        this->impl->summary.add_timestep( report_step,
-                                          secs_elapsed,
-                                          es,
-                                          schedule,
-                                          wells ,
-                                          cells ,
-                                          misc_summary_values );
-        this->impl->summary.write();
+        this->summary.add_timestep( report_step,
+                                    secs_elapsed,
+                                    this->es,
+                                    this->schedule,
+                                    wells ,
+                                    cells ,
+                                    misc_summary_values );
+        this->summary.write();
     }
 
 
@@ -456,13 +694,29 @@ void EclipseIO::writeTimeStep(int report_step,
     */
     if(!isSubstep && restart.getWriteRestartFile(report_step))
     {
-        std::string filename = ERT::EclFilename( this->impl->outputDir,
-                                                 this->impl->baseName,
+        std::string filename = ERT::EclFilename( this->outputDir,
+                                                 this->baseName,
                                                  ioConfig.getUNIFOUT() ? ECL_UNIFIED_RESTART_FILE : ECL_RESTART_FILE,
                                                  report_step,
                                                  ioConfig.getFMTOUT() );
 
-        RestartIO::save( filename , report_step, secs_elapsed, cells, wells, es , grid , schedule, extra_restart , write_double);
+        RestartIO::save( filename , report_step, secs_elapsed, cells, wells, this->es , this->grid , this->schedule, extra_restart , write_double);
+
+        /*
+          Keep the sidecar index in step with the file. A unified file
+          is kept open by one IndexWriter for the run; the report step
+          which was just written replaces any earlier version of it.
+        */
+        if( !ioConfig.getFMTOUT() ) {
+            if( !ioConfig.getUNIFOUT() )
+                out::MappedEclFile::updateIndex( filename );
+            else {
+                if( !this->restart_index || this->restart_index->filename() != filename )
+                    this->restart_index.reset( new out::MappedEclFile::IndexWriter( filename ));
+
+                this->restart_index->update( report_step );
+            }
+        }
     }
 
 
@@ -473,24 +727,180 @@ void EclipseIO::writeTimeStep(int report_step,
         return;
 
     {
-        std::vector<const Well*> sched_wells = this->impl->schedule.getWells( report_step );
+        std::vector<const Well*> sched_wells = this->schedule.getWells( report_step );
         const auto rft_active = [report_step] (const Well* w) { return w->getRFTActive( report_step ) || w->getPLTActive( report_step ); };
         if (std::any_of(sched_wells.begin(), sched_wells.end(), rft_active)) {
-            this->impl->rft.writeTimeStep( sched_wells,
-                                           grid,
-                                           report_step,
-                                           secs_elapsed + this->impl->schedule.posixStartTime(),
-                                           units.from_si( UnitSystem::measure::time, secs_elapsed ),
-                                           units,
-                                           cells );
+            this->rft.writeTimeStep( sched_wells,
+                                     this->grid,
+                                     report_step,
+                                     secs_elapsed + this->schedule.posixStartTime(),
+                                     units.from_si( UnitSystem::measure::time, secs_elapsed ),
+                                     units,
+                                     cells );
         }
     }
 
  }
 
 
+void EclipseIO::Impl::flush() {
+    if (this->output_queue)
+        this->output_queue->wait();
+}
+
+
+void EclipseIO::writeTimeStep(int report_step,
+                              bool  isSubstep,
+                              double secs_elapsed,
+                              const data::Solution& cells,
+                              const data::Wells& wells,
+                              const std::map<std::string, double>& misc_summary_values,
+                              const std::map<std::string, std::vector<double>>& extra_restart,
+			      bool write_double)
+ {
+
+    if( !this->impl->output_enabled )
+        return;
+
+    if (!this->impl->output_queue) {
+        this->impl->writeTimeStep( report_step, isSubstep, secs_elapsed, cells, data::IndexedWells( wells ), misc_summary_values, extra_restart, write_double );
+        return;
+    }
+
+    /*
+      The writer thread needs a snapshot of the time step data which
+      the caller can not modify. The snapshot is copied into a buffer
+      from the staging area, which is reused once the writer thread
+      is done with it.
+    */
+    auto step = this->impl->staging->stage( cells, wells, misc_summary_values, extra_restart );
+    this->impl->push( report_step, isSubstep, secs_elapsed, std::move( step ), write_double );
+ }
+
+
+void EclipseIO::writeTimeStep(int report_step,
+                              bool  isSubstep,
+                              double secs_elapsed,
+                              const data::Solution& cells,
+                              const data::IndexedWells& wells,
+                              const std::map<std::string, double>& misc_summary_values,
+                              const std::map<std::string, std::vector<double>>& extra_restart,
+			      bool write_double)
+ {
+
+    if( !this->impl->output_enabled )
+        return;
+
+    if (!this->impl->output_queue) {
+        this->impl->writeTimeStep( report_step, isSubstep, secs_elapsed, cells, wells, misc_summary_values, extra_restart, write_double );
+        return;
+    }
+
+    auto step = this->impl->staging->stage( cells, wells, misc_summary_values, extra_restart );
+    this->impl->push( report_step, isSubstep, secs_elapsed, std::move( step ), write_double );
+ }
+
+
+void EclipseIO::writeTimeStep(int report_step,
+                              bool  isSubstep,
+                              double secs_elapsed,
+                              data::Solution&& cells,
+                              data::Wells&& wells,
+                              const std::map<std::string, double>& misc_summary_values,
+                              const std::map<std::string, std::vector<double>>& extra_restart,
+			      bool write_double)
+ {
+
+    if( !this->impl->output_enabled )
+        return;
+
+    if (!this->impl->output_queue) {
+        this->impl->writeTimeStep( report_step, isSubstep, secs_elapsed, cells, data::IndexedWells( wells ), misc_summary_values, extra_restart, write_double );
+        return;
+    }
+
+    /*
+      The moved data bypasses the staging area; the buffers in the
+      staging area are only used for the copies.
+    */
+    auto step = std::make_shared< out::StagedTimeStep >();
+    step->cells = std::move( cells );
+    step->wells = std::move( wells );
+    step->misc_summary_values = misc_summary_values;
+    step->extra_restart = extra_restart;
+
+    this->impl->push( report_step, isSubstep, secs_elapsed, std::move( step ), write_double );
+ }
+
+
+/*
+  The time step data is held by a shared_ptr in the task, that way the
+  task can be copied into the std::function in the queue without
+  copying the data. The output queue destroys the task as soon as it
+  has run, which releases a staged buffer for the next time step.
+  Wells staged as data::Wells are indexed on the writer thread.
+*/
+void EclipseIO::Impl::push( int report_step,
+                            bool isSubstep,
+                            double seconds_elapsed,
+                            out::StagingArea::handle step,
+                            bool write_double ) {
+    auto* impl_ptr = this;
+    this->output_queue->push( [=]() {
+            if( step->indexed )
+                impl_ptr->writeTimeStep( report_step,
+                                         isSubstep,
+                                         seconds_elapsed,
+                                         step->cells,
+                                         step->indexed_wells,
+                                         step->misc_summary_values,
+                                         step->extra_restart,
+                                         write_double );
+            else
+                impl_ptr->writeTimeStep( report_step,
+                                         isSubstep,
+                                         seconds_elapsed,
+                                         step->cells,
+                                         data::IndexedWells( step->wells ),
+                                         step->misc_summary_values,
+                                         step->extra_restart,
+                                         write_double );
+        });
+}
+
+
+void EclipseIO::enableAsyncOutput( size_t max_pending ) {
+    this->impl->flush();
+    this->impl->output_queue.reset( new out::OutputQueue( max_pending ));
+
+    /*
+      One buffer for each queued time step, and one for the time step
+      which is being written.
+    */
+    this->impl->staging.reset( new out::StagingArea( max_pending + 1 ));
+}
+
+
+void EclipseIO::flush() {
+    this->impl->flush();
+}
+
+
+void EclipseIO::setSummaryFlushPolicy( out::SummaryWriter::flush_policy policy ) {
+    this->impl->flush();
+    this->impl->summary.setFlushPolicy( policy );
+}
+
+void EclipseIO::setSummaryThreads( size_t num_threads ) {
+    this->impl->flush();
+    this->impl->summary.setEvaluationThreads( num_threads );
+}
+
+
 
 RestartValue EclipseIO::loadRestart(const std::map<std::string, RestartKey>& keys, const std::map<std::string, bool>& extra_keys) const {
+    this->impl->flush();
+
     const auto& es                       = this->impl->es;
     const auto& grid                     = this->impl->grid;
     const auto& schedule                 = this->impl->schedule;
@@ -32,9 +32,11 @@
 #include <opm/parser/eclipse/EclipseState/Grid/NNC.hpp>
 
 #include <opm/output/data/Cells.hpp>
+#include <opm/output/data/IndexedWells.hpp>
 #include <opm/output/data/Solution.hpp>
 #include <opm/output/data/Wells.hpp>
 #include <opm/output/eclipse/RestartValue.hpp>
+#include <opm/output/eclipse/SummaryWriter.hpp>
 
 namespace Opm {
 
@@ -107,7 +109,7 @@ public:
   *     are not yet written to disk.
   */
 
-    void writeInitial( data::Solution simProps = data::Solution(), std::map<std::string, std::vector<int> > int_data = {}, const NNC& nnc = NNC());
+    void writeInitial( const data::Solution& simProps = data::Solution(), const std::map<std::string, std::vector<int> >& int_data = {}, const NNC& nnc = NNC());
 
     /**
      * \brief Overwrite the initial OIP values.
@@ -173,10 +175,40 @@ public:
     void writeTimeStep( int report_step,
                         bool isSubstep,
                         double seconds_elapsed,
-                        data::Solution,
-                        data::Wells,
-                        std::map<std::string, double> misc_summary_values,
-                        std::map<std::string, std::vector<double>> extra_restart = {},
+                        const data::Solution&,
+                        const data::Wells&,
+                        const std::map<std::string, double>& misc_summary_values,
+                        const std::map<std::string, std::vector<double>>& extra_restart = {},
+			bool write_double = false);
+
+    /*
+      As above, but the solution and wells are moved into the output
+      layer. With synchronous output the two overloads are the same,
+      with asynchronous output this overload avoids the snapshot copy
+      of the solution and wells.
+    */
+    void writeTimeStep( int report_step,
+                        bool isSubstep,
+                        double seconds_elapsed,
+                        data::Solution&&,
+                        data::Wells&&,
+                        const std::map<std::string, double>& misc_summary_values,
+                        const std::map<std::string, std::vector<double>>& extra_restart = {},
+			bool write_double = false);
+
+    /*
+      As the first overload, with the wells already indexed. The
+      data::Wells overloads index the wells once per time step
+      themselves; a simulator which maintains a data::IndexedWells
+      instance can pass it directly and skip that conversion.
+    */
+    void writeTimeStep( int report_step,
+                        bool isSubstep,
+                        double seconds_elapsed,
+                        const data::Solution&,
+                        const data::IndexedWells&,
+                        const std::map<std::string, double>& misc_summary_values,
+                        const std::map<std::string, std::vector<double>>& extra_restart = {},
 			bool write_double = false);
 
 
@@ -221,6 +253,57 @@ public:
     RestartValue loadRestart(const std::map<std::string, RestartKey>& keys, const std::map<std::string, bool>& extra_keys = {}) const;
 
 
+    /*
+      By default writeTimeStep() does all the file output on the
+      calling thread. After a call to enableAsyncOutput() the output
+      from writeTimeStep() - i.e. summary evaluation and output,
+      restart files and RFT files - is instead done by a dedicated
+      writer thread, and writeTimeStep() will return as soon as the
+      time step has been queued. The writer thread works on a
+      snapshot of the solution and wells; pass them with std::move()
+      to hand them over without a copy.
+
+      The snapshots are copied into a fixed set of max_pending + 1
+      staging buffers, so while the writer thread serializes one
+      report step the next one is staged in another buffer. The
+      buffers are sized by the first time steps and reused, i.e. in
+      the steady state staging a time step does not allocate.
+
+      The max_pending argument is the number of time steps which can
+      be queued before writeTimeStep() blocks and waits for the
+      writer thread.
+
+      Errors from the writer thread are rethrown from the next call
+      to writeTimeStep() or flush(). The output from the time steps
+      queued after the failed one is discarded, and when the error is
+      rethrown from writeTimeStep() the time step passed to that call
+      is not written either. The flush() method will block until all
+      queued output has been written to disk; it is called implicitly
+      from writeInitial(), overwriteInitialOIP() and loadRestart().
+      An error in the writer thread which has not been seen by a call
+      to flush() can not be thrown when the EclipseIO object is
+      destroyed, it is only logged with OpmLog::error(); the simulator
+      should therefor call flush() at the end of the run.
+    */
+    void enableAsyncOutput( size_t max_pending = 1 );
+    void flush();
+
+    /*
+      The summary data file is kept open for the whole run, and a
+      time step is appended for every call to writeTimeStep(). The
+      flush policy decides whether the data is flushed, or also
+      synced to disk, after each time step; see SummaryWriter.
+    */
+    void setSummaryFlushPolicy( out::SummaryWriter::flush_policy policy );
+
+    /*
+      Evaluate the summary vectors on num_threads threads, the default
+      is serial evaluation. The summary results do not depend on the
+      number of threads.
+    */
+    void setSummaryThreads( size_t num_threads );
+
+
     EclipseIO( const EclipseIO& ) = delete;
     ~EclipseIO();
 
@@ -0,0 +1,180 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include <opm/output/eclipse/HydrocarbonPoreVolume.hpp>
+#include <opm/output/eclipse/Parallel.hpp>
+
+namespace Opm {
+namespace out {
+
+namespace {
+
+    const std::size_t partition_size = 1 << 18;
+
+    const double* cell_data( const data::Solution& state,
+                             const std::string& keyword,
+                             std::size_t size ) {
+        if( !state.has( keyword ) ) return nullptr;
+
+        const auto& data = state.data( keyword );
+        if( data.size() != size ) {
+            std::stringstream str;
+            str << "Wrongly sized data array passed to output for keyword "
+                << keyword << ", size=" << data.size() << ", expected=" << size << ".";
+            throw std::runtime_error( str.str() );
+        }
+
+        return data.data();
+    }
+
+    void hcpv_weights( const double* pv, const double* swat,
+                       std::size_t size, double* hcpv ) {
+        for( std::size_t i = 0; i < size; i++ )
+            hcpv[ i ] = pv[ i ] * ( 1.0 - swat[ i ] );
+    }
+
+    /*
+      Four independent partial sums, as in RatesTable, so that the
+      loops can be vectorized without changing the summation order.
+    */
+    double sum( const double* w, std::size_t size ) {
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        std::size_t i = 0;
+
+        for( ; i + 4 <= size; i += 4 ) {
+            s0 += w[ i ];
+            s1 += w[ i + 1 ];
+            s2 += w[ i + 2 ];
+            s3 += w[ i + 3 ];
+        }
+
+        for( ; i < size; i++ )
+            s0 += w[ i ];
+
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    /* sums[ 0 ] = sum( w * v ), sums[ 1 ] = sum( w ) */
+    void weighted_sum( const double* w, const double* v,
+                       std::size_t size, double* sums ) {
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        double t0 = 0, t1 = 0, t2 = 0, t3 = 0;
+        std::size_t i = 0;
+
+        for( ; i + 4 <= size; i += 4 ) {
+            s0 += w[ i ] * v[ i ];
+            s1 += w[ i + 1 ] * v[ i + 1 ];
+            s2 += w[ i + 2 ] * v[ i + 2 ];
+            s3 += w[ i + 3 ] * v[ i + 3 ];
+            t0 += w[ i ];
+            t1 += w[ i + 1 ];
+            t2 += w[ i + 2 ];
+            t3 += w[ i + 3 ];
+        }
+
+        for( ; i < size; i++ ) {
+            s0 += w[ i ] * v[ i ];
+            t0 += w[ i ];
+        }
+
+        sums[ 0 ] = (s0 + s1) + (s2 + s3);
+        sums[ 1 ] = (t0 + t1) + (t2 + t3);
+    }
+
+}
+
+
+void HydrocarbonPoreVolume::update( const std::vector< double >& pv,
+                                    const data::Solution& state ) {
+    this->num_cells = pv.size();
+    const auto* swat = cell_data( state, "SWAT", this->num_cells );
+    const auto* pressure = cell_data( state, "PRESSURE", this->num_cells );
+
+    double* weights = nullptr;
+    if( swat ) {
+        this->buffer.resize( this->num_cells );
+        weights = this->buffer.data();
+        this->hcpv = weights;
+    } else {
+        this->hcpv = pv.data();
+    }
+
+    const auto num_partitions = ( this->num_cells + partition_size - 1 ) / partition_size;
+    this->partial.assign( 2 * num_partitions, 0.0 );
+    const auto nt = std::min( num_partitions, parallel::num_threads( this->num_cells, partition_size ));
+
+    parallel::run( nt, [&]( std::size_t t ) {
+        for( auto p = t; p < num_partitions; p += nt ) {
+            const auto begin = p * partition_size;
+            const auto size = std::min( partition_size, this->num_cells - begin );
+            auto* sums = this->partial.data() + 2 * p;
+
+            if( swat )
+                hcpv_weights( pv.data() + begin, swat + begin, size, weights + begin );
+
+            if( pressure )
+                weighted_sum( this->hcpv + begin, pressure + begin, size, sums );
+            else
+                sums[ 1 ] = sum( this->hcpv + begin, size );
+        }
+    });
+
+    this->has_pressure = pressure != nullptr;
+    this->sum_weighted = 0.0;
+    this->sum_hcpv = 0.0;
+    for( std::size_t p = 0; p < num_partitions; p++ ) {
+        this->sum_weighted += this->partial[ 2 * p ];
+        this->sum_hcpv += this->partial[ 2 * p + 1 ];
+    }
+}
+
+
+std::size_t HydrocarbonPoreVolume::size() const {
+    return this->num_cells;
+}
+
+
+const double* HydrocarbonPoreVolume::weights() const {
+    return this->hcpv;
+}
+
+
+double HydrocarbonPoreVolume::total() const {
+    return this->sum_hcpv;
+}
+
+
+bool HydrocarbonPoreVolume::hasPressure() const {
+    return this->has_pressure;
+}
+
+
+double HydrocarbonPoreVolume::pressure() const {
+    if( !this->has_pressure ) return 0.0;
+
+    return this->sum_weighted / this->sum_hcpv;
+}
+
+}
+}
@@ -0,0 +1,92 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_HYDROCARBON_PORE_VOLUME_HPP
+#define OPM_OUTPUT_HYDROCARBON_PORE_VOLUME_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <opm/output/data/Solution.hpp>
+
+namespace Opm {
+namespace out {
+
+    /*
+      The HydrocarbonPoreVolume class holds the hydrocarbon pore volume
+      weights
+
+          hcpv = pv * (1 - SWAT)
+
+      of the active cells for one time step, together with the field
+      wide sums of hcpv * PRESSURE and hcpv. The weights are evaluated
+      once in update() and shared by all the pressure averages of the
+      time step: the field average FPR is read off directly and the
+      region averages in RegionReduction use weights().
+
+      When the solution has no SWAT the weights are the pore volumes
+      themselves, and weights() points into pv without any copying; pv
+      must then outlive the time step. The buffer for the weights is
+      kept between the time steps, so after the first update() there is
+      no allocation.
+
+      The cells are processed in fixed size partitions distributed over
+      threads, with four independent partial sums in each partition,
+      and the partition sums are added in partition order. The results
+      therefore do not depend on the number of threads.
+    */
+
+    class HydrocarbonPoreVolume {
+    public:
+        /*
+          Evaluate the weights and the field sums. Throws
+          std::runtime_error if SWAT or PRESSURE does not have one value
+          per element of pv.
+        */
+        void update( const std::vector< double >& pv, const data::Solution& state );
+
+        std::size_t size() const;
+        const double* weights() const;
+
+        /// Sum of the weights of all the active cells.
+        double total() const;
+
+        /// true if the last update() had PRESSURE in the solution.
+        bool hasPressure() const;
+
+        /// Field hydrocarbon pore volume weighted average pressure.
+        double pressure() const;
+
+    private:
+        std::size_t num_cells = 0;
+        const double* hcpv = nullptr;
+        std::vector< double > buffer;
+
+        /* sum of hcpv * pressure and hcpv for each partition */
+        std::vector< double > partial;
+
+        bool has_pressure = false;
+        double sum_weighted = 0.0;
+        double sum_hcpv = 0.0;
+    };
+
+}
+}
+
+#endif //OPM_OUTPUT_HYDROCARBON_PORE_VOLUME_HPP
@@ -0,0 +1,644 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <opm/output/eclipse/MappedEclFile.hpp>
+
+namespace Opm {
+namespace out {
+
+namespace {
+
+    /*
+      An unformatted keyword is a 16 byte header record - name, count
+      and type - followed by the data in records of at most 1000
+      numeric or 105 character elements. Every record is enclosed in
+      four byte big endian length markers.
+    */
+    const std::size_t header_size = 4 + 8 + 4 + 4 + 4;
+    const std::size_t marker_size = 4;
+
+    inline std::uint32_t load_be32( const char* ptr ) {
+        const auto* p = reinterpret_cast< const unsigned char* >( ptr );
+        return (std::uint32_t( p[0] ) << 24) | (std::uint32_t( p[1] ) << 16)
+             | (std::uint32_t( p[2] ) << 8)  |  std::uint32_t( p[3] );
+    }
+
+    inline std::uint64_t load_be64( const char* ptr ) {
+        return (std::uint64_t( load_be32( ptr ) ) << 32) | load_be32( ptr + 4 );
+    }
+
+    inline void store_be32( std::uint32_t value, char* ptr ) {
+        for( int i = 3; i >= 0; i-- ) {
+            ptr[ i ] = static_cast< char >( value & 0xFF );
+            value >>= 8;
+        }
+    }
+
+    inline void store_be64( std::uint64_t value, char* ptr ) {
+        store_be32( static_cast< std::uint32_t >( value >> 32 ), ptr );
+        store_be32( static_cast< std::uint32_t >( value ), ptr + 4 );
+    }
+
+    inline int decode_int( const char* ptr ) {
+        const auto bits = load_be32( ptr );
+        int value;
+        std::memcpy( &value, &bits, sizeof value );
+        return value;
+    }
+
+    inline float decode_float( const char* ptr ) {
+        const auto bits = load_be32( ptr );
+        float value;
+        std::memcpy( &value, &bits, sizeof value );
+        return value;
+    }
+
+    inline double decode_double( const char* ptr ) {
+        const auto bits = load_be64( ptr );
+        double value;
+        std::memcpy( &value, &bits, sizeof value );
+        return value;
+    }
+
+    struct layout {
+        std::size_t element_size;
+        std::size_t block_size;
+    };
+
+    layout type_layout( const std::string& type ) {
+        if( type == "INTE" || type == "REAL" || type == "LOGI" ) return { 4, 1000 };
+        if( type == "DOUB" ) return { 8, 1000 };
+        if( type == "CHAR" ) return { 8, 105 };
+        if( type == "MESS" ) return { 0, 1 };
+        if( type.size() == 4 && type[0] == 'C' ) {
+            const auto length = std::atoi( type.c_str() + 1 );
+            if( length > 0 ) return { std::size_t( length ), 105 };
+        }
+
+        throw std::runtime_error( "Unknown ECLIPSE keyword type: '" + type + "'" );
+    }
+
+    std::size_t data_size( std::size_t count, const layout& l ) {
+        if( count == 0 || l.element_size == 0 ) return 0;
+
+        const auto blocks = (count + l.block_size - 1) / l.block_size;
+        return count * l.element_size + 2 * marker_size * blocks;
+    }
+
+    std::string trim( const char* ptr, std::size_t length ) {
+        std::string s( ptr, length );
+        const auto end = s.find_last_not_of( ' ' );
+        return end == std::string::npos ? std::string() : s.substr( 0, end + 1 );
+    }
+
+    /*
+      The sidecar index is the magic string followed by one fixed size
+      big endian entry per keyword: report step (int32), name (char[8]),
+      type (char[4]), count (uint64) and offset (uint64).
+    */
+    const char index_magic[ 8 ] = { 'O', 'P', 'M', 'I', 'D', 'X', '0', '1' };
+    const std::size_t index_entry_size = 4 + 8 + 4 + 8 + 8;
+
+    /*
+      Decode the keyword header at ptr into kw. Returns an error message
+      if the header is malformed, and nullptr otherwise.
+    */
+    const char* decode_header( const char* ptr, MappedEclFile::keyword& kw ) {
+        if( load_be32( ptr ) != 16 || load_be32( ptr + header_size - marker_size ) != 16 )
+            return "invalid keyword header";
+
+        const int count = decode_int( ptr + 12 );
+        if( count < 0 )
+            return "negative element count";
+
+        kw.name = trim( ptr + 4, 8 );
+        kw.type = std::string( ptr + 16, 4 );
+        kw.count = count;
+        return nullptr;
+    }
+
+    /*
+      The report step of the keyword kw with header at ptr, following a
+      keyword in report step current_step. The SEQNUM value is read
+      from the first data record, so for SEQNUM the data must be
+      available.
+    */
+    int next_step( const MappedEclFile::keyword& kw, const char* ptr, int current_step ) {
+        if( kw.name == "SEQNUM" && kw.type == "INTE" && kw.count > 0 )
+            return decode_int( ptr + header_size + marker_size );
+
+        if( kw.name == "SEQHDR" )
+            return current_step + 1;
+
+        return current_step;
+    }
+
+    void encode_entry( const MappedEclFile::keyword& kw, char* buffer ) {
+        std::memset( buffer + 4, ' ', 12 );
+        store_be32( static_cast< std::uint32_t >( kw.report_step ), buffer );
+        std::memcpy( buffer + 4, kw.name.data(), std::min< std::size_t >( kw.name.size(), 8 ) );
+        std::memcpy( buffer + 12, kw.type.data(), std::min< std::size_t >( kw.type.size(), 4 ) );
+        store_be64( kw.count, buffer + 16 );
+        store_be64( kw.offset, buffer + 24 );
+    }
+
+    template< typename T >
+    struct decoder;
+
+    template<> struct decoder< int > {
+        static bool accepts( const std::string& type ) { return type == "INTE" || type == "LOGI"; }
+        static int get( const char* ptr, bool ) { return decode_int( ptr ); }
+    };
+
+    template<> struct decoder< double > {
+        static bool accepts( const std::string& type ) { return type == "REAL" || type == "DOUB"; }
+        static double get( const char* ptr, bool is_double ) {
+            return is_double ? decode_double( ptr ) : decode_float( ptr );
+        }
+    };
+
+    template<> struct decoder< float > {
+        static bool accepts( const std::string& type ) { return type == "REAL" || type == "DOUB"; }
+        static float get( const char* ptr, bool is_double ) {
+            return is_double ? float( decode_double( ptr ) ) : decode_float( ptr );
+        }
+    };
+}
+
+
+MappedEclFile::MappedEclFile( const std::string& filename_arg ) :
+    filename( filename_arg )
+{
+    const int fd = ::open( this->filename.c_str(), O_RDONLY );
+    if( fd < 0 )
+        throw std::runtime_error( "Could not open file: " + this->filename );
+
+    struct stat st;
+    if( ::fstat( fd, &st ) != 0 ) {
+        ::close( fd );
+        throw std::runtime_error( "Could not stat file: " + this->filename );
+    }
+
+    this->file_size = st.st_size;
+    if( this->file_size > 0 ) {
+        void* ptr = ::mmap( nullptr, this->file_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( ptr == MAP_FAILED ) {
+            ::close( fd );
+            throw std::runtime_error( "Could not memory map file: " + this->filename );
+        }
+        this->data = static_cast< const char* >( ptr );
+    }
+
+    ::close( fd );
+    this->load_index();
+}
+
+
+MappedEclFile::~MappedEclFile() {
+    if( this->data )
+        ::munmap( const_cast< char* >( this->data ), this->file_size );
+}
+
+
+bool MappedEclFile::unformatted( const std::string& filename ) {
+    std::ifstream stream( filename, std::ios::binary );
+    char marker[ marker_size ];
+    if( !stream.read( marker, marker_size ) )
+        return false;
+
+    return load_be32( marker ) == header_size - 2 * marker_size;
+}
+
+
+std::string MappedEclFile::index_file( const std::string& filename ) {
+    return filename + ".idx";
+}
+
+
+void MappedEclFile::updateIndex( const std::string& filename ) {
+    MappedEclFile file( filename );
+    file.keywords();
+    file.write_index();
+}
+
+
+void MappedEclFile::updateIndex( const std::string& filename, int first_step ) {
+    MappedEclFile file( filename );
+    file.discard_from( first_step );
+    file.keywords();
+    file.write_index();
+}
+
+
+std::size_t MappedEclFile::size() const {
+    return this->file_size;
+}
+
+
+bool MappedEclFile::truncated() const {
+    return this->truncated_tail;
+}
+
+
+bool MappedEclFile::scan_next() {
+    if( this->scan_offset == this->file_size || this->truncated_tail )
+        return false;
+
+    const auto offset = this->scan_offset;
+    const char* ptr = this->data + offset;
+    const auto corrupt = [&]( const std::string& msg ) {
+        return std::runtime_error( "File " + this->filename + " is not a valid unformatted ECLIPSE file, "
+                                   + msg + " at offset " + std::to_string( offset ) );
+    };
+
+    if( offset + header_size > this->file_size ) {
+        this->truncated_tail = true;
+        return false;
+    }
+
+    keyword kw;
+    if( const char* error = decode_header( ptr, kw ))
+        throw corrupt( error );
+
+    kw.offset = offset;
+
+    const auto bytes = data_size( kw.count, type_layout( kw.type ) );
+    if( offset + header_size + bytes > this->file_size ) {
+        this->truncated_tail = true;
+        return false;
+    }
+
+    this->current_step = next_step( kw, ptr, this->current_step );
+    kw.report_step = this->current_step;
+    this->step_begin.emplace( kw.report_step, this->index.size() );
+    this->index.push_back( std::move( kw ) );
+    this->scan_offset = offset + header_size + bytes;
+    return true;
+}
+
+
+/*
+  Scan until the first keyword of a later report step has been seen,
+  or to the end of the file.
+*/
+void MappedEclFile::scan_until( int report_step ) {
+    while( this->current_step <= report_step && this->scan_next() )
+        ;
+}
+
+
+/*
+  Load the sidecar index. The entries are accepted as long as they
+  chain up - every keyword starts where the previous one ended - and
+  stay within the file. Finally the header of the last accepted keyword
+  is compared with the file; if it does not match the file has been
+  rewritten after the sidecar, and the last report step is dropped
+  until a matching header is found.
+*/
+void MappedEclFile::load_index() {
+    std::ifstream stream( index_file( this->filename ), std::ios::binary );
+    char magic[ sizeof index_magic ];
+    if( !stream.read( magic, sizeof magic )
+        || std::memcmp( magic, index_magic, sizeof magic ) != 0 )
+        return;
+
+    std::vector< keyword > entries;
+    std::size_t end = 0;
+    bool valid = true;
+    char buffer[ index_entry_size ];
+
+    while( stream.read( buffer, index_entry_size ) ) {
+        this->sidecar_entries++;
+        if( !valid ) continue;
+
+        keyword kw;
+        kw.report_step = decode_int( buffer );
+        kw.name = trim( buffer + 4, 8 );
+        kw.type = std::string( buffer + 12, 4 );
+        kw.count = load_be64( buffer + 16 );
+        kw.offset = load_be64( buffer + 24 );
+
+        std::size_t bytes;
+        try {
+            bytes = data_size( kw.count, type_layout( kw.type ) );
+        } catch( const std::runtime_error& ) {
+            valid = false;
+            continue;
+        }
+
+        if( kw.offset != end
+            || kw.offset + header_size + bytes > this->file_size
+            || ( !entries.empty() && kw.report_step < entries.back().report_step ) ) {
+            valid = false;
+            continue;
+        }
+
+        end = kw.offset + header_size + bytes;
+        entries.push_back( std::move( kw ) );
+    }
+
+    const auto matches = [this]( const keyword& kw ) {
+        const char* ptr = this->data + kw.offset;
+        return load_be32( ptr ) == 16
+            && load_be32( ptr + header_size - marker_size ) == 16
+            && trim( ptr + 4, 8 ) == kw.name
+            && std::string( ptr + 16, 4 ) == kw.type
+            && std::size_t( decode_int( ptr + 12 ) ) == kw.count;
+    };
+
+    while( !entries.empty() && !matches( entries.back() ) ) {
+        const auto step = entries.back().report_step;
+        while( !entries.empty() && entries.back().report_step == step )
+            entries.pop_back();
+    }
+
+    for( auto& kw : entries ) {
+        this->step_begin.emplace( kw.report_step, this->index.size() );
+        this->index.push_back( std::move( kw ) );
+    }
+
+    if( !this->index.empty() ) {
+        const auto& last = this->index.back();
+        this->scan_offset = last.offset + header_size
+                          + data_size( last.count, type_layout( last.type ) );
+        this->current_step = last.report_step;
+    }
+
+    this->sidecar_valid = this->index.size();
+}
+
+
+void MappedEclFile::discard_from( int report_step ) {
+    const auto begin = this->step_begin.lower_bound( report_step );
+    if( begin == this->step_begin.end() ) return;
+
+    const auto pos = begin->second;
+    this->scan_offset = this->index[ pos ].offset;
+    this->step_begin.erase( begin, this->step_begin.end() );
+    this->index.erase( this->index.begin() + pos, this->index.end() );
+    this->current_step = this->index.empty() ? -1 : this->index.back().report_step;
+    this->truncated_tail = false;
+    this->sidecar_valid = std::min( this->sidecar_valid, pos );
+}
+
+
+/*
+  Write the index to the sidecar. When the sidecar on disk is a valid
+  prefix of the index only the new entries are appended, otherwise it
+  is rewritten.
+*/
+void MappedEclFile::write_index() const {
+    const bool append = this->sidecar_entries > 0
+                     && this->sidecar_valid == this->sidecar_entries;
+    const auto mode = std::ios::binary | std::ios::out
+                    | ( append ? std::ios::app : std::ios::trunc );
+
+    std::ofstream stream( index_file( this->filename ), mode );
+    if( !stream ) return;
+
+    if( !append )
+        stream.write( index_magic, sizeof index_magic );
+
+    char buffer[ index_entry_size ];
+    for( auto i = append ? this->sidecar_entries : 0; i < this->index.size(); i++ ) {
+        encode_entry( this->index[ i ], buffer );
+        stream.write( buffer, index_entry_size );
+    }
+}
+
+
+MappedEclFile::IndexWriter::IndexWriter( const std::string& filename_arg ) :
+    data_file( filename_arg )
+{
+    this->load();
+}
+
+
+/*
+  Load the sidecar through a MappedEclFile, which validates it against
+  the data file, and write it back if it was not a valid prefix of the
+  index. The keywords beyond the end of the sidecar are left for
+  update().
+*/
+void MappedEclFile::IndexWriter::load() {
+    this->sidecar.close();
+    this->step_begin.clear();
+    this->num_entries = 0;
+    this->end_offset = 0;
+    this->current_step = -1;
+
+    {
+        MappedEclFile file( this->data_file );
+        file.write_index();
+
+        for( const auto& kw : file.index )
+            this->step_begin.emplace( kw.report_step, step_start{ this->num_entries++, kw.offset } );
+
+        this->end_offset = file.scan_offset;
+        this->current_step = file.current_step;
+    }
+
+    this->sidecar.open( index_file( this->data_file ), std::ios::binary | std::ios::out | std::ios::app );
+}
+
+
+const std::string& MappedEclFile::IndexWriter::filename() const {
+    return this->data_file;
+}
+
+
+/*
+  Only the keyword headers are read, at most the header and the first
+  element of each new keyword. A keyword which is cut short by the end
+  of the file, or a malformed header, ends the update; the next update
+  continues from the same place.
+*/
+void MappedEclFile::IndexWriter::update() {
+    std::ifstream stream( this->data_file, std::ios::binary | std::ios::ate );
+    if( !stream ) return;
+
+    const std::size_t size = stream.tellg();
+    if( size < this->end_offset ) {
+        this->load();
+        return;
+    }
+
+    char header[ header_size + 2 * marker_size ];
+    char buffer[ index_entry_size ];
+
+    while( this->end_offset + header_size <= size ) {
+        const auto length = std::min( sizeof header, size - this->end_offset );
+        stream.seekg( this->end_offset );
+        if( !stream.read( header, length ) )
+            break;
+
+        keyword kw;
+        if( decode_header( header, kw ) )
+            break;
+
+        std::size_t bytes;
+        try {
+            bytes = data_size( kw.count, type_layout( kw.type ) );
+        } catch( const std::runtime_error& ) {
+            break;
+        }
+
+        if( this->end_offset + header_size + bytes > size )
+            break;
+
+        this->current_step = next_step( kw, header, this->current_step );
+        kw.report_step = this->current_step;
+        kw.offset = this->end_offset;
+
+        this->step_begin.emplace( kw.report_step, step_start{ this->num_entries, kw.offset } );
+        encode_entry( kw, buffer );
+        this->sidecar.write( buffer, index_entry_size );
+
+        this->num_entries++;
+        this->end_offset += header_size + bytes;
+    }
+
+    this->sidecar.flush();
+}
+
+
+void MappedEclFile::IndexWriter::update( int first_step ) {
+    const auto begin = this->step_begin.lower_bound( first_step );
+    if( begin != this->step_begin.end() ) {
+        this->num_entries = begin->second.entry;
+        this->end_offset = begin->second.offset;
+        this->step_begin.erase( begin, this->step_begin.end() );
+        this->current_step = this->step_begin.empty() ? -1 : this->step_begin.rbegin()->first;
+
+        const auto sidecar_file = index_file( this->data_file );
+        this->sidecar.close();
+        if( ::truncate( sidecar_file.c_str(), sizeof index_magic + this->num_entries * index_entry_size ) == 0 )
+            this->sidecar.open( sidecar_file, std::ios::binary | std::ios::out | std::ios::app );
+        else {
+            std::remove( sidecar_file.c_str() );
+            this->load();
+        }
+    }
+
+    this->update();
+}
+
+
+const std::vector< MappedEclFile::keyword >& MappedEclFile::keywords() {
+    while( this->scan_next() )
+        ;
+
+    return this->index;
+}
+
+
+bool MappedEclFile::hasReportStep( int report_step ) {
+    this->scan_until( report_step );
+    return this->step_begin.count( report_step ) > 0;
+}
+
+
+const MappedEclFile::keyword* MappedEclFile::find( int report_step, const std::string& name ) {
+    this->scan_until( report_step );
+
+    const auto begin = this->step_begin.find( report_step );
+    if( begin == this->step_begin.end() )
+        return nullptr;
+
+    for( auto i = begin->second; i < this->index.size(); i++ ) {
+        const auto& kw = this->index[ i ];
+        if( kw.report_step != report_step ) break;
+        if( kw.name == name ) return &kw;
+    }
+
+    return nullptr;
+}
+
+
+template< typename T >
+void MappedEclFile::read_numeric( const keyword& kw, T* buffer ) const {
+    if( !decoder< T >::accepts( kw.type ) )
+        throw std::invalid_argument( "Keyword " + kw.name + " of type " + kw.type
+                                     + " can not be read into the requested buffer type" );
+
+    const auto l = type_layout( kw.type );
+    const bool is_double = kw.type == "DOUB";
+    const char* ptr = this->data + kw.offset + header_size;
+    auto remaining = kw.count;
+
+    while( remaining > 0 ) {
+        const auto n = std::min( remaining, l.block_size );
+        if( load_be32( ptr ) != n * l.element_size )
+            throw std::runtime_error( "Invalid record length in keyword " + kw.name
+                                      + " in file " + this->filename );
+
+        ptr += marker_size;
+        for( std::size_t i = 0; i < n; i++ )
+            buffer[ i ] = decoder< T >::get( ptr + i * l.element_size, is_double );
+
+        ptr += n * l.element_size + marker_size;
+        buffer += n;
+        remaining -= n;
+    }
+}
+
+
+void MappedEclFile::read( const keyword& kw, double* buffer ) const {
+    this->read_numeric( kw, buffer );
+}
+
+
+void MappedEclFile::read( const keyword& kw, float* buffer ) const {
+    this->read_numeric( kw, buffer );
+}
+
+
+void MappedEclFile::read( const keyword& kw, int* buffer ) const {
+    this->read_numeric( kw, buffer );
+}
+
+
+std::vector< double > MappedEclFile::read_double( const keyword& kw ) const {
+    std::vector< double > values( kw.count );
+    this->read( kw, values.data() );
+    return values;
+}
+
+
+std::vector< int > MappedEclFile::read_int( const keyword& kw ) const {
+    std::vector< int > values( kw.count );
+    this->read( kw, values.data() );
+    return values;
+}
+
+}
+}
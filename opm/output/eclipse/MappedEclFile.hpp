@@ -0,0 +1,198 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_MAPPED_ECL_FILE_HPP
+#define OPM_MAPPED_ECL_FILE_HPP
+
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Opm {
+namespace out {
+
+    /*
+      The MappedEclFile class is a read only view of an unformatted
+      (binary) ECLIPSE file like UNRST, X0010 or UNSMRY. The file is
+      memory mapped, and an index of the keywords - name, type, number
+      of elements and byte offset - is built by reading only the 24
+      byte keyword headers; the position of the next header follows
+      from the element count and type, so the data pages are never
+      touched while indexing.
+
+      The index is built lazily: asking for a report step only scans
+      the file up to and including that report step. In unified files
+      the report steps are delimited with the SEQNUM keyword, the
+      keywords in front of the first SEQNUM - i.e. all the keywords
+      in a non unified file - are given report step -1.
+
+      A keyword which is cut short by the end of the file - e.g. from a
+      simulation which was killed while writing - ends the index, and
+      truncated() returns true when that has been seen. A malformed
+      keyword header raises std::runtime_error.
+
+      The read() methods decode one keyword, converting from the big
+      endian file representation, directly into a buffer provided by
+      the caller. The buffer must have room for keyword::count
+      elements.
+
+      The index can be stored in a sidecar file next to the data file,
+      see index_file(). The writers keep an IndexWriter for the file
+      and update it after each report step, so the sidecar grows along
+      with the file. When a
+      MappedEclFile is created the sidecar is loaded, and scanning of
+      the data file starts where the sidecar ends; looking up a report
+      step in a file with a current sidecar therefore does not touch
+      the data file at all. The sidecar is only a cache: entries which
+      do not chain up, point beyond the end of the data file or do not
+      match the keyword header at the end of the loaded index are
+      discarded, and the missing part of the index is built by
+      scanning the file as before.
+
+      In UNSMRY files there is no SEQNUM keyword, the report steps are
+      numbered by counting the SEQHDR keywords, starting at zero.
+    */
+
+    class MappedEclFile {
+    public:
+        struct keyword {
+            std::string name;
+            std::string type;      // INTE, REAL, DOUB, LOGI, CHAR or MESS
+            std::size_t count;
+            std::size_t offset;    // byte offset of the keyword header
+            int report_step;
+        };
+
+        explicit MappedEclFile( const std::string& filename );
+        ~MappedEclFile();
+
+        MappedEclFile( const MappedEclFile& ) = delete;
+        MappedEclFile& operator=( const MappedEclFile& ) = delete;
+
+        /// true if the file exists and starts with an unformatted
+        /// ECLIPSE keyword header.
+        static bool unformatted( const std::string& filename );
+
+        /// The name of the sidecar index file of filename.
+        static std::string index_file( const std::string& filename );
+
+        /// Bring the sidecar index of filename up to date with the
+        /// file. The entries for report steps from first_step and out
+        /// are discarded and rebuilt, this should be used when a report
+        /// step has been rewritten. Failure to write the sidecar is
+        /// ignored, it will be rebuilt by the next update. This loads
+        /// the whole sidecar; a writer which updates the index after
+        /// every report step should use an IndexWriter instead.
+        static void updateIndex( const std::string& filename );
+        static void updateIndex( const std::string& filename, int first_step );
+
+        /*
+          The IndexWriter keeps the sidecar index of a file which is
+          being written open for the life of the output file. The
+          existing sidecar is loaded - and validated as above - once,
+          when the IndexWriter is created, i.e. when a restarted run
+          continues the file. After that the writer only remembers
+          where the indexed part of the data file ends and where each
+          report step starts; update() reads the headers of the
+          keywords which have been appended since the previous update
+          and appends their entries to the sidecar, so the cost of an
+          update does not grow with the length of the file.
+
+          update( first_step ) is for files where report steps are
+          rewritten: the entries from first_step and out are cut from
+          the sidecar before the new keywords are indexed. If the data
+          file has shrunk behind the writer's back the index is built
+          again from the start. As for updateIndex() failure to write
+          the sidecar is ignored.
+        */
+        class IndexWriter {
+        public:
+            explicit IndexWriter( const std::string& filename );
+
+            void update();
+            void update( int first_step );
+
+            const std::string& filename() const;
+
+        private:
+            struct step_start {
+                std::size_t entry;
+                std::size_t offset;
+            };
+
+            void load();
+
+            std::string data_file;
+            std::ofstream sidecar;
+            std::map< int, step_start > step_begin;
+            std::size_t num_entries = 0;
+            std::size_t end_offset = 0;
+            int current_step = -1;
+        };
+
+        std::size_t size() const;
+        bool truncated() const;
+
+        /// All the keywords in the file; scans the whole file.
+        const std::vector< keyword >& keywords();
+
+        bool hasReportStep( int report_step );
+
+        /// The first keyword with the given name in report_step, or
+        /// nullptr if there is no such keyword.
+        const keyword* find( int report_step, const std::string& name );
+
+        void read( const keyword& kw, double* buffer ) const;
+        void read( const keyword& kw, float* buffer ) const;
+        void read( const keyword& kw, int* buffer ) const;
+
+        std::vector< double > read_double( const keyword& kw ) const;
+        std::vector< int > read_int( const keyword& kw ) const;
+
+    private:
+        bool scan_next();
+        void scan_until( int report_step );
+        void load_index();
+        void discard_from( int report_step );
+        void write_index() const;
+
+        template< typename T >
+        void read_numeric( const keyword& kw, T* buffer ) const;
+
+        std::string filename;
+        const char* data = nullptr;
+        std::size_t file_size = 0;
+
+        std::vector< keyword > index;
+        std::map< int, std::size_t > step_begin;
+        std::size_t scan_offset = 0;
+        int current_step = -1;
+        bool truncated_tail = false;
+
+        /* number of entries in the sidecar, and how many of them are valid */
+        std::size_t sidecar_entries = 0;
+        std::size_t sidecar_valid = 0;
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,146 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <opm/common/OpmLog/OpmLog.hpp>
+#include <opm/output/eclipse/OutputQueue.hpp>
+
+namespace Opm {
+namespace out {
+
+    OutputQueue::OutputQueue( std::size_t max_pending_arg ) :
+        max_pending( max_pending_arg )
+    {
+        if (this->max_pending == 0)
+            throw std::invalid_argument("The output queue must allow at least one pending task");
+
+        this->worker = std::thread( &OutputQueue::run, this );
+    }
+
+
+    OutputQueue::~OutputQueue() {
+        {
+            std::unique_lock< std::mutex > guard( this->lock );
+            this->task_done.wait( guard, [this] { return this->tasks.empty() && !this->busy; });
+            this->stop = true;
+        }
+        this->task_added.notify_one();
+        this->worker.join();
+
+        if (!this->error)
+            return;
+
+        try {
+            std::rethrow_exception( this->error );
+        } catch (const std::exception& e) {
+            OpmLog::error( std::string( "Output failed and the error was not reported before shutdown: " ) + e.what() );
+        } catch (...) {
+            OpmLog::error( "Output failed with an unknown error which was not reported before shutdown" );
+        }
+    }
+
+
+    void OutputQueue::push( task t ) {
+        {
+            std::unique_lock< std::mutex > guard( this->lock );
+            this->task_done.wait( guard, [this] { return this->tasks.size() < this->max_pending || this->error; });
+            this->rethrow();
+            this->tasks.push_back( std::move( t ));
+        }
+        this->task_added.notify_one();
+    }
+
+
+    void OutputQueue::wait() {
+        std::unique_lock< std::mutex > guard( this->lock );
+        this->task_done.wait( guard, [this] { return this->tasks.empty() && !this->busy; });
+        this->rethrow();
+    }
+
+
+    std::size_t OutputQueue::pending() const {
+        std::lock_guard< std::mutex > guard( this->lock );
+        return this->tasks.size() + (this->busy ? 1 : 0);
+    }
+
+
+    /*
+      Must be called with the lock held. The error is reset before it
+      is thrown, i.e. it is reported exactly once.
+    */
+    void OutputQueue::rethrow() {
+        if (this->error) {
+            auto e = this->error;
+            this->error = nullptr;
+            std::rethrow_exception( e );
+        }
+    }
+
+
+    void OutputQueue::run() {
+        while (true) {
+            task t;
+            {
+                std::unique_lock< std::mutex > guard( this->lock );
+                this->task_added.wait( guard, [this] { return this->stop || !this->tasks.empty(); });
+                if (this->tasks.empty())
+                    return;
+
+                t = std::move( this->tasks.front() );
+                this->tasks.pop_front();
+                this->busy = true;
+            }
+
+            std::exception_ptr task_error;
+            try {
+                t();
+            } catch (...) {
+                task_error = std::current_exception();
+            }
+
+            /*
+              Release the resources held by the task - e.g. a staged
+              time step buffer - before the task is reported as done.
+            */
+            t = nullptr;
+
+            {
+                std::lock_guard< std::mutex > guard( this->lock );
+                this->busy = false;
+                if (task_error) {
+                    if (!this->error)
+                        this->error = task_error;
+
+                    /*
+                      The output from the remaining tasks would
+                      typically depend on the failed task - e.g. the
+                      summary totals - so they are discarded.
+                    */
+                    this->tasks.clear();
+                }
+            }
+            this->task_done.notify_all();
+        }
+    }
+
+}
+}
@@ -0,0 +1,87 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_QUEUE_HPP
+#define OPM_OUTPUT_QUEUE_HPP
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace Opm {
+namespace out {
+
+    /*
+      The OutputQueue class is a small FIFO of output tasks which are
+      executed, in order, by one dedicated writer thread. The queue is
+      bounded; when max_pending tasks are already waiting the push()
+      method will block until the writer thread has caught up. That
+      way the memory held by the queued tasks - typically a full
+      data::Solution and data::Wells snapshot per task - stays bounded
+      even if the simulator is faster than the disk.
+
+      If a task throws, the exception is captured and the queue is
+      drained without running the remaining tasks; the exception is
+      then rethrown to the caller on the next call to push() or
+      wait(). When push() rethrows, the task passed to that call is
+      not queued. The destructor will wait for the pending tasks; a
+      failure which has not been reported by push() or wait() can not
+      be thrown from the destructor, it is logged as an error with
+      OpmLog instead. Call wait() explicitly before the queue goes out
+      of scope to handle the error.
+    */
+
+    class OutputQueue {
+    public:
+        using task = std::function< void() >;
+
+        explicit OutputQueue( std::size_t max_pending = 1 );
+        ~OutputQueue();
+
+        OutputQueue( const OutputQueue& ) = delete;
+        OutputQueue& operator=( const OutputQueue& ) = delete;
+
+        void push( task );
+        void wait();
+        std::size_t pending() const;
+
+    private:
+        void run();
+        void rethrow();
+
+        std::size_t max_pending;
+        std::deque< task > tasks;
+        bool busy = false;
+        bool stop = false;
+        std::exception_ptr error;
+
+        mutable std::mutex lock;
+        std::condition_variable task_added;
+        std::condition_variable task_done;
+        std::thread worker;
+    };
+
+}
+}
+
+#endif
@@ -0,0 +1,122 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <opm/output/eclipse/Parallel.hpp>
+
+namespace Opm {
+namespace out {
+namespace parallel {
+
+    pool& pool::instance() {
+        static pool workers;
+        return workers;
+    }
+
+
+    pool::~pool() {
+        {
+            std::lock_guard< std::mutex > guard( this->lock );
+            this->stopping = true;
+        }
+        this->queued.notify_all();
+
+        for( auto& worker : this->workers )
+            worker.join();
+    }
+
+
+    std::size_t pool::size() const {
+        std::lock_guard< std::mutex > guard( this->lock );
+        return this->workers.size();
+    }
+
+
+    /*
+      Called with the lock held. A thread which can not be created is
+      not an error, the work is shared by the threads there are.
+    */
+    void pool::start_workers( std::size_t count ) {
+        try {
+            while( this->workers.size() < count )
+                this->workers.emplace_back( &pool::work, this );
+        } catch( ... ) {}
+    }
+
+
+    /*
+      Run the task at the front of the queue; called with the lock held,
+      which is released while the task runs.
+    */
+    void pool::execute( std::unique_lock< std::mutex >& guard ) {
+        const auto t = this->tasks.front();
+        this->tasks.pop_front();
+
+        guard.unlock();
+        t.owner->call( t.owner->arg, t.index );
+        guard.lock();
+
+        if( --t.owner->pending == 0 )
+            this->finished.notify_all();
+    }
+
+
+    void pool::work() {
+        std::unique_lock< std::mutex > guard( this->lock );
+        while( true ) {
+            this->queued.wait( guard, [this] { return this->stopping || !this->tasks.empty(); });
+            if( this->tasks.empty() )
+                return;
+
+            this->execute( guard );
+        }
+    }
+
+
+    void pool::run( std::size_t n, void (*call)( void*, std::size_t ), void* arg ) {
+        batch b { call, arg, 0 };
+        std::size_t num_queued = 1;
+        {
+            std::lock_guard< std::mutex > guard( this->lock );
+            this->start_workers( n - 1 );
+
+            try {
+                for( ; num_queued < n; num_queued++ ) {
+                    this->tasks.push_back( { &b, num_queued } );
+                    b.pending++;
+                }
+            } catch( ... ) {}
+        }
+        this->queued.notify_all();
+
+        call( arg, 0 );
+        for( auto t = num_queued; t < n; t++ )
+            call( arg, t );
+
+        std::unique_lock< std::mutex > guard( this->lock );
+        while( b.pending > 0 ) {
+            if( this->tasks.empty() )
+                this->finished.wait( guard );
+            else
+                this->execute( guard );
+        }
+    }
+
+}
+}
+}
@@ -0,0 +1,121 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_PARALLEL_HPP
+#define OPM_OUTPUT_PARALLEL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Opm {
+namespace out {
+namespace parallel {
+
+    /*
+      Small helpers to split a loop over worker threads. The number of
+      threads is limited so that every thread gets at least
+      min_per_thread work items; below that the work is done serially
+      on the calling thread.
+    */
+
+    inline std::size_t num_threads( std::size_t size, std::size_t min_per_thread ) {
+        const std::size_t hw = std::max( 1U, std::thread::hardware_concurrency() );
+        return std::max< std::size_t >( 1, std::min( hw, size / std::max< std::size_t >( 1, min_per_thread ) ) );
+    }
+
+    /*
+      The pool of worker threads behind run(). The workers are created
+      when they are first needed and kept for the life of the program,
+      so a parallel loop costs a queue push and a wakeup per work item
+      instead of creating and joining a thread.
+
+      The calling thread takes part in the work: it runs item 0, and
+      while it waits for the rest of its items it runs queued items
+      itself. Several threads can therefore use the pool at the same
+      time, and run() can be called from inside a parallel loop
+      without waiting for workers which are all busy. If a worker
+      thread can not be created, or a work item can not be queued, the
+      items are run on the calling thread instead.
+    */
+    class pool {
+    public:
+        static pool& instance();
+
+        /// Call call( arg, t ) for t = 0, ..., n - 1 and wait for all
+        /// the calls to complete.
+        void run( std::size_t n, void (*call)( void*, std::size_t ), void* arg );
+
+        /// Number of worker threads which have been created.
+        std::size_t size() const;
+
+        pool( const pool& ) = delete;
+        pool& operator=( const pool& ) = delete;
+        ~pool();
+
+    private:
+        struct batch {
+            void (*call)( void*, std::size_t );
+            void* arg;
+            std::size_t pending;
+        };
+
+        struct task {
+            batch* owner;
+            std::size_t index;
+        };
+
+        pool() = default;
+        void start_workers( std::size_t count );
+        void work();
+        void execute( std::unique_lock< std::mutex >& guard );
+
+        mutable std::mutex lock;
+        std::condition_variable queued;
+        std::condition_variable finished;
+        std::deque< task > tasks;
+        std::vector< std::thread > workers;
+        bool stopping = false;
+    };
+
+    /*
+      Call f( 0 ), ..., f( n - 1 ) on n threads from the pool, f( 0 )
+      runs on the calling thread. The function must not throw.
+    */
+    template< typename F >
+    void run( std::size_t n, F f ) {
+        if( n <= 1 ) {
+            f( 0 );
+            return;
+        }
+
+        pool::instance().run( n, []( void* arg, std::size_t t ) {
+                (*static_cast< F* >( arg ))( t );
+            }, &f );
+    }
+
+}
+}
+}
+
+#endif //OPM_OUTPUT_PARALLEL_HPP
@@ -16,6 +16,9 @@
   You should have received a copy of the GNU General Public License
   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
  */
+#include <algorithm>
+#include <limits>
+
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/CompletionSet.hpp>
@@ -25,53 +28,215 @@
 #include <opm/parser/eclipse/EclipseState/Grid/GridProperty.hpp>
 #include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
 
+#include <opm/output/eclipse/Parallel.hpp>
 #include <opm/output/eclipse/RegionCache.hpp>
 
 namespace Opm {
 namespace out {
 
-    RegionCache::RegionCache(const Eclipse3DProperties& properties, const EclipseGrid& grid, const Schedule& schedule) {
-        const auto& fipnum = properties.getIntGridProperty("FIPNUM");
-        const auto& region_values = properties.getRegions( "FIPNUM" );
+namespace {
+
+    const std::size_t no_bin = std::numeric_limits< std::size_t >::max();
+
+    /* Below this number of cells per thread the grid is processed serially. */
+    const std::size_t min_cells_per_thread = 1 << 16;
+
+}
+
 
-        for (auto region_id : region_values)
-            this->cell_map.emplace( region_id , fipnum.cellsEqual( region_id , grid ));
+    std::size_t RegionCache::region_set::bin( int region_id ) const {
+        if( this->ids.empty() || region_id < this->min_id )
+            return no_bin;
 
+        const auto b = std::size_t( region_id - this->min_id );
+        return b + 1 < this->cell_offset.size() ? b : no_bin;
+    }
+
+
+    RegionCache::RegionCache(const Eclipse3DProperties& properties, const EclipseGrid& grid, const Schedule& schedule) :
+        RegionCache( { "FIPNUM" }, properties, grid, schedule )
+    {}
+
+
+    RegionCache::RegionCache(const std::vector< std::string >& region_sets,
+                             const Eclipse3DProperties& properties,
+                             const EclipseGrid& grid,
+                             const Schedule& schedule) {
+        for (const auto& name : region_sets) {
+            if (!this->hasRegionSet( name ))
+                this->add_region_set( name, properties, grid, schedule );
+        }
+    }
+
+
+    /*
+      The cells are sorted into regions with a counting sort over the
+      global cells, split in one contiguous chunk per thread. The first
+      pass counts the active cells in each region - and the active
+      cells in each chunk - per thread, from the counts each thread gets
+      its own write position in every region, and the second pass
+      scatters the active indices. The active index of a cell is the
+      number of active cells in front of it, so it follows from the
+      chunk counts without any lookup.
+    */
+    void RegionCache::add_region_set( const std::string& name,
+                                      const Eclipse3DProperties& properties,
+                                      const EclipseGrid& grid,
+                                      const Schedule& schedule) {
+        const auto& property = properties.getIntGridProperty( name );
+        const auto& values = property.getData();
+        auto& set = this->sets[ name ];
+        if (values.empty())
+            return;
+
+        const auto minmax = std::minmax_element( values.begin(), values.end() );
+        const int min_id = *minmax.first;
+        const std::size_t num_bins = std::size_t( *minmax.second - min_id ) + 1;
+        const std::size_t global_size = values.size();
+        const std::size_t nt = parallel::num_threads( global_size, min_cells_per_thread );
+        const std::size_t chunk = (global_size + nt - 1) / nt;
+
+        std::vector< std::vector< std::size_t > > counts( nt, std::vector< std::size_t >( num_bins, 0 ));
+        std::vector< std::vector< char > > seen( nt, std::vector< char >( num_bins, 0 ));
+        std::vector< std::size_t > active_begin( nt + 1, 0 );
+
+        parallel::run( nt, [&]( std::size_t t ) {
+            const auto begin = std::min( global_size, t * chunk );
+            const auto end = std::min( global_size, begin + chunk );
+            auto& count = counts[ t ];
+            auto& mark = seen[ t ];
+            std::size_t active = 0;
+
+            for (std::size_t g = begin; g < end; g++) {
+                const auto b = std::size_t( values[ g ] - min_id );
+                mark[ b ] = 1;
+                if (grid.cellActive( g )) {
+                    count[ b ]++;
+                    active++;
+                }
+            }
+            active_begin[ t + 1 ] = active;
+        });
+
+        for (std::size_t t = 0; t < nt; t++)
+            active_begin[ t + 1 ] += active_begin[ t ];
+
+        set.min_id = min_id;
+        set.cell_offset.assign( num_bins + 1, 0 );
+        for (std::size_t b = 0; b < num_bins; b++) {
+            std::size_t total = 0;
+            bool present = false;
+            for (std::size_t t = 0; t < nt; t++) {
+                const auto n = counts[ t ][ b ];
+                counts[ t ][ b ] = set.cell_offset[ b ] + total;
+                total += n;
+                present = present || seen[ t ][ b ];
+            }
+
+            set.cell_offset[ b + 1 ] = set.cell_offset[ b ] + total;
+            if (present)
+                set.ids.push_back( min_id + int( b ));
+        }
+
+        set.cell_index.resize( active_begin[ nt ] );
+        parallel::run( nt, [&]( std::size_t t ) {
+            const auto begin = std::min( global_size, t * chunk );
+            const auto end = std::min( global_size, begin + chunk );
+            auto& position = counts[ t ];
+            auto active_index = active_begin[ t ];
+
+            for (std::size_t g = begin; g < end; g++) {
+                if (!grid.cellActive( g ))
+                    continue;
+
+                const auto b = std::size_t( values[ g ] - min_id );
+                set.cell_index[ position[ b ]++ ] = std::uint32_t( active_index++ );
+            }
+        });
 
         {
+            std::vector< std::pair< std::size_t, completion > > region_completions;
             const auto& wells = schedule.getWells();
             for (const auto& well : wells) {
-                const auto& completions = well->getCompletions( );
-                for (const auto& c : completions) {
+                const auto& well_completions = well->getCompletions( );
+                for (const auto& c : well_completions) {
                     size_t global_index = grid.getGlobalIndex( c.getI() , c.getJ() , c.getK());
                     if (grid.cellActive( global_index )) {
                         size_t active_index = grid.activeIndex( global_index );
-                        int region_id =fipnum.iget( global_index );
-                        auto& well_index_list = this->completion_map[ region_id ];
-                        well_index_list.push_back( { well->name() , active_index } );
+                        const auto b = std::size_t( values[ global_index ] - min_id );
+                        region_completions.emplace_back( b, completion( well->name() , active_index ) );
                     }
                 }
             }
+
+            set.completion_offset.assign( num_bins + 1, 0 );
+            for (const auto& rc : region_completions)
+                set.completion_offset[ rc.first + 1 ]++;
+
+            for (std::size_t b = 0; b < num_bins; b++)
+                set.completion_offset[ b + 1 ] += set.completion_offset[ b ];
+
+            std::vector< std::size_t > position( set.completion_offset.begin(), set.completion_offset.end() - 1 );
+            set.completion_data.resize( region_completions.size() );
+            for (auto& rc : region_completions)
+                set.completion_data[ position[ rc.first ]++ ] = std::move( rc.second );
         }
     }
 
 
-    const std::vector<size_t>& RegionCache::cells( int region_id ) const {
-        const auto iter = this->cell_map.find( region_id );
-        if (iter == this->cell_map.end())
-            return this->cells_empty;
-        else
-            return iter->second;
+    const RegionCache::region_set* RegionCache::find( const std::string& name ) const {
+        const auto iter = this->sets.find( name );
+        return iter == this->sets.end() ? nullptr : &iter->second;
+    }
+
+
+    bool RegionCache::hasRegionSet( const std::string& region_set ) const {
+        return this->find( region_set ) != nullptr;
+    }
+
+
+    const std::vector< int >& RegionCache::regions( const std::string& region_set ) const {
+        static const std::vector< int > empty;
+        const auto* set = this->find( region_set );
+        return set ? set->ids : empty;
+    }
+
+
+    RegionCache::range< std::uint32_t > RegionCache::cells( int region_id ) const {
+        return this->cells( "FIPNUM", region_id );
     }
 
 
+    RegionCache::range< std::uint32_t > RegionCache::cells( const std::string& region_set, int region_id ) const {
+        const auto* set = this->find( region_set );
+        if (!set)
+            return {};
+
+        const auto b = set->bin( region_id );
+        if (b == no_bin)
+            return {};
+
+        const auto* data = set->cell_index.data();
+        return { data + set->cell_offset[ b ], data + set->cell_offset[ b + 1 ] };
+    }
+
+
+    RegionCache::range< RegionCache::completion > RegionCache::completions( int region_id ) const {
+        return this->completions( "FIPNUM", region_id );
+    }
+
+
+    RegionCache::range< RegionCache::completion > RegionCache::completions( const std::string& region_set, int region_id ) const {
+        const auto* set = this->find( region_set );
+        if (!set)
+            return {};
+
+        const auto b = set->bin( region_id );
+        if (b == no_bin)
+            return {};
 
-    const std::vector<std::pair<std::string,size_t>>& RegionCache::completions( int region_id ) const {
-        const auto iter = this->completion_map.find( region_id );
-        if (iter == this->completion_map.end())
-            return this->completions_empty;
-        else
-            return iter->second;
+        const auto* data = set->completion_data.data();
+        return { data + set->completion_offset[ b ], data + set->completion_offset[ b + 1 ] };
     }
 
 }
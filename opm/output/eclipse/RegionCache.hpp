@@ -20,6 +20,11 @@
 #ifndef OPM_REGION_CACHE_HPP
 #define OPM_REGION_CACHE_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace Opm {
@@ -28,19 +33,84 @@ namespace Opm {
     class EclipseGrid;
 
 namespace out {
+
+    /*
+      The RegionCache class maps region ids to the active cells, and
+      the well completions, in each region. One cache can hold several
+      region sets, i.e. integer grid properties like FIPNUM, EQLNUM,
+      PVTNUM, SATNUM or one of the FIPxxx families; the overloads
+      without a region set name refer to FIPNUM.
+
+      Each region set is stored in compressed sparse row form: the
+      active cell indices of all regions in one array sorted by region,
+      and an offset array indexed by region id. The region ids are
+      assumed to be reasonably dense, the offset array covers the range
+      from the smallest to the largest id. The cell arrays are built
+      with a counting sort - count, prefix sum and scatter - where the
+      counting and scattering is split over threads for large grids;
+      the cells of a region are always listed in increasing order.
+
+      The cells() and completions() methods return lightweight ranges
+      which point into the cache, and are valid as long as the cache.
+    */
+
     class RegionCache {
     public:
+        template< typename T >
+        class range {
+        public:
+            range() = default;
+            range( const T* first, const T* last ) : first_( first ), last_( last ) {}
+
+            const T* begin() const { return this->first_; }
+            const T* end() const { return this->last_; }
+            std::size_t size() const { return this->last_ - this->first_; }
+            bool empty() const { return this->first_ == this->last_; }
+            const T& operator[]( std::size_t index ) const { return this->first_[ index ]; }
+
+        private:
+            const T* first_ = nullptr;
+            const T* last_ = nullptr;
+        };
+
+        using completion = std::pair< std::string, std::size_t >;
+
         RegionCache() = default;
         RegionCache(const Eclipse3DProperties& properties, const EclipseGrid& grid, const Schedule& schedule);
-        const std::vector<size_t>& cells( int region_id ) const;
-        const std::vector<std::pair<std::string,size_t>>& completions( int region_id ) const;
+        RegionCache(const std::vector< std::string >& region_sets,
+                    const Eclipse3DProperties& properties,
+                    const EclipseGrid& grid,
+                    const Schedule& schedule);
+
+        range< std::uint32_t > cells( int region_id ) const;
+        range< std::uint32_t > cells( const std::string& region_set, int region_id ) const;
+        range< completion > completions( int region_id ) const;
+        range< completion > completions( const std::string& region_set, int region_id ) const;
+
+        bool hasRegionSet( const std::string& region_set ) const;
+
+        /// The distinct region ids of the region set, in increasing order.
+        const std::vector< int >& regions( const std::string& region_set ) const;
 
     private:
-        std::vector<size_t> cells_empty;
-        std::vector<std::pair<std::string,size_t>> completions_empty;
+        struct region_set {
+            int min_id = 0;
+            std::vector< int > ids;
+            std::vector< std::size_t > cell_offset;
+            std::vector< std::uint32_t > cell_index;
+            std::vector< std::size_t > completion_offset;
+            std::vector< completion > completion_data;
+
+            std::size_t bin( int region_id ) const;
+        };
+
+        void add_region_set( const std::string& name,
+                             const Eclipse3DProperties& properties,
+                             const EclipseGrid& grid,
+                             const Schedule& schedule );
+        const region_set* find( const std::string& name ) const;
 
-        std::map<int , std::vector<size_t> > cell_map;
-        std::map<int , std::vector<std::pair<std::string,size_t>>> completion_map;
+        std::map< std::string, region_set > sets;
     };
 }
 }
@@ -0,0 +1,193 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+#include <opm/output/eclipse/HydrocarbonPoreVolume.hpp>
+#include <opm/output/eclipse/Parallel.hpp>
+#include <opm/output/eclipse/RegionCache.hpp>
+#include <opm/output/eclipse/RegionReduction.hpp>
+
+namespace Opm {
+namespace out {
+
+namespace {
+
+    /*
+      The partition size is fixed, and not derived from the number of
+      threads, to make the summation order independent of the number
+      of threads.
+    */
+    const std::size_t partition_size = 1 << 18;
+
+    /* acc[ bin[ i ] * stride ] += values[ i ] */
+    void scatter_add( const std::uint32_t* bin, const double* values,
+                      std::size_t size, double* acc, std::size_t stride ) {
+        for( std::size_t i = 0; i < size; i++ )
+            acc[ bin[ i ] * stride ] += values[ i ];
+    }
+
+    /* acc[ bin[ i ] * stride ] += w[ i ] * v[ i ], acc[ bin[ i ] * stride + 1 ] += w[ i ] */
+    void scatter_add_weighted( const std::uint32_t* bin, const double* w, const double* v,
+                               std::size_t size, double* acc, std::size_t stride ) {
+        for( std::size_t i = 0; i < size; i++ ) {
+            auto* a = acc + bin[ i ] * stride;
+            a[ 0 ] += w[ i ] * v[ i ];
+            a[ 1 ] += w[ i ];
+        }
+    }
+
+}
+
+
+RegionReduction::RegionReduction( const RegionCache& cache,
+                                  const std::string& region_set,
+                                  std::size_t num_active_arg ) :
+    num_active( num_active_arg ),
+    region_ids( cache.regions( region_set ) ),
+    cell_bin( num_active_arg, std::uint32_t( cache.regions( region_set ).size() ))
+{
+    for( std::size_t b = 0; b < this->region_ids.size(); b++ ) {
+        for( const auto cell : cache.cells( region_set, this->region_ids[ b ] ) ) {
+            if( cell < this->num_active )
+                this->cell_bin[ cell ] = std::uint32_t( b );
+        }
+    }
+}
+
+
+void RegionReduction::addField( const std::string& keyword ) {
+    if( this->field_index.count( keyword ) ) return;
+
+    this->field_index.emplace( keyword, this->fields.size() );
+    this->fields.push_back( keyword );
+}
+
+
+void RegionReduction::addPressure() {
+    this->with_pressure = true;
+}
+
+
+bool RegionReduction::empty() const {
+    return this->fields.empty() && !this->with_pressure;
+}
+
+
+/*
+  The values of each region are the field sums followed by the sums of
+  hcpv * pressure and hcpv when the pressure is registered. There is
+  one extra bin for cells which are not in any region.
+*/
+std::size_t RegionReduction::num_values() const {
+    return this->fields.size() + ( this->with_pressure ? 2 : 0 );
+}
+
+
+std::size_t RegionReduction::bin( int region_id ) const {
+    const auto iter = std::lower_bound( this->region_ids.begin(), this->region_ids.end(), region_id );
+    if( iter == this->region_ids.end() || *iter != region_id )
+        return this->region_ids.size();
+
+    return iter - this->region_ids.begin();
+}
+
+
+void RegionReduction::update( const data::Solution& state, const HydrocarbonPoreVolume& hcpv ) {
+    const auto stride = this->num_values();
+    const auto num_bins = this->region_ids.size() + 1;
+    this->values.assign( stride * num_bins, 0.0 );
+    if( stride == 0 || this->num_active == 0 ) return;
+
+    this->field_data.assign( this->fields.size(), nullptr );
+    for( std::size_t f = 0; f < this->fields.size(); f++ ) {
+        const auto& keyword = this->fields[ f ];
+        if( !state.has( keyword ) ) continue;
+
+        const auto& data = state.data( keyword );
+        if( data.size() != this->num_active ) {
+            std::stringstream str;
+            str << "Wrongly sized data array passed to output for keyword "
+                << keyword << ", size=" << data.size() << ", expected=" << this->num_active << ".";
+            throw std::runtime_error( str.str() );
+        }
+
+        this->field_data[ f ] = data.data();
+    }
+
+    this->has_pressure = this->with_pressure && hcpv.hasPressure();
+    if( this->has_pressure && hcpv.size() != this->num_active )
+        throw std::runtime_error( "The hydrocarbon pore volume does not match the number of active cells" );
+
+    const double* pressure = this->has_pressure ? state.data( "PRESSURE" ).data() : nullptr;
+    const double* weights = this->has_pressure ? hcpv.weights() : nullptr;
+
+    const auto num_partitions = ( this->num_active + partition_size - 1 ) / partition_size;
+    this->partial.resize( num_partitions );
+    const auto nt = std::min( num_partitions, parallel::num_threads( this->num_active, partition_size ));
+
+    parallel::run( nt, [&]( std::size_t t ) {
+        for( auto p = t; p < num_partitions; p += nt ) {
+            const auto begin = p * partition_size;
+            const auto size = std::min( partition_size, this->num_active - begin );
+            const auto* bin = this->cell_bin.data() + begin;
+            auto& acc = this->partial[ p ];
+            acc.assign( stride * num_bins, 0.0 );
+
+            for( std::size_t f = 0; f < this->field_data.size(); f++ ) {
+                if( this->field_data[ f ] )
+                    scatter_add( bin, this->field_data[ f ] + begin, size, acc.data() + f, stride );
+            }
+
+            if( pressure )
+                scatter_add_weighted( bin, weights + begin, pressure + begin, size,
+                                      acc.data() + this->field_data.size(), stride );
+        }
+    });
+
+    for( const auto& acc : this->partial ) {
+        for( std::size_t i = 0; i < acc.size(); i++ )
+            this->values[ i ] += acc[ i ];
+    }
+}
+
+
+double RegionReduction::sum( const std::string& keyword, int region_id ) const {
+    const auto iter = this->field_index.find( keyword );
+    const auto b = this->bin( region_id );
+    if( iter == this->field_index.end() || b == this->region_ids.size() || this->values.empty() )
+        return 0.0;
+
+    return this->values[ b * this->num_values() + iter->second ];
+}
+
+
+double RegionReduction::pressure( int region_id ) const {
+    const auto b = this->bin( region_id );
+    if( !this->has_pressure || b == this->region_ids.size() || this->values.empty() )
+        return 0.0;
+
+    const auto* v = this->values.data() + b * this->num_values() + this->fields.size();
+    return v[ 0 ] / v[ 1 ];
+}
+
+}
+}
@@ -0,0 +1,105 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_REGION_REDUCTION_HPP
+#define OPM_OUTPUT_REGION_REDUCTION_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <opm/output/data/Solution.hpp>
+
+namespace Opm {
+namespace out {
+
+    class HydrocarbonPoreVolume;
+    class RegionCache;
+
+    /*
+      The RegionReduction class evaluates all the per region cell sums
+      needed by the region summary vectors in one go. The fields which
+      are needed - e.g. OIP for ROIP and GIP for RGIP - are registered
+      with addField() when the summary is set up, and the hydrocarbon
+      pore volume weighted pressure for RPR with addPressure(); the
+      weights are taken from the HydrocarbonPoreVolume instance of the
+      time step, which also provides the field average pressure. Each
+      update() then streams every registered field once, scatter adding
+      the cell values into per region accumulators, and the region
+      vectors only look up the precomputed results.
+
+      The active cells are processed in fixed size partitions, which are
+      distributed over threads. The partial sums of the partitions are
+      added in partition order, so the results do not depend on the
+      number of threads; when there is only one partition the sums are
+      accumulated in increasing cell order within each region.
+    */
+
+    class RegionReduction {
+    public:
+        RegionReduction() = default;
+        RegionReduction( const RegionCache& cache, const std::string& region_set, std::size_t num_active );
+
+        void addField( const std::string& keyword );
+        void addPressure();
+        bool empty() const;
+
+        /*
+          Evaluate the registered sums; hcpv must have been updated
+          with the same solution. Throws std::runtime_error if a
+          registered field in the solution does not have one value per
+          active cell, fields which are not in the solution sum to
+          zero.
+        */
+        void update( const data::Solution& state, const HydrocarbonPoreVolume& hcpv );
+
+        /// Sum of keyword over the cells in region_id; zero if the
+        /// field or the region is unknown.
+        double sum( const std::string& keyword, int region_id ) const;
+
+        /// Hydrocarbon pore volume weighted average pressure.
+        double pressure( int region_id ) const;
+
+    private:
+        std::size_t bin( int region_id ) const;
+        std::size_t num_values() const;
+
+        std::size_t num_active = 0;
+        std::vector< int > region_ids;
+        std::vector< std::uint32_t > cell_bin;
+
+        std::map< std::string, std::size_t > field_index;
+        std::vector< std::string > fields;
+        bool with_pressure = false;
+        bool has_pressure = false;
+
+        /* value v of region bin b is stored at b * num_values() + v */
+        std::vector< double > values;
+
+        /* kept between the updates to avoid reallocation */
+        std::vector< const double* > field_data;
+        std::vector< std::vector< double > > partial;
+    };
+
+}
+}
+
+#endif //OPM_OUTPUT_REGION_REDUCTION_HPP
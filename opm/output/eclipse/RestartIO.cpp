@@ -21,13 +21,18 @@
   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
 */
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 
+#include <opm/output/data/IndexedWells.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
 #include <opm/output/eclipse/RestartIO.hpp>
+#include <opm/output/eclipse/Statistics.hpp>
+#include <opm/output/eclipse/UnitConversion.hpp>
 
 #include <ert/ecl/EclKW.hpp>
 #include <ert/ecl/FortIO.hpp>
@@ -88,7 +93,26 @@ namespace {
         }
     }
 
+    void count_read( std::size_t count, std::size_t element_size ) {
+        using out::statistics::phase;
+        out::statistics::add_keywords( phase::restart_load );
+        out::statistics::add_bytes( phase::restart_load, count * element_size );
+    }
+
+    void count_read( const ecl_kw_type * ecl_kw ) {
+        count_read( ecl_kw_get_size( ecl_kw ),
+                    ecl_type_get_sizeof_ctype( ecl_kw_get_data_type( ecl_kw )));
+    }
+
+    void count_read( const out::MappedEclFile::keyword& kw ) {
+        const bool eight_bytes = kw.type == "DOUB" || kw.type == "CHAR";
+        count_read( kw.count, eight_bytes ? 8 : 4 );
+    }
+
     std::vector<double> double_vector( const ecl_kw_type * ecl_kw ) {
+        count_read( ecl_kw );
+        out::statistics::add_allocations( out::statistics::phase::restart_load );
+
         size_t size = ecl_kw_get_size( ecl_kw );
 
         if (ecl_type_get_type( ecl_kw_get_data_type( ecl_kw ) ) == ECL_DOUBLE_TYPE ) {
@@ -132,7 +156,46 @@ namespace {
             std::vector<double> data = double_vector( ecl_kw );
             units.to_si( dim , data );
 
-            sol.insert( key, dim, data , data::TargetType::RESTART_SOLUTION );
+            sol.insert( key, dim, std::move( data ), data::TargetType::RESTART_SOLUTION );
+        }
+
+        return sol;
+    }
+
+
+    inline data::Solution restoreSOLUTION( out::MappedEclFile& file,
+                                           int report_step,
+                                           const std::map<std::string, RestartKey>& keys,
+                                           const UnitSystem& units,
+                                           int numcells) {
+
+        data::Solution sol;
+        for (const auto& pair : keys) {
+            const std::string& key = pair.first;
+            UnitSystem::measure dim = pair.second.dim;
+            bool required = pair.second.required;
+
+            const auto* kw = file.find( report_step, key );
+            if( !kw ) {
+                if (required)
+                    throw std::runtime_error("Read of restart file: "
+                                             "File does not contain "
+                                             + key
+                                             + " data" );
+                else
+                    continue;
+            }
+
+            if( kw->count != size_t( numcells ))
+                throw std::runtime_error("Restart file: Could not restore "
+                                         + kw->name
+                                         + ", mismatched number of cells" );
+
+            auto& data = sol.insert( key, dim, std::vector<double>( numcells ), data::TargetType::RESTART_SOLUTION ).first->second.data;
+            file.read( *kw, data.data() );
+            count_read( *kw );
+            out::statistics::add_allocations( out::statistics::phase::restart_load );
+            units.to_si( dim , data );
         }
 
         return sol;
@@ -140,8 +203,10 @@ namespace {
 
 
 using rt = data::Rates::opt;
-data::Wells restore_wells( const ecl_kw_type * opm_xwel,
-                           const ecl_kw_type * opm_iwel,
+data::Wells restore_wells( const double * opm_xwel_data,
+                           int opm_xwel_size,
+                           const int * opm_iwel_data,
+                           int opm_iwel_size,
                            int restart_step,
                            const EclipseState& es,
                            const EclipseGrid& grid,
@@ -168,22 +233,20 @@ data::Wells restore_wells( const ecl_kw_type * opm_xwel,
                                                      0,
                                                      well_size );
 
-    if( ecl_kw_get_size( opm_xwel ) != expected_xwel_size ) {
+    if( opm_xwel_size != expected_xwel_size ) {
         throw std::runtime_error(
                 "Mismatch between OPM_XWEL and deck; "
-                "OPM_XWEL size was " + std::to_string( ecl_kw_get_size( opm_xwel ) ) +
+                "OPM_XWEL size was " + std::to_string( opm_xwel_size ) +
                 ", expected " + std::to_string( expected_xwel_size ) );
     }
 
-    if( ecl_kw_get_size( opm_iwel ) != int(sched_wells.size()) )
+    if( opm_iwel_size != int(sched_wells.size()) )
         throw std::runtime_error(
                 "Mismatch between OPM_IWEL and deck; "
-                "OPM_IWEL size was " + std::to_string( ecl_kw_get_size( opm_iwel ) ) +
+                "OPM_IWEL size was " + std::to_string( opm_iwel_size ) +
                 ", expected " + std::to_string( sched_wells.size() ) );
 
     data::Wells wells;
-    const double * opm_xwel_data = ecl_kw_get_double_ptr( opm_xwel );
-    const int * opm_iwel_data = ecl_kw_get_int_ptr( opm_iwel );
     for( const auto* sched_well : sched_wells ) {
         data::Well& well = wells[ sched_well->name() ];
 
@@ -215,6 +278,68 @@ data::Wells restore_wells( const ecl_kw_type * opm_xwel,
 
     return wells;
 }
+
+
+/*
+  Load from an unformatted restart file. The file is memory mapped and
+  only the keyword headers up to the requested report step are read,
+  the time to load is therefor independent of the number of report
+  steps after the restart step. The keywords are decoded directly into
+  the vectors of the returned RestartValue.
+*/
+RestartValue load_mapped( const std::string& filename,
+                          int report_step,
+                          bool unified,
+                          const std::map<std::string, RestartKey>& keys,
+                          const EclipseState& es,
+                          const EclipseGrid& grid,
+                          const Schedule& schedule,
+                          const std::map<std::string, bool>& extra_keys) {
+
+    out::MappedEclFile file( filename );
+    const int view_step = unified ? report_step : -1;
+
+    if( unified && !file.hasReportStep( report_step ))
+        throw std::runtime_error( "Restart file " + filename
+                                  + " does not contain data for report step "
+                                  + std::to_string( report_step ) + "!" );
+
+    const auto required_kw = [&]( const char* name ) {
+        const auto* kw = file.find( view_step, name );
+        if( !kw )
+            throw std::runtime_error( "Restart file " + filename + " does not contain " + name );
+
+        count_read( *kw );
+        out::statistics::add_allocations( out::statistics::phase::restart_load );
+        return kw;
+    };
+
+    const auto intehead = file.read_int( *required_kw( "INTEHEAD" ) );
+    const auto opm_xwel = file.read_double( *required_kw( "OPM_XWEL" ) );
+    const auto opm_iwel = file.read_int( *required_kw( "OPM_IWEL" ) );
+
+    UnitSystem units( static_cast<ert_ecl_unit_enum>( intehead.at( INTEHEAD_UNIT_INDEX )));
+    RestartValue rst_value( restoreSOLUTION( file, view_step, keys, units , grid.getNumActive( )),
+                            restore_wells( opm_xwel.data(), opm_xwel.size(),
+                                           opm_iwel.data(), opm_iwel.size(),
+                                           report_step , es, grid, schedule));
+
+    for (const auto& pair : extra_keys) {
+        const std::string& key = pair.first;
+        bool required = pair.second;
+
+        const auto* kw = file.find( view_step, key );
+        if (kw) {
+            rst_value.extra[ key ] = file.read_double( *kw );
+            count_read( *kw );
+            out::statistics::add_allocations( out::statistics::phase::restart_load );
+        }
+        else if (required)
+            throw std::runtime_error("No such key in file: " + key);
+    }
+
+    return rst_value;
+}
 }
 
 /* should take grid as argument because it may be modified from the simulator */
@@ -226,7 +351,11 @@ RestartValue load( const std::string& filename,
                    const Schedule& schedule,
                    const std::map<std::string, bool>& extra_keys) {
 
+    out::statistics::scoped_timer timer( out::statistics::phase::restart_load );
     const bool unified                   = ( ERT::EclFiletype( filename ) == ECL_UNIFIED_RESTART_FILE );
+    if( out::MappedEclFile::unformatted( filename ))
+        return load_mapped( filename, report_step, unified, keys, es, grid, schedule, extra_keys );
+
     ERT::ert_unique_ptr< ecl_file_type, ecl_file_close > file(ecl_file_open( filename.c_str(), 0 ));
     ecl_file_view_type * file_view;
 
@@ -245,10 +374,15 @@ RestartValue load( const std::string& filename,
     const ecl_kw_type * intehead = ecl_file_view_iget_named_kw( file_view , "INTEHEAD", 0 );
     const ecl_kw_type * opm_xwel = ecl_file_view_iget_named_kw( file_view , "OPM_XWEL", 0 );
     const ecl_kw_type * opm_iwel = ecl_file_view_iget_named_kw( file_view, "OPM_IWEL", 0 );
+    count_read( intehead );
+    count_read( opm_xwel );
+    count_read( opm_iwel );
 
     UnitSystem units( static_cast<ert_ecl_unit_enum>(ecl_kw_iget_int( intehead , INTEHEAD_UNIT_INDEX )));
     RestartValue rst_value( restoreSOLUTION( file_view, keys, units , grid.getNumActive( )),
-                            restore_wells( opm_xwel, opm_iwel, report_step , es, grid, schedule));
+                            restore_wells( ecl_kw_get_double_ptr( opm_xwel ), ecl_kw_get_size( opm_xwel ),
+                                           ecl_kw_get_int_ptr( opm_iwel ), ecl_kw_get_size( opm_iwel ),
+                                           report_step , es, grid, schedule));
 
     for (const auto& pair : extra_keys) {
         const std::string& key = pair.first;
@@ -256,6 +390,8 @@ RestartValue load( const std::string& filename,
 
         if (ecl_file_view_has_kw( file_view , key.c_str())) {
             const ecl_kw_type * ecl_kw = ecl_file_view_iget_named_kw( file_view , key.c_str() , 0 );
+            count_read( ecl_kw );
+            out::statistics::add_allocations( out::statistics::phase::restart_load );
             const double * data_ptr = ecl_kw_get_double_ptr( ecl_kw );
             const double * end_ptr  = data_ptr + ecl_kw_get_size( ecl_kw );
             rst_value.extra[ key ] = { data_ptr, end_ptr };
@@ -335,12 +471,12 @@ std::vector<int> serialize_IWEL( size_t step,
 
 
 
-std::vector< int > serialize_OPM_IWEL( const data::Wells& wells,
+std::vector< int > serialize_OPM_IWEL( const data::IndexedWells& wells,
                                        const std::vector< const Well* >& sched_wells ) {
 
     const auto getctrl = [&]( const Well* w ) {
-        const auto itr = wells.find( w->name() );
-        return itr == wells.end() ? 0 : itr->second.control;
+        const auto id = wells.id( w->name() );
+        return id == data::IndexedWells::npos ? 0 : wells.control( id );
     };
 
     std::vector< int > iwel( sched_wells.size(), 0.0 );
@@ -348,7 +484,7 @@ std::vector< int > serialize_OPM_IWEL( const data::Wells& wells,
     return iwel;
 }
 
-std::vector< double > serialize_OPM_XWEL( const data::Wells& wells,
+std::vector< double > serialize_OPM_XWEL( const data::IndexedWells& wells,
                                           int report_step,
                                           const std::vector< const Well* >& sched_wells,
                                           const Phases& phase_spec,
@@ -364,7 +500,8 @@ std::vector< double > serialize_OPM_XWEL( const data::Wells& wells,
     std::vector< double > xwel;
     for( const auto* sched_well : sched_wells ) {
 
-        if( wells.count( sched_well->name() ) == 0 ) {
+        const auto id = wells.id( sched_well->name() );
+        if( id == data::IndexedWells::npos ) {
             const auto elems = (sched_well->getCompletions( report_step ).size()
                                * (phases.size() + data::Completion::restart_size))
                 + 2 /* bhp, temperature */
@@ -375,12 +512,10 @@ std::vector< double > serialize_OPM_XWEL( const data::Wells& wells,
             continue;
         }
 
-        const auto& well = wells.at( sched_well->name() );
-
-        xwel.push_back( well.bhp );
-        xwel.push_back( well.temperature );
+        xwel.push_back( wells.bhp( id ) );
+        xwel.push_back( wells.temperature( id ) );
         for( auto phase : phases )
-            xwel.push_back( well.rates.get( phase ) );
+            xwel.push_back( wells.rates( id ).get( phase ) );
 
         for( const auto& sc : sched_well->getCompletions( report_step ) ) {
             const auto i = sc.getI(), j = sc.getJ(), k = sc.getK();
@@ -391,15 +526,8 @@ std::vector< double > serialize_OPM_XWEL( const data::Wells& wells,
                 continue;
             }
 
-            const auto active_index = grid.activeIndex( i, j, k );
-            const auto at_index = [=]( const data::Completion& c ) {
-                return c.index == active_index;
-            };
-            const auto& completion = std::find_if( well.completions.begin(),
-                                                   well.completions.end(),
-                                                   at_index );
-
-            if( completion == well.completions.end() ) {
+            const auto* completion = wells.completion( id, grid.activeIndex( i, j, k ) );
+            if( !completion ) {
                 xwel.insert( xwel.end(), rs_size, 0.0 );
                 continue;
             }
@@ -430,9 +558,16 @@ std::vector<const char*> serialize_ZWEL( const std::vector<const Well *>& wells)
 
 
 
+/* Write one keyword and add the write time to the statistics. */
+void add_kw( ecl_rst_file_type * rst_file , const ecl_kw_type * ecl_kw ) {
+    out::statistics::scoped_write write( out::statistics::phase::restart_save );
+    ecl_rst_file_add_kw( rst_file, ecl_kw );
+}
+
 template< typename T >
 void write_kw(ecl_rst_file_type * rst_file , ERT::EclKW< T >&& kw) {
-    ecl_rst_file_add_kw( rst_file, kw.get() );
+    out::statistics::add_allocations( out::statistics::phase::restart_save );
+    add_kw( rst_file, kw.get() );
 }
 
 void writeHeader(ecl_rst_file_type * rst_file,
@@ -465,21 +600,28 @@ void writeHeader(ecl_rst_file_type * rst_file,
                               &rsthead_data.month,
                               &rsthead_data.year );
 
+    out::statistics::scoped_write write( out::statistics::phase::restart_save, 0 );
     ecl_rst_file_fwrite_header( rst_file, report_step , &rsthead_data );
 }
 
-  ERT::ert_unique_ptr< ecl_kw_type, ecl_kw_free > ecl_kw( const std::string& kw, const std::vector<double>& data, bool write_double) {
+  /*
+    The SI values are converted to output units and stored in the
+    ecl_kw buffer in one pass; the solution itself is not touched.
+  */
+  ERT::ert_unique_ptr< ecl_kw_type, ecl_kw_free > ecl_kw( const std::string& kw,
+                                                          const std::vector<double>& data,
+                                                          const out::UnitConversion& conversion,
+                                                          bool write_double) {
       ERT::ert_unique_ptr< ecl_kw_type, ecl_kw_free > kw_ptr;
+      out::statistics::add_allocations( out::statistics::phase::restart_save );
 
       if (write_double) {
 	  ecl_kw_type * ecl_kw = ecl_kw_alloc( kw.c_str() , data.size() , ECL_DOUBLE );
-	  ecl_kw_set_memcpy_data( ecl_kw , data.data() );
+	  conversion.apply( data.data() , data.size() , ecl_kw_get_double_ptr( ecl_kw ) );
 	  kw_ptr.reset( ecl_kw );
       } else {
 	  ecl_kw_type * ecl_kw = ecl_kw_alloc( kw.c_str() , data.size() , ECL_FLOAT );
-	  float * float_data = ecl_kw_get_float_ptr( ecl_kw );
-	  for (size_t i=0; i < data.size(); i++)
-	      float_data[i] = data[i];
+	  conversion.apply( data.data() , data.size() , ecl_kw_get_float_ptr( ecl_kw ) );
 	  kw_ptr.reset( ecl_kw );
       }
 
@@ -487,18 +629,30 @@ void writeHeader(ecl_rst_file_type * rst_file,
   }
 
 
+  out::UnitConversion output_conversion( const data::Solution& solution, const data::CellData& cell_data, const UnitSystem& units ) {
+      if (!solution.isSI())
+          return out::UnitConversion();
+
+      return out::UnitConversion( units, cell_data.dim );
+  }
+
+
 
-  void writeSolution(ecl_rst_file_type* rst_file, const data::Solution& solution, bool write_double) {
+  void writeSolution(ecl_rst_file_type* rst_file, const data::Solution& solution, const UnitSystem& units, bool write_double) {
     ecl_rst_file_start_solution( rst_file );
     for (const auto& elm: solution) {
-        if (elm.second.target == data::TargetType::RESTART_SOLUTION)
-            ecl_rst_file_add_kw( rst_file , ecl_kw(elm.first, elm.second.data, write_double).get());
+        if (elm.second.target == data::TargetType::RESTART_SOLUTION) {
+            const auto conversion = output_conversion( solution, elm.second, units );
+            add_kw( rst_file , ecl_kw(elm.first, elm.second.data, conversion, write_double).get());
+        }
      }
      ecl_rst_file_end_solution( rst_file );
 
      for (const auto& elm: solution) {
-        if (elm.second.target == data::TargetType::RESTART_AUXILIARY)
-            ecl_rst_file_add_kw( rst_file , ecl_kw(elm.first, elm.second.data, write_double).get());
+        if (elm.second.target == data::TargetType::RESTART_AUXILIARY) {
+            const auto conversion = output_conversion( solution, elm.second, units );
+            add_kw( rst_file , ecl_kw(elm.first, elm.second.data, conversion, write_double).get());
+        }
      }
   }
 
@@ -509,7 +663,7 @@ void writeExtraData(ecl_rst_file_type* rst_file, const std::map<std::string,std:
         const std::vector<double>& data = pair.second;
         {
             ecl_kw_type * ecl_kw = ecl_kw_alloc_new_shared( key.c_str() , data.size() , ECL_DOUBLE , const_cast<double *>(data.data()));
-            ecl_rst_file_add_kw( rst_file , ecl_kw);
+            add_kw( rst_file , ecl_kw);
             ecl_kw_free( ecl_kw );
         }
     }
@@ -517,16 +671,17 @@ void writeExtraData(ecl_rst_file_type* rst_file, const std::map<std::string,std:
 
 
 
-void writeWell(ecl_rst_file_type* rst_file, int report_step, const EclipseState& es , const EclipseGrid& grid, const Schedule& schedule, const data::Wells& wells) {
+void writeWell(ecl_rst_file_type* rst_file, int report_step, const EclipseState& es , const EclipseGrid& grid, const Schedule& schedule, const data::IndexedWells& indexed_wells) {
     const auto sched_wells  = schedule.getWells(report_step);
     const auto& phases = es.runspec().phases();
     const size_t ncwmax = schedule.getMaxNumCompletionsForWells(report_step);
 
-    const auto opm_xwel  = serialize_OPM_XWEL( wells, report_step, sched_wells, phases, grid );
-    const auto opm_iwel  = serialize_OPM_IWEL( wells, sched_wells );
+    const auto opm_xwel  = serialize_OPM_XWEL( indexed_wells, report_step, sched_wells, phases, grid );
+    const auto opm_iwel  = serialize_OPM_IWEL( indexed_wells, sched_wells );
     const auto iwel_data = serialize_IWEL(report_step, sched_wells);
     const auto icon_data = serialize_ICON(report_step , ncwmax, sched_wells);
     const auto zwel_data = serialize_ZWEL( sched_wells );
+    out::statistics::add_allocations( out::statistics::phase::restart_save, 5 );
 
     write_kw( rst_file, ERT::EclKW< int >( IWEL_KW, iwel_data) );
     write_kw( rst_file, ERT::EclKW< const char* >(ZWEL_KW, zwel_data ) );
@@ -563,14 +718,30 @@ void checkSaveArguments(const data::Solution& cells,
 void save(const std::string& filename,
           int report_step,
           double seconds_elapsed,
-          data::Solution cells,
-          data::Wells wells,
+          const data::Solution& cells,
+          const data::Wells& wells,
+          const EclipseState& es,
+          const EclipseGrid& grid,
+          const Schedule& schedule,
+          const std::map<std::string, std::vector<double>>& extra_data,
+	  bool write_double)
+{
+    save( filename, report_step, seconds_elapsed, cells, data::IndexedWells( wells ), es, grid, schedule, extra_data, write_double );
+}
+
+
+void save(const std::string& filename,
+          int report_step,
+          double seconds_elapsed,
+          const data::Solution& cells,
+          const data::IndexedWells& wells,
           const EclipseState& es,
           const EclipseGrid& grid,
           const Schedule& schedule,
-          std::map<std::string, std::vector<double>> extra_data,
+          const std::map<std::string, std::vector<double>>& extra_data,
 	  bool write_double)
 {
+    out::statistics::scoped_timer timer( out::statistics::phase::restart_save );
     checkSaveArguments( cells, grid, extra_data );
     {
         int ert_phase_mask = es.runspec().eclPhaseMask( );
@@ -578,18 +749,21 @@ void save(const std::string& filename,
         time_t posix_time = schedule.posixStartTime() + seconds_elapsed;
         const auto sim_time = units.from_si( UnitSystem::measure::time, seconds_elapsed );
         ERT::ert_unique_ptr< ecl_rst_file_type, ecl_rst_file_close > rst_file;
+        const bool unified = ERT::EclFiletype( filename ) == ECL_UNIFIED_RESTART_FILE;
 
-        if (ERT::EclFiletype( filename ) == ECL_UNIFIED_RESTART_FILE)
+        if (unified)
             rst_file.reset( ecl_rst_file_open_write_seek( filename.c_str(), report_step ) );
         else
             rst_file.reset( ecl_rst_file_open_write( filename.c_str() ) );
 
+        const auto start_offset = ecl_rst_file_ftell( rst_file.get() );
 
-        cells.convertFromSI( units );
         writeHeader( rst_file.get() , report_step, posix_time , sim_time, ert_phase_mask, units, schedule , grid );
         writeWell( rst_file.get() , report_step, es , grid, schedule, wells);
-        writeSolution( rst_file.get() , cells , write_double );
+        writeSolution( rst_file.get() , cells , units, write_double );
         writeExtraData( rst_file.get() , extra_data );
+        out::statistics::add_bytes( out::statistics::phase::restart_save,
+                                    ecl_rst_file_ftell( rst_file.get() ) - start_offset );
     }
 }
 }
@@ -31,6 +31,7 @@
 #include <opm/parser/eclipse/EclipseState/Schedule/Well.hpp>
 
 #include <opm/output/data/Cells.hpp>
+#include <opm/output/data/IndexedWells.hpp>
 #include <opm/output/data/Solution.hpp>
 #include <opm/output/data/Wells.hpp>
 #include <opm/output/eclipse/RestartValue.hpp>
@@ -70,17 +71,35 @@ namespace RestartIO {
 
    will read and write to the file "CASE.X0010" - completely ignoring
    the report step argument '99'.
+
+   The save() function does not copy or modify the solution; the
+   fields are converted from SI units one keyword at a time as they are
+   written.
 */
 
 void save(const std::string& filename,
           int report_step,
           double seconds_elapsed,
-          data::Solution cells,
-          data::Wells wells,
+          const data::Solution& cells,
+          const data::Wells& wells,
+          const EclipseState& es,
+          const EclipseGrid& grid,
+          const Schedule& schedule,
+          const std::map<std::string, std::vector<double>>& extra_data = {},
+	  bool write_double = false);
+
+/*
+  As above, with the wells already indexed.
+*/
+void save(const std::string& filename,
+          int report_step,
+          double seconds_elapsed,
+          const data::Solution& cells,
+          const data::IndexedWells& wells,
           const EclipseState& es,
           const EclipseGrid& grid,
           const Schedule& schedule,
-          std::map<std::string, std::vector<double>> extra_data = {},
+          const std::map<std::string, std::vector<double>>& extra_data = {},
 	  bool write_double = false);
 
 
@@ -0,0 +1,210 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <condition_variable>
+#include <mutex>
+#include <stdexcept>
+
+#include <opm/output/eclipse/StagingArea.hpp>
+#include <opm/output/eclipse/Statistics.hpp>
+
+namespace Opm {
+namespace out {
+
+    /*
+      The pool is shared between the StagingArea and the deleters of
+      the handles, so a buffer released after the StagingArea is gone
+      is simply deleted with the pool.
+    */
+    struct StagingArea::pool {
+        std::size_t capacity;
+        std::size_t created = 0;
+        std::vector< std::unique_ptr< StagedTimeStep > > free;
+
+        std::mutex lock;
+        std::condition_variable released;
+    };
+
+
+namespace {
+
+    /* One allocation if the vector has to grow to hold size elements. */
+    template< typename T >
+    std::size_t grows( const std::vector< T >& vector, std::size_t size ) {
+        return vector.capacity() < size ? 1 : 0;
+    }
+
+    /* The data vectors of dst which data::Solution::assign() has to allocate. */
+    std::size_t grows( const data::Solution& dst, const data::Solution& src ) {
+        std::size_t allocations = 0;
+        for( const auto& elm : src ) {
+            const auto iter = dst.find( elm.first );
+            allocations += iter == dst.end() ? 1 : grows( iter->second.data, elm.second.data.size() );
+        }
+        return allocations;
+    }
+
+    /*
+      std::map assignment destroys the values of the nodes it reuses,
+      so the vectors - and the completion vectors of the wells - are
+      assigned one by one to keep their storage. The return value is
+      the number of vectors which had to be allocated or grown.
+    */
+    std::size_t assign( std::map< std::string, std::vector< double > >& dst,
+                        const std::map< std::string, std::vector< double > >& src ) {
+        for( auto iter = dst.begin(); iter != dst.end(); ) {
+            if( src.count( iter->first ) )
+                ++iter;
+            else
+                iter = dst.erase( iter );
+        }
+
+        std::size_t allocations = 0;
+        for( const auto& elm : src ) {
+            auto& vector = dst[ elm.first ];
+            allocations += grows( vector, elm.second.size() );
+            vector.assign( elm.second.begin(), elm.second.end() );
+        }
+        return allocations;
+    }
+
+    std::size_t assign( data::Wells& dst, const data::Wells& src ) {
+        for( auto iter = dst.begin(); iter != dst.end(); ) {
+            if( src.count( iter->first ) )
+                ++iter;
+            else
+                iter = dst.erase( iter );
+        }
+
+        std::size_t allocations = 0;
+        for( const auto& elm : src ) {
+            const auto& src_well = elm.second;
+            auto& well = dst[ elm.first ];
+            allocations += grows( well.completions, src_well.completions.size() );
+
+            well.rates = src_well.rates;
+            well.bhp = src_well.bhp;
+            well.thp = src_well.thp;
+            well.temperature = src_well.temperature;
+            well.control = src_well.control;
+            well.completions.assign( src_well.completions.begin(), src_well.completions.end() );
+        }
+        return allocations;
+    }
+
+    /*
+      The vectors of data::IndexedWells are not visible, so one
+      allocation is counted when the staged wells grow.
+    */
+    std::size_t grows( const data::IndexedWells& dst, const data::IndexedWells& src ) {
+        return src.size() > dst.size() || src.numCompletions() > dst.numCompletions() ? 1 : 0;
+    }
+
+}
+
+
+    StagingArea::StagingArea( std::size_t num_buffers ) :
+        buffers( std::make_shared< pool >() )
+    {
+        if( num_buffers == 0 )
+            throw std::invalid_argument( "The staging area must have at least one buffer" );
+
+        this->buffers->capacity = num_buffers;
+        this->buffers->free.reserve( num_buffers );
+    }
+
+
+    StagingArea::handle StagingArea::acquire() {
+        std::unique_ptr< StagedTimeStep > buffer;
+        {
+            std::unique_lock< std::mutex > guard( this->buffers->lock );
+            auto& p = *this->buffers;
+            p.released.wait( guard, [&p] { return !p.free.empty() || p.created < p.capacity; });
+
+            if( p.free.empty() ) {
+                p.created++;
+                buffer.reset( new StagedTimeStep() );
+                statistics::add_allocations( statistics::phase::stage );
+            } else {
+                buffer = std::move( p.free.back() );
+                p.free.pop_back();
+            }
+        }
+
+        auto shared_pool = this->buffers;
+        return handle( buffer.release(), [shared_pool]( StagedTimeStep* step ) {
+                {
+                    std::lock_guard< std::mutex > guard( shared_pool->lock );
+                    shared_pool->free.emplace_back( step );
+                }
+                shared_pool->released.notify_one();
+            });
+    }
+
+
+    StagingArea::handle StagingArea::stage( const data::Solution& cells,
+                                            const data::Wells& wells,
+                                            const std::map< std::string, double >& misc_summary_values,
+                                            const std::map< std::string, std::vector< double > >& extra_restart ) {
+        statistics::scoped_timer timer( statistics::phase::stage );
+        auto step = this->acquire();
+
+        std::size_t allocations = grows( step->cells, cells );
+        step->cells.assign( cells );
+        allocations += assign( step->wells, wells );
+        step->indexed = false;
+        step->misc_summary_values = misc_summary_values;
+        allocations += assign( step->extra_restart, extra_restart );
+        statistics::add_allocations( statistics::phase::stage, allocations );
+
+        return step;
+    }
+
+
+    StagingArea::handle StagingArea::stage( const data::Solution& cells,
+                                            const data::IndexedWells& wells,
+                                            const std::map< std::string, double >& misc_summary_values,
+                                            const std::map< std::string, std::vector< double > >& extra_restart ) {
+        statistics::scoped_timer timer( statistics::phase::stage );
+        auto step = this->acquire();
+
+        std::size_t allocations = grows( step->cells, cells ) + grows( step->indexed_wells, wells );
+        step->cells.assign( cells );
+        step->indexed_wells = wells;
+        step->indexed = true;
+        step->misc_summary_values = misc_summary_values;
+        allocations += assign( step->extra_restart, extra_restart );
+        statistics::add_allocations( statistics::phase::stage, allocations );
+
+        return step;
+    }
+
+
+    std::size_t StagingArea::capacity() const {
+        return this->buffers->capacity;
+    }
+
+
+    std::size_t StagingArea::in_use() const {
+        std::lock_guard< std::mutex > guard( this->buffers->lock );
+        return this->buffers->created - this->buffers->free.size();
+    }
+
+}
+}
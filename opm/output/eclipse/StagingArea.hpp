@@ -0,0 +1,109 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_STAGING_AREA_HPP
+#define OPM_OUTPUT_STAGING_AREA_HPP
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opm/output/data/IndexedWells.hpp>
+#include <opm/output/data/Solution.hpp>
+#include <opm/output/data/Wells.hpp>
+
+namespace Opm {
+namespace out {
+
+    /*
+      Snapshot of the data passed to EclipseIO::writeTimeStep(), owned
+      by the output layer while the time step is queued for writing.
+      The wells are held either as data::Wells or, when indexed is
+      true, as data::IndexedWells.
+    */
+    struct StagedTimeStep {
+        data::Solution cells;
+        data::Wells wells;
+        data::IndexedWells indexed_wells;
+        bool indexed = false;
+        std::map< std::string, double > misc_summary_values;
+        std::map< std::string, std::vector< double > > extra_restart;
+    };
+
+    /*
+      The StagingArea class is a fixed pool of StagedTimeStep buffers
+      used to hand time steps over to the writer thread. While the
+      writer thread serializes the time step in one buffer the
+      simulator fills the next one, and with two buffers the output of
+      one report step overlaps with the computation of the next.
+
+      The buffers are sized by the first time steps staged in them -
+      i.e. by the number of active cells and the keyword list - and
+      are reused afterwards. As long as the simulator passes the same
+      keywords with the same sizes and the same wells with no more
+      completions than before, which is the normal case, staging a
+      time step copies the data into existing vectors and does not
+      allocate.
+
+      stage() returns a shared_ptr to the filled buffer; the buffer is
+      returned to the pool when the last copy of that pointer is
+      destroyed. When all the buffers are in use stage() blocks until
+      one is released, so the memory held by the output layer is
+      bounded by num_buffers snapshots. The pool may be destroyed
+      before the handles it has given out.
+    */
+
+    class StagingArea {
+    public:
+        using handle = std::shared_ptr< StagedTimeStep >;
+
+        explicit StagingArea( std::size_t num_buffers = 2 );
+
+        StagingArea( const StagingArea& ) = delete;
+        StagingArea& operator=( const StagingArea& ) = delete;
+
+        handle stage( const data::Solution& cells,
+                      const data::Wells& wells,
+                      const std::map< std::string, double >& misc_summary_values,
+                      const std::map< std::string, std::vector< double > >& extra_restart );
+
+        handle stage( const data::Solution& cells,
+                      const data::IndexedWells& wells,
+                      const std::map< std::string, double >& misc_summary_values,
+                      const std::map< std::string, std::vector< double > >& extra_restart );
+
+        std::size_t capacity() const;
+
+        /// Number of buffers which are currently staged, i.e. not
+        /// released by the writer.
+        std::size_t in_use() const;
+
+    private:
+        struct pool;
+        handle acquire();
+
+        std::shared_ptr< pool > buffers;
+    };
+
+}
+}
+
+#endif //OPM_OUTPUT_STAGING_AREA_HPP
@@ -0,0 +1,171 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+
+#include <opm/output/eclipse/Statistics.hpp>
+
+namespace Opm {
+namespace out {
+namespace statistics {
+
+namespace {
+
+    struct atomic_counters {
+        std::atomic< std::uint64_t > calls{ 0 };
+        std::atomic< std::uint64_t > nanoseconds{ 0 };
+        std::atomic< std::uint64_t > write_nanoseconds{ 0 };
+        std::atomic< std::uint64_t > bytes{ 0 };
+        std::atomic< std::uint64_t > keywords{ 0 };
+        std::atomic< std::uint64_t > allocations{ 0 };
+    };
+
+    std::array< atomic_counters, num_phases >& table() {
+        static std::array< atomic_counters, num_phases > counters;
+        return counters;
+    }
+
+    atomic_counters& entry( phase p ) {
+        return table()[ static_cast< std::size_t >( p ) ];
+    }
+
+    void add( std::atomic< std::uint64_t >& counter, std::uint64_t value ) {
+        counter.fetch_add( value, std::memory_order_relaxed );
+    }
+
+    std::uint64_t nanoseconds( std::chrono::steady_clock::duration elapsed ) {
+        return std::chrono::duration_cast< std::chrono::nanoseconds >( elapsed ).count();
+    }
+
+    std::uint64_t load( const std::atomic< std::uint64_t >& counter ) {
+        return counter.load( std::memory_order_relaxed );
+    }
+
+}
+
+
+const char* name( phase p ) {
+    switch( p ) {
+        case phase::summary_add_timestep: return "summary_add_timestep";
+        case phase::summary_write:        return "summary_write";
+        case phase::restart_save:         return "restart_save";
+        case phase::restart_load:         return "restart_load";
+        case phase::rft_write:            return "rft_write";
+        case phase::init_write:           return "init_write";
+        case phase::egrid_write:          return "egrid_write";
+        case phase::stage:                return "stage";
+    }
+
+    return "unknown";
+}
+
+
+counters get( phase p ) {
+    const auto& e = entry( p );
+    counters c;
+    c.calls = load( e.calls );
+    c.seconds = load( e.nanoseconds ) * 1e-9;
+    c.write_seconds = load( e.write_nanoseconds ) * 1e-9;
+    c.bytes = load( e.bytes );
+    c.keywords = load( e.keywords );
+    c.allocations = load( e.allocations );
+    return c;
+}
+
+
+void reset() {
+    for( auto& e : table() ) {
+        e.calls.store( 0, std::memory_order_relaxed );
+        e.nanoseconds.store( 0, std::memory_order_relaxed );
+        e.write_nanoseconds.store( 0, std::memory_order_relaxed );
+        e.bytes.store( 0, std::memory_order_relaxed );
+        e.keywords.store( 0, std::memory_order_relaxed );
+        e.allocations.store( 0, std::memory_order_relaxed );
+    }
+}
+
+
+void write_json( std::ostream& os ) {
+    const auto flags = os.flags();
+    const auto precision = os.precision();
+
+    os << "{\n";
+    for( std::size_t i = 0; i < num_phases; i++ ) {
+        const auto p = static_cast< phase >( i );
+        const auto c = get( p );
+
+        os << "  \"" << name( p ) << "\": { "
+           << "\"calls\": " << c.calls << ", "
+           << "\"seconds\": " << std::setprecision( 9 ) << std::fixed << c.seconds << ", "
+           << "\"write_seconds\": " << c.write_seconds << ", "
+           << "\"bytes\": " << c.bytes << ", "
+           << "\"keywords\": " << c.keywords << ", "
+           << "\"allocations\": " << c.allocations << " }"
+           << ( i + 1 < num_phases ? ",\n" : "\n" );
+    }
+    os << "}\n";
+
+    os.flags( flags );
+    os.precision( precision );
+}
+
+
+std::string json() {
+    std::ostringstream os;
+    write_json( os );
+    return os.str();
+}
+
+
+void add_call( phase p, std::chrono::steady_clock::duration elapsed ) {
+    auto& e = entry( p );
+    add( e.calls, 1 );
+    add( e.nanoseconds, nanoseconds( elapsed ));
+}
+
+
+void add_bytes( phase p, std::size_t bytes ) {
+    add( entry( p ).bytes, bytes );
+}
+
+
+void add_keywords( phase p, std::size_t count ) {
+    add( entry( p ).keywords, count );
+}
+
+
+void add_allocations( phase p, std::size_t count ) {
+    add( entry( p ).allocations, count );
+}
+
+
+void add_write( phase p, std::chrono::steady_clock::duration elapsed, std::size_t keywords ) {
+    auto& e = entry( p );
+    add( e.write_nanoseconds, nanoseconds( elapsed ));
+    add( e.keywords, keywords );
+}
+
+}
+}
+}
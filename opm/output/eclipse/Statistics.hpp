@@ -0,0 +1,171 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_STATISTICS_HPP
+#define OPM_OUTPUT_STATISTICS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <iosfwd>
+#include <string>
+
+namespace Opm {
+namespace out {
+namespace statistics {
+
+    /*
+      Process wide counters for the main output operations, to see how
+      much of the run time goes to output without a profiler. The
+      counters are always compiled in; updating a counter is a relaxed
+      atomic add, so the counters can be updated from the asynchronous
+      writer thread and the parallel INIT and EGRID writers.
+
+      For every phase the following is counted:
+
+        calls:         number of completed calls, also the ones which
+                       threw an exception.
+        seconds:       wall time spent in the calls.
+        write_seconds: the part of seconds spent in the calls which
+                       write to the file, i.e. ecl_kw_fwrite(),
+                       fortio_fwrite_record() and the ERT functions
+                       which write keywords on their own. The rest is
+                       spent evaluating and converting the data.
+        bytes:         bytes written to - or for restart_load decoded
+                       from - the files. The bytes of the keywords which
+                       ERT writes on its own, e.g. the restart header and
+                       the grid keywords, are included.
+        keywords:      keywords written or read by the output layer
+                       itself; for RFT one per well, and the keywords
+                       written by ERT on its own are not counted.
+        allocations:   heap buffers for keyword data which the output
+                       layer allocates itself: the ERT keywords it fills
+                       (ERT::EclKW, ecl_kw_alloc()), the serialized well
+                       vectors of the restart file, the vectors the
+                       restart data is loaded into, and the RFT and
+                       staging buffers when they have to grow. The
+                       allocations inside ERT, e.g. of the RFT nodes and
+                       of the summary data, and small bookkeeping
+                       allocations like map nodes are not counted.
+
+      The stage phase is the copy of the time step into the staging
+      area of the asynchronous writer, including the wait for a free
+      buffer; the buffers are reused, so after the first time steps it
+      should not allocate.
+
+      The counters are shared by all EclipseIO instances in the
+      process.
+    */
+
+    enum class phase {
+        summary_add_timestep,
+        summary_write,
+        restart_save,
+        restart_load,
+        rft_write,
+        init_write,
+        egrid_write,
+        stage,
+    };
+
+    const std::size_t num_phases = 8;
+
+    struct counters {
+        std::size_t calls = 0;
+        double seconds = 0.0;
+        double write_seconds = 0.0;
+        std::size_t bytes = 0;
+        std::size_t keywords = 0;
+        std::size_t allocations = 0;
+    };
+
+    const char* name( phase );
+    counters get( phase );
+    void reset();
+
+    /*
+      The counters of all the phases as one JSON object keyed by the
+      phase names, e.g.
+
+        { "restart_save": { "calls": 10, "seconds": 1.25, "write_seconds": 0.5,
+                            "bytes": 1048576, "keywords": 90, "allocations": 90 }, ... }
+    */
+    void write_json( std::ostream& );
+    std::string json();
+
+    void add_call( phase, std::chrono::steady_clock::duration );
+    void add_bytes( phase, std::size_t bytes );
+    void add_keywords( phase, std::size_t count = 1 );
+    void add_allocations( phase, std::size_t count = 1 );
+    void add_write( phase, std::chrono::steady_clock::duration, std::size_t keywords = 1 );
+
+    /*
+      Adds one call and the time from construction to destruction to
+      the phase.
+    */
+    class scoped_timer {
+    public:
+        explicit scoped_timer( phase p ) :
+            timed( p ),
+            start( std::chrono::steady_clock::now() )
+        {}
+
+        ~scoped_timer() {
+            add_call( this->timed, std::chrono::steady_clock::now() - this->start );
+        }
+
+        scoped_timer( const scoped_timer& ) = delete;
+        scoped_timer& operator=( const scoped_timer& ) = delete;
+
+    private:
+        phase timed;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    /*
+      Adds the time from construction to destruction to write_seconds
+      of the phase, and counts the keywords written in that scope. The
+      scope should only hold the write call itself; the writes ERT does
+      of keywords on its own are timed with keywords = 0.
+    */
+    class scoped_write {
+    public:
+        explicit scoped_write( phase p, std::size_t kw = 1 ) :
+            timed( p ),
+            keywords( kw ),
+            start( std::chrono::steady_clock::now() )
+        {}
+
+        ~scoped_write() {
+            add_write( this->timed, std::chrono::steady_clock::now() - this->start, this->keywords );
+        }
+
+        scoped_write( const scoped_write& ) = delete;
+        scoped_write& operator=( const scoped_write& ) = delete;
+
+    private:
+        phase timed;
+        std::size_t keywords;
+        std::chrono::steady_clock::time_point start;
+    };
+
+}
+}
+}
+
+#endif //OPM_OUTPUT_STATISTICS_HPP
@@ -17,7 +17,12 @@
   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <exception>
 #include <numeric>
+#include <set>
+#include <stdexcept>
+#include <string>
 
 #include <opm/common/OpmLog/OpmLog.hpp>
 
@@ -25,17 +30,26 @@
 #include <opm/parser/eclipse/EclipseState/Grid/GridProperty.hpp>
 #include <opm/parser/eclipse/EclipseState/IOConfig/IOConfig.hpp>
 #include <opm/parser/eclipse/EclipseState/Runspec.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/Events.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Group.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/GroupTree.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Well.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/WellProductionProperties.hpp>
 #include <opm/parser/eclipse/EclipseState/SummaryConfig/SummaryConfig.hpp>
 #include <opm/parser/eclipse/Units/UnitSystem.hpp>
 
+#include <opm/output/data/IndexedWells.hpp>
+#include <opm/output/eclipse/HydrocarbonPoreVolume.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
+#include <opm/output/eclipse/Parallel.hpp>
+#include <opm/output/eclipse/Statistics.hpp>
 #include <opm/output/eclipse/Summary.hpp>
 #include <opm/output/eclipse/RegionCache.hpp>
+#include <opm/output/eclipse/RegionReduction.hpp>
 
 #include <ert/ecl/ecl_smspec.h>
+#include <ert/ecl/ecl_sum_tstep.h>
 #include <ert/ecl/ecl_kw_magic.h>
 
 /*
@@ -150,19 +164,27 @@ quantity operator-( double lhs, const quantity& rhs ) {
  * and functions use whatever information they care about.
  *
  * schedule_wells are wells from the deck, provided by opm-parser. active_index
- * is the index of the block in question. wells is simulation data.
+ * is the index of the block in question. wells is simulation data, indexed
+ * once per timestep so the well and completion lookups are O(1). well_rows
+ * are the rows of the schedule_wells with results in wells.well_rates(), and
+ * completion_rows are the rows of the completions in region num in
+ * wells.completion_rates(). region_values holds the per region sums of the
+ * solution fields, evaluated once per timestep for all the region vectors.
  */
 struct fn_args {
     const std::vector< const Well* >& schedule_wells;
     double duration;
     size_t timestep;
     int  num;
-    const data::Wells& wells;
+    const data::IndexedWells& wells;
+    const data::RatesTable::rows& well_rows;
+    const data::RatesTable::rows& completion_rows;
     const data::Solution& state;
     const out::RegionCache& regionCache;
+    const out::RegionReduction& region_values;
     const EclipseGrid& grid;
     double initial_oip;
-    const std::vector<double>& pv;
+    const out::HydrocarbonPoreVolume& hcpv;
 };
 
 /* Since there are several enums in opm scattered about more-or-less
@@ -194,17 +216,11 @@ measure rate_unit< rt::reservoir_gas >() { return measure::rate; }
 
 template< rt phase, bool injection = true >
 inline quantity rate( const fn_args& args ) {
-    double sum = 0.0;
-
-    for( const auto* sched_well : args.schedule_wells ) {
-        const auto& name = sched_well->name();
-        if( args.wells.count( name ) == 0 ) continue;
-        const auto v = args.wells.at( name ).rates.get( phase, 0.0 );
-        if( ( v > 0 ) == injection )
-            sum += v;
-    }
+    const auto& table = args.wells.well_rates();
+    const double sum = injection
+                     ? table.injected( phase, args.well_rows )
+                     : table.produced( phase, args.well_rows );
 
-    if( !injection ) sum *= -1;
     return { sum, rate_unit< phase >() };
 }
 
@@ -213,10 +229,10 @@ inline quantity flowing( const fn_args& args ) {
     const auto& wells = args.wells;
     const auto ts = args.timestep;
     auto pred = [&wells,ts]( const Well* w ) {
-        const auto& name = w->name();
-        return w->isInjector( ts ) == injection
-            && wells.count( name ) > 0
-            && wells.at( name ).flowing();
+        if( w->isInjector( ts ) != injection ) return false;
+
+        const auto id = wells.id( w->name() );
+        return id != data::IndexedWells::npos && wells.flowing( id );
     };
 
     return { double( std::count_if( args.schedule_wells.begin(),
@@ -236,18 +252,12 @@ inline quantity crate( const fn_args& args ) {
     const auto active_index = args.grid.activeIndex( global_index );
     if( args.schedule_wells.empty() ) return zero;
 
-    const auto& name = args.schedule_wells.front()->name();
-    if( args.wells.count( name ) == 0 ) return zero;
+    const auto id = args.wells.id( args.schedule_wells.front()->name() );
+    if( id == data::IndexedWells::npos ) return zero;
 
-    const auto& well = args.wells.at( name );
-    const auto& completion = std::find_if( well.completions.begin(),
-                                           well.completions.end(),
-                                           [=]( const data::Completion& c ) {
-                                                return c.index == active_index;
-                                           } );
-
-    if( completion == well.completions.end() ) return zero;
-    const auto v = completion->rates.get( phase, 0.0 );
+    const auto row = args.wells.completion_row( id, active_index );
+    if( row == data::IndexedWells::no_row ) return zero;
+    const auto v = args.wells.completion_rates().get( row, phase, 0.0 );
     if( ( v > 0 ) != injection ) return zero;
 
     if( !injection ) return { -v, rate_unit< phase >() };
@@ -258,20 +268,20 @@ inline quantity bhp( const fn_args& args ) {
     const quantity zero = { 0, measure::pressure };
     if( args.schedule_wells.empty() ) return zero;
 
-    const auto p = args.wells.find( args.schedule_wells.front()->name() );
-    if( p == args.wells.end() ) return zero;
+    const auto id = args.wells.id( args.schedule_wells.front()->name() );
+    if( id == data::IndexedWells::npos ) return zero;
 
-    return { p->second.bhp, measure::pressure };
+    return { args.wells.bhp( id ), measure::pressure };
 }
 
 inline quantity thp( const fn_args& args ) {
     const quantity zero = { 0, measure::pressure };
     if( args.schedule_wells.empty() ) return zero;
 
-    const auto p = args.wells.find( args.schedule_wells.front()->name() );
-    if( p == args.wells.end() ) return zero;
+    const auto id = args.wells.id( args.schedule_wells.front()->name() );
+    if( id == data::IndexedWells::npos ) return zero;
 
-    return { p->second.thp, measure::pressure };
+    return { args.wells.thp( id ), measure::pressure };
 }
 
 inline quantity bhp_history( const fn_args& args ) {
@@ -382,68 +392,22 @@ inline quantity duration( const fn_args& args ) {
 
 template<rt phase , bool injection>
 quantity region_rate( const fn_args& args ) {
-    double sum = 0;
-    const auto& well_completions = args.regionCache.completions( args.num );
-    for (const auto& pair : well_completions) {
-        double rate = args.wells.get( pair.first , pair.second , phase );
-
-        // We are asking for the production rate in an injector - or
-        // opposite. We just clamp to zero.
-        if ((rate > 0) != injection)
-            rate = 0;
-
-        sum += rate;
-    }
+    // We are asking for the production rate in an injector - or
+    // opposite. The sign based reductions clamp those to zero.
+    const auto& table = args.wells.completion_rates();
+    const double sum = injection
+                     ? table.injected( phase, args.completion_rows )
+                     : table.produced( phase, args.completion_rows );
 
-    if( injection )
-        return { sum, rate_unit< phase >() };
-    else
-        return { -sum, rate_unit< phase >() };
+    return { sum, rate_unit< phase >() };
 }
 
 quantity region_sum( const fn_args& args , const std::string& keyword , UnitSystem::measure unit) {
-    const auto& cells = args.regionCache.cells( args.num );
-    if (cells.empty())
-        return { 0.0 , unit };
-
-    double sum = 0;
-
-    if( args.state.count( keyword ) == 0 )
-        return { 0.0, unit };
-
-    const std::vector<double>& sim_value = args.state.data( keyword );
-    if (sim_value.size() != args.grid.getNumActive()) {
-      std::stringstream str;
-      str << "Wrongly sized data array passed to output for keyword "
-          << keyword << ", size=" << sim_value.size() << ", expected=" << args.grid.getNumActive() << ".";
-      throw std::runtime_error(str.str());
-    }
-
-
-    for (auto cell_index : cells)
-        sum += sim_value[cell_index];
-
-    return { sum , unit };
+    return { args.region_values.sum( keyword, args.num ), unit };
 }
 
 quantity fpr( const fn_args& args ) {
-    if( !args.state.has( "PRESSURE" ) )
-        return { 0.0, measure::pressure };
-
-    const auto& p = args.state.data( "PRESSURE" );
-    const auto& pv = args.pv;
-    const bool hasSwat = args.state.has( "SWAT" );
-    const auto& swat = hasSwat? args.state.data( "SWAT" ): std::vector<double>(p.size(),0.0);
-    double fpr = 0.0;
-    double sum_hcpv = 0.0;
-    for (size_t cell_index = 0; cell_index < p.size(); ++cell_index) {
-        double hcs= 1.0;
-        hcs -= swat[cell_index];
-        double hcpv = pv[cell_index]*hcs;
-        fpr +=  hcpv * p[cell_index];
-        sum_hcpv += hcpv;
-    }
-    return { fpr / sum_hcpv, measure::pressure };
+    return { args.hcpv.pressure(), measure::pressure };
 }
 
 quantity rpr(const fn_args& args) {
@@ -455,21 +419,7 @@ quantity rpr(const fn_args& args) {
     if( !args.state.has( "PRESSURE" ) )
         return { 0.0, measure::pressure };
 
-    const auto& p = args.state.data( "PRESSURE" );
-    const auto& pv = args.pv;
-    const bool hasSwat = args.state.has( "SWAT" );
-
-    const auto& swat = hasSwat? args.state.data( "SWAT" ): std::vector<double>(cells.size(),0.0);
-    double rpr = 0.0;
-    double sum_hcpv = 0.0;
-    for (auto cell_index : cells) {
-        double hcs= 1.0;
-        hcs -= swat[cell_index];
-        double hcpv = pv[cell_index]*hcs;
-        rpr +=  hcpv * p[cell_index];
-        sum_hcpv += hcpv;
-    }
-    return { rpr / sum_hcpv, measure::pressure };
+    return { args.region_values.pressure( args.num ), measure::pressure };
 }
 
 quantity roip(const fn_args& args) {
@@ -907,13 +857,33 @@ static const std::unordered_map< std::string, UnitSystem::measure> misc_units =
   {"TELAPLIN" , UnitSystem::measure::time }
 };
 
+/*
+  The field vectors which are evaluated by summing a solution field over
+  all the active cells.
+*/
+static const std::set< std::string > cell_reductions = {
+    "FOIP", "FOIPL", "FGIP", "FGIPG", "FWIP", "FOE"
+};
+
+/*
+  The solution fields summed by the region vectors; they are registered
+  with the RegionReduction when the vectors are set up.
+*/
+static const std::unordered_map< std::string, std::string > region_fields = {
+    { "ROIP",  "OIP"  },
+    { "ROIPL", "OIPL" },
+    { "ROIPG", "OIPG" },
+    { "RGIP",  "GIP"  },
+    { "RGIPL", "GIPL" },
+    { "RGIPG", "GIPG" },
+    { "RWIP",  "WIP"  },
+};
+
 inline std::vector< const Well* > find_wells( const Schedule& schedule,
-                                              const smspec_node_type* node,
+                                              ecl_smspec_var_type type,
+                                              const char* name,
                                               size_t timestep ) {
 
-    const auto* name = smspec_node_get_wgname( node );
-    const auto type = smspec_node_get_var_type( node );
-
     if( type == ECL_SMSPEC_WELL_VAR || type == ECL_SMSPEC_COMPLETION_VAR ) {
         const auto* well = schedule.getWell( name );
         if( !well ) return {};
@@ -932,17 +902,280 @@ inline std::vector< const Well* > find_wells( const Schedule& schedule,
     return {};
 }
 
+/*
+  The wells of a group only change when a well or a group is added, a
+  well is moved to another group (WELSPECS), or the group hierarchy is
+  changed (GRUPTREE).
+*/
+inline bool group_wells_changed( const Schedule& schedule,
+                                 size_t from_step,
+                                 size_t to_step ) {
+    if( to_step < from_step )
+        return true;
+
+    const uint64_t mask = ScheduleEvents::NEW_WELL
+                        | ScheduleEvents::NEW_GROUP
+                        | ScheduleEvents::GROUP_CHANGE;
+
+    const auto& events = schedule.getEvents();
+    for( size_t step = from_step + 1; step <= to_step; step++ )
+        if( events.hasEvent( mask, step ) ) return true;
+
+    return schedule.getGroupTree( from_step ) != schedule.getGroupTree( to_step );
+}
+
 }
 
 namespace out {
 
+/*
+  The keyword_handlers class holds the compiled evaluation plan for the
+  summary vectors. Everything which can be determined up front - the
+  evaluation function, the NUMS value, the unit conversion, whether
+  the vector is a total and where the previous value is found - is
+  resolved once in the Summary constructor, and the add_timestep()
+  method is then a tight loop over the ops vector.
+
+  The lists of schedule wells are shared between all the nodes with
+  the same (var_type, wgname) key, i.e. all the group vectors for
+  group G use the same list. The lists for well, completion and field
+  vectors do not depend on the report step and are resolved in the
+  constructor. The lists for group vectors depend on the report step;
+  when add_timestep() is called for a new report step update_wells()
+  looks at the schedule events since the lists were resolved, and
+  only resolves them again if wells or groups have been added or the
+  group membership has changed.
+
+  The well results are indexed once per timestep, and index_wells()
+  then translates each well list, and the completions of each region
+  used by a region vector, to rows in the rate tables of the indexed
+  wells. The rate evaluators are thereby reductions over index sets.
+
+  The evaluators only read their arguments, so the nodes can be
+  evaluated in parallel, see Summary::setEvaluationThreads(). The nodes
+  are split in contiguous ranges of roughly the same estimated cost,
+  one range per thread, and the values are stored in values; the
+  totals and the writing to the ert timestep are done afterwards in
+  node order on the calling thread. Every node is evaluated by the
+  same code whatever the number of threads, so the results are bit
+  identical to the serial evaluation.
+*/
+
 class Summary::keyword_handlers {
     public:
-        using fn = ofun;
-        std::vector< std::pair< smspec_node_type*, fn > > handlers;
+        struct node_op {
+            smspec_node_type* node;
+            const ofun* eval;
+            int num;
+            int well_list;        // index in well_lists
+            int region;           // index in region_rows, or -1
+            bool total;
+            double scale;         // output = scale * si_value + offset
+            double offset;
+            size_t cells;         // cells reduced by the evaluator
+        };
+
+        std::vector< node_op > ops;
+        std::vector< std::vector< const Well* > > well_lists;
+        std::vector< data::RatesTable::rows > well_rows;
+        std::vector< data::RatesTable::rows > region_rows;
         std::map< std::string, smspec_node_type* > misc_nodes;
+
+        int well_list( const Schedule& schedule, ecl_smspec_var_type type, const char* wgname );
+        int region( int region_id );
+        void update_wells( const Schedule& schedule, size_t report_step );
+        void index_wells( const data::IndexedWells& wells, const RegionCache& regionCache );
+
+        size_t cost( const node_op& op ) const;
+        void partition( size_t num_parts );
+        double seed_totals( const std::string& restart_case, int report_step );
+
+        /* the si value of each op, and the first op of each range */
+        std::vector< double > values;
+        std::vector< size_t > bounds;
+
+        /* the running total of each op, in output units; only used for total vectors */
+        std::vector< double > totals;
+
+    private:
+        std::map< int, int > region_index;
+        std::vector< int > regions;
+        std::map< std::pair< int, std::string >, int > well_list_index;
+        std::vector< std::pair< std::string, int > > group_lists;
+        size_t wells_step = 0;
 };
 
+
+int Summary::keyword_handlers::well_list( const Schedule& schedule,
+                                          ecl_smspec_var_type type,
+                                          const char* wgname ) {
+
+    if( type == ECL_SMSPEC_COMPLETION_VAR )
+        type = ECL_SMSPEC_WELL_VAR;
+
+    const bool named = type == ECL_SMSPEC_WELL_VAR || type == ECL_SMSPEC_GROUP_VAR;
+    const auto key = std::make_pair( int( type ), std::string( named ? wgname : "" ) );
+    const auto iter = this->well_list_index.find( key );
+    if( iter != this->well_list_index.end() )
+        return iter->second;
+
+    const int index = this->well_lists.size();
+    this->well_lists.push_back( find_wells( schedule, type, wgname, this->wells_step ) );
+    this->well_list_index.emplace( key, index );
+
+    if( type == ECL_SMSPEC_GROUP_VAR )
+        this->group_lists.emplace_back( key.second, index );
+
+    return index;
+}
+
+
+int Summary::keyword_handlers::region( int region_id ) {
+    const auto iter = this->region_index.find( region_id );
+    if( iter != this->region_index.end() )
+        return iter->second;
+
+    const int index = this->regions.size();
+    this->regions.push_back( region_id );
+    this->region_rows.emplace_back();
+    this->region_index.emplace( region_id, index );
+    return index;
+}
+
+
+void Summary::keyword_handlers::update_wells( const Schedule& schedule, size_t report_step ) {
+    if( report_step == this->wells_step )
+        return;
+
+    if( this->group_lists.empty()
+        || !group_wells_changed( schedule, this->wells_step, report_step ) ) {
+        this->wells_step = report_step;
+        return;
+    }
+
+    for( const auto& group : this->group_lists )
+        this->well_lists[ group.second ] = find_wells( schedule,
+                                                       ECL_SMSPEC_GROUP_VAR,
+                                                       group.first.c_str(),
+                                                       report_step );
+
+    this->wells_step = report_step;
+}
+
+
+void Summary::keyword_handlers::index_wells( const data::IndexedWells& wells,
+                                             const RegionCache& regionCache ) {
+    this->well_rows.resize( this->well_lists.size() );
+    for( size_t list = 0; list < this->well_lists.size(); list++ ) {
+        auto& rows = this->well_rows[ list ];
+        rows.clear();
+
+        for( const auto* sched_well : this->well_lists[ list ] ) {
+            const auto id = wells.id( sched_well->name() );
+            if( id != data::IndexedWells::npos )
+                rows.push_back( id );
+        }
+    }
+
+    for( size_t index = 0; index < this->regions.size(); index++ ) {
+        auto& rows = this->region_rows[ index ];
+        rows.clear();
+
+        for( const auto& pair : regionCache.completions( this->regions[ index ] ) ) {
+            const auto row = wells.completion_row( wells.id( pair.first ), pair.second );
+            if( row != data::IndexedWells::no_row )
+                rows.push_back( row );
+        }
+    }
+}
+
+/*
+  The estimated cost of evaluating op: the rate reductions are linear
+  in the number of wells and completions, and the field in place
+  vectors sum the solution over all the cells.
+*/
+size_t Summary::keyword_handlers::cost( const node_op& op ) const {
+    size_t cost = 1 + op.cells;
+    cost += this->well_lists[ op.well_list ].size();
+    cost += this->well_rows[ op.well_list ].size();
+    if( op.region >= 0 )
+        cost += this->region_rows[ op.region ].size();
+
+    return cost;
+}
+
+
+void Summary::keyword_handlers::partition( size_t num_parts ) {
+    const auto num_ops = this->ops.size();
+    this->bounds.assign( num_parts + 1, num_ops );
+    this->bounds[ 0 ] = 0;
+
+    size_t total = 0;
+    for( const auto& op : this->ops )
+        total += this->cost( op );
+
+    size_t acc = 0;
+    size_t part = 1;
+    for( size_t i = 0; i < num_ops && part < num_parts; i++ ) {
+        acc += this->cost( this->ops[ i ] );
+        while( part < num_parts && acc * num_parts >= total * part )
+            this->bounds[ part++ ] = i + 1;
+    }
+}
+
+/*
+  The restart case is given relative to the output directory, the same
+  way IOConfig::getRestartFileName() locates the restart file.
+*/
+inline std::string restart_case_path( const IOConfig& io_config, const std::string& root_name ) {
+    const auto& output_dir = io_config.getOutputDir();
+    if( output_dir.empty() || root_name.empty() || root_name[0] == '/' )
+        return root_name;
+
+    return output_dir + "/" + root_name;
+}
+
+/*
+  The total vectors continue from their values at the restart step in
+  the summary of the restart case; the return value is the simulated
+  time in seconds at the restart step. When the summary of the restart
+  case, or the restart step in it, is missing, the run can still go on
+  with totals which start from zero, so that is only a warning. Without
+  total vectors there is nothing to seed, and the restart case is not
+  read.
+*/
+double Summary::keyword_handlers::seed_totals( const std::string& restart_case, int report_step ) {
+    const auto is_total = []( const node_op& op ) { return op.total; };
+    if( std::none_of( this->ops.begin(), this->ops.end(), is_total ) )
+        return 0;
+
+    ERT::ert_unique_ptr< ecl_sum_type, ecl_sum_free > restart( ecl_sum_fread_alloc_case( restart_case.c_str(), ":" ) );
+    if( !restart ) {
+        OpmLog::warning( "Could not load the summary of restart case " + restart_case
+                         + " - the total vectors start from zero" );
+        return 0;
+    }
+
+    if( !ecl_sum_has_report_step( restart.get(), report_step ) ) {
+        OpmLog::warning( "The summary of restart case " + restart_case
+                         + " does not have report step " + std::to_string( report_step )
+                         + " - the total vectors start from zero" );
+        return 0;
+    }
+
+    const auto time_index = ecl_sum_iget_report_end( restart.get(), report_step );
+    for( size_t i = 0; i < this->ops.size(); i++ ) {
+        const auto& op = this->ops[ i ];
+        if( !op.total ) continue;
+
+        const char* key = smspec_node_get_gen_key1( op.node );
+        if( key && ecl_sum_has_general_var( restart.get(), key ) )
+            this->totals[ i ] = ecl_sum_get_general_var( restart.get(), time_index, key );
+    }
+
+    return ecl_sum_iget_sim_days( restart.get(), time_index ) * 86400;
+}
+
 Summary::Summary( const EclipseState& st,
                   const SummaryConfig& sum ,
                   const EclipseGrid& grid_arg,
@@ -965,8 +1198,10 @@ Summary::Summary( const EclipseState& st,
                   const char* basename ) :
     grid( grid_arg ),
     regionCache( st.get3DProperties( ) , grid_arg, schedule ),
+    regionValues( regionCache, "FIPNUM", grid_arg.getNumActive() ),
     handlers( new keyword_handlers() ),
-    porv( st.get3DProperties().getDoubleGridProperty("PORV").compressedCopy(grid_arg))
+    porv( st.get3DProperties().getDoubleGridProperty("PORV").compressedCopy(grid_arg)),
+    writer( basename, st.getIOConfig().getUNIFOUT(), st.getIOConfig().getFMTOUT() )
 {
 
     const auto& init_config = st.getInitConfig();
@@ -1028,35 +1263,73 @@ Summary::Summary( const EclipseState& st,
             }
 
             /* get unit strings by calling each function with dummy input */
-            const auto handle = funs.find( keyword )->second;
+            const auto& handle = funs.find( keyword )->second;
             const std::vector< const Well* > dummy_wells;
+            const data::IndexedWells dummy_results;
+            const data::RatesTable::rows dummy_rows;
+            const out::RegionReduction dummy_region_values;
 
             const fn_args no_args { dummy_wells, // Wells from Schedule object
                                     0,           // Duration of time step
                                     0,           // Timestep number
                                     node.num(),  // NUMS value for the summary output.
-                                    {},          // Well results - data::Wells
+                                    dummy_results, // Well results
+                                    dummy_rows,  // Rows of the wells in the results
+                                    dummy_rows,  // Rows of the region completions
                                     {},          // Solution::State
                                     {},          // Region <-> cell mappings.
+                                    dummy_region_values,
                                     this->grid,
                                     this->initial_oip,
                                     {} };
 
             const auto val = handle( no_args );
+            const auto& units = st.getUnits();
 
 	    auto* nodeptr = ecl_sum_add_var( this->ecl_sum.get(),
 					     keyword,
 					     node.wgname(),
 					     node.num(),
-					     st.getUnits().name( val.unit ),
+					     units.name( val.unit ),
 					     0 );
 
-	    this->handlers->handlers.emplace_back( nodeptr, handle );
+            keyword_handlers::node_op op;
+            op.node = nodeptr;
+            op.eval = &handle;
+            op.num = node.num();
+            op.well_list = this->handlers->well_list( schedule, node.type(), node.wgname() );
+            op.region = node.type() == ECL_SMSPEC_REGION_VAR
+                      ? this->handlers->region( node.num() )
+                      : -1;
+
+            if( node.type() == ECL_SMSPEC_REGION_VAR ) {
+                const auto field = region_fields.find( keyword );
+                if( field != region_fields.end() )
+                    this->regionValues.addField( field->second );
+                else if( std::string( keyword ) == "RPR" ) {
+                    this->regionValues.addPressure();
+                    this->with_hcpv = true;
+                }
+            }
+            if( std::string( keyword ) == "FPR" )
+                this->with_hcpv = true;
+
+            op.total = smspec_node_is_total( nodeptr );
+            op.offset = units.from_si( val.unit, 0.0 );
+            op.scale = units.from_si( val.unit, 1.0 ) - op.offset;
+            op.cells = cell_reductions.count( keyword ) ? grid_arg.getNumActive() : 0;
+
+	    this->handlers->ops.push_back( op );
 	}
     }
     for ( const auto& keyword : unsupported_keywords ) {
         Opm::OpmLog::info("Keyword " + std::string(keyword) + " is unhandled");
     }
+
+    this->handlers->totals.assign( this->handlers->ops.size(), 0.0 );
+    if( init_config.restartRequested() )
+        this->prev_time_elapsed = this->handlers->seed_totals( restart_case_path( st.getIOConfig(), init_config.getRestartRootName() ),
+                                                               init_config.getRestartStep() );
 }
 
 void Summary::add_timestep( int report_step,
@@ -1066,33 +1339,91 @@ void Summary::add_timestep( int report_step,
                             const data::Wells& wells ,
                             const data::Solution& state,
                             const std::map<std::string, double>& misc_values) {
+    this->add_timestep( report_step,
+                        secs_elapsed,
+                        es,
+                        schedule,
+                        data::IndexedWells( wells ),
+                        state,
+                        misc_values );
+}
 
+void Summary::add_timestep( int report_step,
+                            double secs_elapsed,
+                            const EclipseState& es,
+                            const Schedule& schedule,
+                            const data::IndexedWells& indexed_wells,
+                            const data::Solution& state,
+                            const std::map<std::string, double>& misc_values) {
+
+    out::statistics::scoped_timer timer( out::statistics::phase::summary_add_timestep );
     auto* tstep = ecl_sum_add_tstep( this->ecl_sum.get(), report_step, secs_elapsed );
     const double duration = secs_elapsed - this->prev_time_elapsed;
     const size_t timestep = report_step;
 
-    for( auto& f : this->handlers->handlers ) {
-        const int num = smspec_node_get_num( f.first );
-        const auto* genkey = smspec_node_get_gen_key1( f.first );
-
-        const auto schedule_wells = find_wells( schedule, f.first, timestep );
-        const auto val = f.second( { schedule_wells,
-                                     duration,
-                                     timestep,
-                                     num,
-                                     wells,
-                                     state,
-                                     this->regionCache,
-                                     this->grid,
-                                     this->initial_oip,
-                                     this->porv});
-
-        const auto unit_applied_val = es.getUnits().from_si( val.unit, val.value );
-        const auto res = smspec_node_is_total( f.first ) && prev_tstep
-            ? ecl_sum_tstep_get_from_key( prev_tstep, genkey ) + unit_applied_val
+    this->handlers->update_wells( schedule, timestep );
+    this->handlers->index_wells( indexed_wells, this->regionCache );
+
+    if( this->with_hcpv )
+        this->hcpv.update( this->porv, state );
+
+    if( !this->regionValues.empty() )
+        this->regionValues.update( state, this->hcpv );
+
+    const data::RatesTable::rows no_rows;
+
+    auto& handlers = *this->handlers;
+    auto evaluate = [&]( size_t begin, size_t end ) {
+        for( auto i = begin; i < end; i++ ) {
+            const auto& op = handlers.ops[ i ];
+            const auto val = (*op.eval)( { handlers.well_lists[ op.well_list ],
+                                           duration,
+                                           timestep,
+                                           op.num,
+                                           indexed_wells,
+                                           handlers.well_rows[ op.well_list ],
+                                           op.region < 0 ? no_rows : handlers.region_rows[ op.region ],
+                                           state,
+                                           this->regionCache,
+                                           this->regionValues,
+                                           this->grid,
+                                           this->initial_oip,
+                                           this->hcpv});
+            handlers.values[ i ] = val.value;
+        }
+    };
+
+    const auto num_ops = handlers.ops.size();
+    const auto nt = std::min( this->eval_threads, num_ops );
+    if( handlers.values.capacity() < num_ops )
+        out::statistics::add_allocations( out::statistics::phase::summary_add_timestep );
+    handlers.values.resize( num_ops );
+
+    if( nt > 1 ) {
+        handlers.partition( nt );
+        std::vector< std::exception_ptr > errors( nt );
+        out::parallel::run( nt, [&]( size_t t ) {
+            try {
+                evaluate( handlers.bounds[ t ], handlers.bounds[ t + 1 ] );
+            } catch( ... ) {
+                errors[ t ] = std::current_exception();
+            }
+        });
+
+        for( const auto& error : errors )
+            if( error ) std::rethrow_exception( error );
+    } else {
+        evaluate( 0, num_ops );
+    }
+
+    for( size_t i = 0; i < num_ops; i++ ) {
+        const auto& op = handlers.ops[ i ];
+        const auto unit_applied_val = op.scale * handlers.values[ i ] + op.offset;
+        const auto res = op.total
+            ? handlers.totals[ i ] += unit_applied_val
             : unit_applied_val;
 
-	ecl_sum_tstep_set_from_node( tstep, f.first, res );
+	ecl_sum_tstep_set_from_node( tstep, op.node, res );
     }
 
 
@@ -1108,8 +1439,8 @@ void Summary::add_timestep( int report_step,
 	}
     }
 
-    this->prev_tstep = tstep;
     this->prev_time_elapsed = secs_elapsed;
+    this->unwritten.push_back( tstep );
 }
 
 void Summary::set_initial( const data::Solution& sol ) {
@@ -1119,8 +1450,65 @@ void Summary::set_initial( const data::Solution& sol ) {
     this->initial_oip = std::accumulate( cells.begin(), cells.end(), 0.0 );
 }
 
+/*
+  ecl_sum_fwrite() writes the SMSPEC file and all the time steps which
+  have been added so far, i.e. the cost of writing grows with the
+  length of the run. Here ERT is only used for the SMSPEC file, and the
+  new time steps are appended to the data file by the SummaryWriter.
+*/
 void Summary::write() {
-    ecl_sum_fwrite( this->ecl_sum.get() );
+    out::statistics::scoped_timer timer( out::statistics::phase::summary_write );
+    const auto params_size = ecl_smspec_get_params_size( ecl_sum_get_smspec( this->ecl_sum.get() ));
+    if( params_size != this->smspec_params ) {
+        /*
+          The PARAMS records already in the data file have the old
+          length; a new SMSPEC file would not describe them.
+        */
+        if( !this->writer.filename().empty() )
+            throw std::logic_error( "The number of summary vectors changed from "
+                                    + std::to_string( this->smspec_params ) + " to "
+                                    + std::to_string( params_size )
+                                    + " after time steps were written to "
+                                    + this->writer.filename() );
+
+        {
+            out::statistics::scoped_write write( out::statistics::phase::summary_write, 0 );
+            ecl_sum_fwrite_smspec( this->ecl_sum.get() );
+        }
+        this->smspec_params = params_size;
+    }
+
+    std::vector< float > params( params_size );
+    out::statistics::add_allocations( out::statistics::phase::summary_write );
+    for( const auto* tstep : this->unwritten ) {
+        for( int index = 0; index < params_size; index++ )
+            params[ index ] = ecl_sum_tstep_iget( tstep, index );
+
+        this->writer.append( ecl_sum_tstep_get_report( tstep ),
+                             ecl_sum_tstep_get_ministep( tstep ),
+                             params );
+    }
+
+    this->unwritten.clear();
+    this->writer.flush();
+
+    if( this->writer.unified()
+        && !this->writer.formatted()
+        && !this->writer.filename().empty()
+        && this->writer.flushPolicy() != SummaryWriter::flush_policy::none ) {
+        if( !this->index )
+            this->index.reset( new out::MappedEclFile::IndexWriter( this->writer.filename() ));
+
+        this->index->update();
+    }
+}
+
+void Summary::setFlushPolicy( SummaryWriter::flush_policy policy ) {
+    this->writer.setFlushPolicy( policy );
+}
+
+void Summary::setEvaluationThreads( size_t num_threads ) {
+    this->eval_threads = std::max< size_t >( 1, num_threads );
 }
 
 Summary::~Summary() {}
@@ -29,10 +29,15 @@
 
 #include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
 
+#include <opm/output/data/IndexedWells.hpp>
 #include <opm/output/data/Wells.hpp>
 #include <opm/output/data/Cells.hpp>
 #include <opm/output/data/Solution.hpp>
+#include <opm/output/eclipse/HydrocarbonPoreVolume.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
 #include <opm/output/eclipse/RegionCache.hpp>
+#include <opm/output/eclipse/RegionReduction.hpp>
+#include <opm/output/eclipse/SummaryWriter.hpp>
 
 namespace Opm {
 
@@ -58,8 +63,38 @@ class Summary {
                            const data::Solution&,
                            const std::map<std::string, double>& misc_values);
 
+        /*
+          As above, with the wells already indexed; the EclipseIO class
+          indexes the wells once per time step and shares them between
+          the summary and the restart output.
+        */
+        void add_timestep( int report_step,
+                           double secs_elapsed,
+                           const EclipseState& es,
+                           const Schedule& schedule,
+                           const data::IndexedWells&,
+                           const data::Solution&,
+                           const std::map<std::string, double>& misc_values);
+
         void set_initial( const data::Solution& );
+
+        /*
+          Write the time steps added since the previous call to
+          write(). The SMSPEC file is written on the first call and
+          the data file is appended to. The set of summary vectors can
+          not change once time steps have been written, the data file
+          would no longer match the SMSPEC file; that raises
+          std::logic_error. See SummaryWriter for the flush policy.
+        */
         void write();
+        void setFlushPolicy( SummaryWriter::flush_policy );
+
+        /*
+          Evaluate the summary vectors of a time step on num_threads
+          threads; the default is one, i.e. serial evaluation. The
+          results are bit identical to the serial evaluation.
+        */
+        void setEvaluationThreads( size_t num_threads );
 
         ~Summary();
 
@@ -68,12 +103,19 @@ class Summary {
 
         const EclipseGrid& grid;
         out::RegionCache regionCache;
+        out::RegionReduction regionValues;
         ERT::ert_unique_ptr< ecl_sum_type, ecl_sum_free > ecl_sum;
         std::unique_ptr< keyword_handlers > handlers;
-        const ecl_sum_tstep_type* prev_tstep = nullptr;
         double prev_time_elapsed = 0;
         double initial_oip = 0.0;
         const std::vector<double> porv;
+        out::HydrocarbonPoreVolume hcpv;
+        bool with_hcpv = false;
+        size_t eval_threads = 1;
+        std::vector< const ecl_sum_tstep_type* > unwritten;
+        int smspec_params = -1;
+        SummaryWriter writer;
+        std::unique_ptr< MappedEclFile::IndexWriter > index;
 };
 
 }
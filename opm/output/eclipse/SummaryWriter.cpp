@@ -0,0 +1,131 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cstdio>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include <opm/output/eclipse/Statistics.hpp>
+#include <opm/output/eclipse/SummaryWriter.hpp>
+
+#include <ert/ecl/EclKW.hpp>
+#include <ert/ecl/EclFilename.hpp>
+#include <ert/ecl/ecl_kw.h>
+#include <ert/ecl/ecl_kw_magic.h>
+#include <ert/ecl/ecl_util.h>
+
+namespace Opm {
+namespace out {
+
+SummaryWriter::SummaryWriter( const std::string& basename_arg,
+                              bool unified_arg,
+                              bool formatted_arg ) :
+    basename( basename_arg ),
+    unified_file( unified_arg ),
+    formatted_file( formatted_arg )
+{}
+
+
+/*
+  A unified file is opened - and truncated - for the first report
+  step, and then appended to for the rest of the run. Non unified
+  output gets a new file for each report step.
+*/
+void SummaryWriter::open( int report_step_arg ) {
+    if( this->unified_file && this->fortio ) return;
+
+    this->current_file = this->unified_file
+        ? ERT::EclFilename( this->basename, ECL_UNIFIED_SUMMARY_FILE, 0, this->formatted_file )
+        : ERT::EclFilename( this->basename, ECL_SUMMARY_FILE, report_step_arg, this->formatted_file );
+
+    this->fortio.reset( fortio_open_writer( this->current_file.c_str(),
+                                            this->formatted_file,
+                                            ECL_ENDIAN_FLIP ));
+    if( !this->fortio )
+        throw std::runtime_error( "Could not open summary file: " + this->current_file );
+}
+
+
+void SummaryWriter::append( int report_step_arg, int ministep, const std::vector< float >& params ) {
+    using out::statistics::phase;
+
+    const bool new_report_step = this->first_report_step || report_step_arg != this->report_step;
+    if( new_report_step )
+        this->open( report_step_arg );
+
+    const auto start_offset = fortio_ftell( this->fortio.get() );
+    if( new_report_step ) {
+        ERT::EclKW< int > seqhdr( SEQHDR_KW, std::vector< int >{ 0 });
+        out::statistics::add_allocations( phase::summary_write, 2 );
+        out::statistics::scoped_write write( phase::summary_write );
+        ecl_kw_fwrite( seqhdr.get(), this->fortio.get() );
+        this->report_step = report_step_arg;
+        this->first_report_step = false;
+    }
+
+    ERT::EclKW< int > ministep_kw( MINISTEP_KW, std::vector< int >{ ministep } );
+    ERT::EclKW< float > params_kw( PARAMS_KW, params );
+    out::statistics::add_allocations( phase::summary_write, 3 );
+    {
+        out::statistics::scoped_write write( phase::summary_write, 2 );
+        ecl_kw_fwrite( ministep_kw.get(), this->fortio.get() );
+        ecl_kw_fwrite( params_kw.get(), this->fortio.get() );
+    }
+
+    out::statistics::add_bytes( phase::summary_write, fortio_ftell( this->fortio.get() ) - start_offset );
+}
+
+
+void SummaryWriter::flush() {
+    if( !this->fortio || this->policy == flush_policy::none )
+        return;
+
+    fortio_fflush( this->fortio.get() );
+    if( this->policy == flush_policy::sync )
+        ::fsync( ::fileno( fortio_get_FILE( this->fortio.get() )));
+}
+
+
+void SummaryWriter::setFlushPolicy( flush_policy policy_arg ) {
+    this->policy = policy_arg;
+}
+
+
+SummaryWriter::flush_policy SummaryWriter::flushPolicy() const {
+    return this->policy;
+}
+
+
+bool SummaryWriter::unified() const {
+    return this->unified_file;
+}
+
+
+bool SummaryWriter::formatted() const {
+    return this->formatted_file;
+}
+
+
+const std::string& SummaryWriter::filename() const {
+    return this->current_file;
+}
+
+}
+}
@@ -0,0 +1,86 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_SUMMARY_WRITER_HPP
+#define OPM_OUTPUT_SUMMARY_WRITER_HPP
+
+#include <string>
+#include <vector>
+
+#include <ert/ecl/fortio.h>
+#include <ert/util/ert_unique_ptr.hpp>
+
+namespace Opm {
+namespace out {
+
+    /*
+      The SummaryWriter class writes the summary data - the UNSMRY
+      file, or one Snnnn file per report step - as a stream. Each call
+      to append() writes the MINISTEP and PARAMS keywords of one time
+      step, preceded by a SEQHDR keyword when a new report step starts.
+      The file is opened on the first append() and kept open, so the
+      cost of writing a time step does not grow with the number of time
+      steps already written. The SMSPEC file is not handled here.
+
+      The flush policy decides what the flush() method does:
+
+        none:  nothing, the data stays in the stdio buffer until it is
+               full or the file is closed.
+        flush: the stdio buffer is flushed, i.e. the data is visible
+               to other processes. This is the default.
+        sync:  as flush, and in addition the file is synced to disk
+               with fsync().
+    */
+
+    class SummaryWriter {
+    public:
+        enum class flush_policy { none, flush, sync };
+
+        SummaryWriter( const std::string& basename, bool unified, bool formatted );
+
+        void append( int report_step, int ministep, const std::vector< float >& params );
+        void flush();
+
+        void setFlushPolicy( flush_policy policy );
+        flush_policy flushPolicy() const;
+
+        bool unified() const;
+        bool formatted() const;
+
+        /// The current data file; empty before the first append().
+        const std::string& filename() const;
+
+    private:
+        void open( int report_step );
+
+        std::string basename;
+        bool unified_file;
+        bool formatted_file;
+        flush_policy policy = flush_policy::flush;
+
+        ERT::ert_unique_ptr< fortio_type, fortio_fclose > fortio;
+        std::string current_file;
+        int report_step = -1;
+        bool first_report_step = true;
+    };
+
+}
+}
+
+#endif //OPM_OUTPUT_SUMMARY_WRITER_HPP
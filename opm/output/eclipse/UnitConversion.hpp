@@ -0,0 +1,107 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OPM_OUTPUT_UNIT_CONVERSION_HPP
+#define OPM_OUTPUT_UNIT_CONVERSION_HPP
+
+#include <cstddef>
+#include <vector>
+
+#include <opm/parser/eclipse/Units/UnitSystem.hpp>
+
+namespace Opm {
+namespace out {
+
+    /*
+      The UnitConversion class converts SI values to the output unit
+      system and stores the result - typically narrowed to float - in
+      one pass over the data. All the unit conversions in UnitSystem
+      are affine, so the conversion for one measure is captured as
+
+          output = scale * si_value + offset
+
+      with scale and offset evaluated once from UnitSystem::from_si().
+      The conversion loop has no branches and no aliasing between input
+      and output, so it is vectorized by the compiler.
+
+      The default constructed object is the identity conversion, i.e.
+      only the narrowing to the output type.
+    */
+
+    class UnitConversion {
+    public:
+        UnitConversion() = default;
+        UnitConversion( const UnitSystem& units, UnitSystem::measure m ) :
+            offset( units.from_si( m, 0.0 ) ),
+            scale( units.from_si( m, 1.0 ) - offset )
+        {}
+
+        bool identity() const {
+            return this->scale == 1.0 && this->offset == 0.0;
+        }
+
+        template< typename T >
+        void apply( const double* input, std::size_t size, T* output ) const {
+            const double a = this->scale;
+            const double b = this->offset;
+
+            if( this->identity() ) {
+                for( std::size_t i = 0; i < size; i++ )
+                    output[ i ] = static_cast< T >( input[ i ] );
+            } else {
+                for( std::size_t i = 0; i < size; i++ )
+                    output[ i ] = static_cast< T >( a * input[ i ] + b );
+            }
+        }
+
+        /*
+          Convert the values input[ index[ i ] ], e.g. gather the active
+          cells of a global property, in the same pass.
+        */
+        template< typename T >
+        void gather( const double* input, const std::size_t* index,
+                     std::size_t size, T* output ) const {
+            const double a = this->scale;
+            const double b = this->offset;
+
+            if( this->identity() ) {
+                for( std::size_t i = 0; i < size; i++ )
+                    output[ i ] = static_cast< T >( input[ index[ i ] ] );
+            } else {
+                for( std::size_t i = 0; i < size; i++ )
+                    output[ i ] = static_cast< T >( a * input[ index[ i ] ] + b );
+            }
+        }
+
+        template< typename T >
+        std::vector< T > apply( const std::vector< double >& input ) const {
+            std::vector< T > output( input.size() );
+            this->apply( input.data(), input.size(), output.data() );
+            return output;
+        }
+
+    private:
+        double offset = 0.0;
+        double scale = 1.0;
+    };
+
+}
+}
+
+#endif //OPM_OUTPUT_UNIT_CONVERSION_HPP
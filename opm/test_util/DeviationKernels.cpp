@@ -0,0 +1,145 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+#include <opm/test_util/DeviationKernels.hpp>
+
+namespace {
+
+    const int min_exponent = -64;
+    const int max_exponent = 64;
+    const size_t bins_per_octave = 64;
+
+    // bin 0: zero, bin 1: below 2^min_exponent, last bin: at or above 2^max_exponent, NaN.
+    const size_t first_regular_bin = 2;
+    const size_t num_bins = first_regular_bin + (max_exponent - min_exponent) * bins_per_octave + 1;
+
+}
+
+
+
+DeviationHistogram::DeviationHistogram() :
+    bins(num_bins, 0)
+{}
+
+
+
+size_t DeviationHistogram::bin(double value) const {
+    if (value == 0)
+        return 0;
+
+    if (!(value < std::ldexp(1.0, max_exponent)))
+        return num_bins - 1;
+
+    int exponent;
+    const double mantissa = std::frexp(value, &exponent);   // value = mantissa * 2^exponent, 0.5 <= mantissa < 1
+    if (exponent <= min_exponent)
+        return 1;
+
+    const size_t octave = size_t(exponent - 1 - min_exponent);
+    const size_t sub_bin = std::min(bins_per_octave - 1, size_t((mantissa - 0.5) * 2 * bins_per_octave));
+    return first_regular_bin + octave * bins_per_octave + sub_bin;
+}
+
+
+
+double DeviationHistogram::binValue(size_t index) const {
+    if (index == 0)
+        return 0;
+
+    if (index == 1)
+        return std::ldexp(0.5, min_exponent);
+
+    if (index == num_bins - 1)
+        return std::ldexp(1.0, max_exponent);
+
+    const size_t octave = (index - first_regular_bin) / bins_per_octave;
+    const size_t sub_bin = (index - first_regular_bin) % bins_per_octave;
+    const double lower = 1.0 + double(sub_bin) / bins_per_octave;
+    const double width = 1.0 / bins_per_octave;
+    return std::ldexp(lower + 0.5 * width, int(octave) + min_exponent);
+}
+
+
+
+void DeviationHistogram::add(double value) {
+    if (value < 0)
+        return;
+
+    bins[bin(value)]++;
+    numValues++;
+}
+
+
+
+void DeviationHistogram::merge(const DeviationHistogram& other) {
+    for (size_t index = 0; index < bins.size(); index++)
+        bins[index] += other.bins[index];
+
+    numValues += other.numValues;
+}
+
+
+
+void DeviationHistogram::clear() {
+    std::fill(bins.begin(), bins.end(), 0);
+    numValues = 0;
+}
+
+
+
+double DeviationHistogram::valueAtRank(size_t rank) const {
+    size_t seen = 0;
+    for (size_t index = 0; index < bins.size(); index++) {
+        seen += bins[index];
+        if (seen > rank)
+            return binValue(index);
+    }
+    return binValue(bins.size() - 1);
+}
+
+
+
+double DeviationHistogram::median() const {
+    if (numValues == 0)
+        return 0;
+
+    const size_t n = numValues / 2;
+    if (numValues % 2 == 0)
+        return 0.5 * (valueAtRank(n - 1) + valueAtRank(n));
+
+    return valueAtRank(n);
+}
+
+
+
+const size_t DeviationStats::npos;
+
+
+
+void DeviationStats::merge(const DeviationStats& other, size_t offset) {
+    maxAbs = std::max(maxAbs, other.maxAbs);
+    maxRel = std::max(maxRel, other.maxRel);
+    sumAbs += other.sumAbs;
+    sumRel += other.sumRel;
+    numAbs += other.numAbs;
+    numRel += other.numRel;
+    if (firstError == npos && other.firstError != npos)
+        firstError = other.firstError + offset;
+    numErrors += other.numErrors;
+}
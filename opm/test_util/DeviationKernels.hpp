@@ -0,0 +1,247 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+#ifndef DEVIATIONKERNELS_HPP
+#define DEVIATIONKERNELS_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+/*! \brief Approximate median of a stream of non-negative values.
+    \details The values are counted in a fixed set of logarithmic bins:
+             64 bins per power of two between 2^-64 and 2^64, in addition
+             to one bin for zero, one for smaller and one for larger
+             values. The memory is fixed - independent of the number of
+             values - and two histograms are merged by adding the counts,
+             so histograms filled in parallel give the same result as one
+             histogram filled serially. The median is the midpoint of the
+             bin holding the middle value, i.e. it is exact for zero and
+             otherwise within 1% of the exact median.
+ */
+class DeviationHistogram {
+    public:
+        DeviationHistogram();
+
+        //! \brief Count one value; negative values are ignored.
+        void add(double value);
+        //! \brief Add the counts of another histogram.
+        void merge(const DeviationHistogram& other);
+        //! \brief Remove all values.
+        void clear();
+
+        size_t count() const { return numValues; }
+        //! \brief The approximate median, with the same convention for an even number of values as ECLFilesComparator::median(); zero if there are no values.
+        double median() const;
+
+    private:
+        size_t bin(double value) const;
+        double binValue(size_t bin) const;
+        double valueAtRank(size_t rank) const;
+
+        std::vector<std::uint64_t> bins;
+        size_t numValues = 0;
+};
+
+
+
+/*! \brief Summary of the deviations between two arrays of values.
+    \details Filled in one pass by the deviation kernels below. The
+             absolute and relative deviations are only counted where they
+             are defined, see the kernels.
+ */
+struct DeviationStats {
+    static const size_t npos = std::numeric_limits<size_t>::max();
+
+    double maxAbs = 0;              //!< Largest absolute deviation
+    double maxRel = 0;              //!< Largest relative deviation
+    double sumAbs = 0;              //!< Sum of the absolute deviations
+    double sumRel = 0;              //!< Sum of the relative deviations
+    size_t numAbs = 0;              //!< Number of defined absolute deviations
+    size_t numRel = 0;              //!< Number of defined relative deviations
+    size_t numErrors = 0;           //!< Number of values which violate the tolerances
+    size_t firstError = npos;       //!< Index of the first violation, npos if there are none
+
+    //! \brief Add the deviations of another array; firstError is kept if it is set, otherwise it is taken from other shifted by offset.
+    void merge(const DeviationStats& other, size_t offset = 0);
+
+    double averageAbs() const { return numAbs == 0 ? 0 : sumAbs / numAbs; }
+    double averageRel() const { return numRel == 0 ? 0 : sumRel / numRel; }
+};
+
+
+
+namespace DeviationKernels {
+
+    //! Number of values which are processed as one block by the kernels.
+    const size_t block_size = 512;
+
+    /*! \brief Deviations between cell values as in RegressionTest for ECLIPSE files.
+        \details For each cell the absolute values are compared with the
+                 same rules as ECLFilesComparator::calculateDeviations():
+                 the absolute deviation is defined if one of the values is
+                 non-zero, the relative deviation if both are. If
+                 allowNegativeValues is false, a negative value whose
+                 absolute value exceeds absTolerance is a violation, and
+                 negative values are then treated as zero. A cell where both
+                 the absolute and the relative deviation exceed the
+                 tolerances is a violation. The defined deviations are
+                 added to the histograms, if given.
+
+                 The deviations of one block of values are computed in a
+                 branch free loop, which the compiler vectorizes, and then
+                 reduced; no memory is allocated.
+     */
+    template <typename T>
+    DeviationStats cellDeviations(const T* values1, const T* values2, size_t size,
+                                  double absTolerance, double relTolerance, bool allowNegativeValues,
+                                  DeviationHistogram* absHistogram = nullptr,
+                                  DeviationHistogram* relHistogram = nullptr) {
+        DeviationStats stats;
+        double absDev[block_size], relDev[block_size];
+        unsigned char error[block_size];
+
+        for (size_t first = 0; first < size; first += block_size) {
+            const size_t n = std::min(block_size, size - first);
+            const T* v1 = values1 + first;
+            const T* v2 = values2 + first;
+
+            for (size_t i = 0; i < n; i++) {
+                double a = v1[i];
+                double b = v2[i];
+                bool negative = false;
+                if (!allowNegativeValues) {
+                    negative = (a < 0 && -a > absTolerance) || (b < 0 && -b > absTolerance);
+                    a = a < 0 ? 0 : a;
+                    b = b < 0 ? 0 : b;
+                }
+                a = std::abs(a);
+                b = std::abs(b);
+
+                const double hi = std::max(a, b);
+                const double lo = std::min(a, b);
+                const double d = std::abs(a - b);
+                absDev[i] = hi != 0 ? d : -1;
+                relDev[i] = lo != 0 ? d / hi : -1;
+                error[i] = negative || (absDev[i] > absTolerance && relDev[i] > relTolerance);
+            }
+
+            for (size_t i = 0; i < n; i++) {
+                if (absDev[i] != -1) {
+                    stats.sumAbs += absDev[i];
+                    stats.maxAbs = std::max(stats.maxAbs, absDev[i]);
+                    stats.numAbs++;
+                    if (absHistogram)
+                        absHistogram->add(absDev[i]);
+                }
+                if (relDev[i] != -1) {
+                    stats.sumRel += relDev[i];
+                    stats.maxRel = std::max(stats.maxRel, relDev[i]);
+                    stats.numRel++;
+                    if (relHistogram)
+                        relHistogram->add(relDev[i]);
+                }
+                if (error[i]) {
+                    if (stats.numErrors == 0)
+                        stats.firstError = first + i;
+                    stats.numErrors++;
+                }
+            }
+        }
+
+        return stats;
+    }
+
+
+    /*! \brief Deviations between aligned summary vectors as in the summary RegressionTest.
+        \details The rules are those of SummaryComparator::calculateDeviations():
+                 the absolute deviation is always defined, and the relative
+                 deviation is zero when both values are zero. A value where
+                 both the absolute and the relative deviation exceed the
+                 tolerances is a violation.
+     */
+    template <typename T>
+    DeviationStats summaryDeviations(const T* values1, const T* values2, size_t size,
+                                     double absTolerance, double relTolerance) {
+        DeviationStats stats;
+        double maxAbs[4] = {0, 0, 0, 0}, maxRel[4] = {0, 0, 0, 0};
+        double sumAbs[4] = {0, 0, 0, 0}, sumRel[4] = {0, 0, 0, 0};
+        size_t numErrors[4] = {0, 0, 0, 0};
+
+        size_t i = 0;
+        for (; i + 4 <= size; i += 4) {
+            for (size_t l = 0; l < 4; l++) {
+                const double a = values1[i + l];
+                const double b = values2[i + l];
+                const double d = std::abs(a - b);
+                const double hi = std::max(std::abs(a), std::abs(b));
+                const double rel = hi != 0 ? d / hi : 0;
+                maxAbs[l] = std::max(maxAbs[l], d);
+                maxRel[l] = std::max(maxRel[l], rel);
+                sumAbs[l] += d;
+                sumRel[l] += rel;
+                numErrors[l] += (d > absTolerance && rel > relTolerance);
+            }
+        }
+        for (; i < size; i++) {
+            const double a = values1[i];
+            const double b = values2[i];
+            const double d = std::abs(a - b);
+            const double hi = std::max(std::abs(a), std::abs(b));
+            const double rel = hi != 0 ? d / hi : 0;
+            maxAbs[0] = std::max(maxAbs[0], d);
+            maxRel[0] = std::max(maxRel[0], rel);
+            sumAbs[0] += d;
+            sumRel[0] += rel;
+            numErrors[0] += (d > absTolerance && rel > relTolerance);
+        }
+
+        stats.maxAbs = std::max(std::max(maxAbs[0], maxAbs[1]), std::max(maxAbs[2], maxAbs[3]));
+        stats.maxRel = std::max(std::max(maxRel[0], maxRel[1]), std::max(maxRel[2], maxRel[3]));
+        stats.sumAbs = (sumAbs[0] + sumAbs[1]) + (sumAbs[2] + sumAbs[3]);
+        stats.sumRel = (sumRel[0] + sumRel[1]) + (sumRel[2] + sumRel[3]);
+        stats.numAbs = size;
+        stats.numRel = size;
+        stats.numErrors = (numErrors[0] + numErrors[1]) + (numErrors[2] + numErrors[3]);
+
+        // The first violation is searched for only when there is one.
+        if (stats.numErrors > 0) {
+            for (size_t j = 0; j < size; j++) {
+                const double a = values1[j];
+                const double b = values2[j];
+                const double d = std::abs(a - b);
+                const double hi = std::max(std::abs(a), std::abs(b));
+                const double rel = hi != 0 ? d / hi : 0;
+                if (d > absTolerance && rel > relTolerance) {
+                    stats.firstError = j;
+                    break;
+                }
+            }
+        }
+
+        return stats;
+    }
+
+}
+
+#endif
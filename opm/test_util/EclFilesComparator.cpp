@@ -18,6 +18,8 @@
 
 #include <opm/test_util/EclFilesComparator.hpp>
 #include <opm/common/ErrorMacros.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
+#include <opm/output/eclipse/Parallel.hpp>
 
 #include <stdio.h>
 
@@ -26,6 +28,7 @@
 #include <iomanip>
 #include <algorithm>
 #include <cmath>
+#include <exception>
 #include <numeric>
 
 #include <ert/ecl/ecl_file.h>
@@ -60,6 +63,21 @@ namespace {
         well_info_free( well_info );
     }
 
+    std::map<std::string, std::vector<size_t>> indexOccurrences( Opm::out::MappedEclFile& file ) {
+        std::map<std::string, std::vector<size_t>> occurrences;
+        const auto& keywords = file.keywords();
+        for (size_t index = 0; index < keywords.size(); index++)
+            occurrences[ keywords[index].name ].push_back( index );
+
+        return occurrences;
+    }
+
+    /*
+      Number of values compared by one thread before another thread is
+      added; below this the comparison is done on the calling thread.
+    */
+    const size_t min_values_per_thread = 1 << 16;
+
 }
 
 
@@ -93,6 +111,42 @@ unsigned int ECLFilesComparator::getEclKeywordData(ecl_kw_type*& ecl_kw1, ecl_kw
 
 
 
+bool ECLFilesComparator::keywordMapped(const std::string& keyword) const {
+    if (!mapped_file1 || !mapped_file2)
+        return false;
+
+    const auto it1 = mapped_occurrences1.find(keyword);
+    const auto it2 = mapped_occurrences2.find(keyword);
+    if (it1 == mapped_occurrences1.end() || it2 == mapped_occurrences2.end())
+        return false;
+
+    // A truncated file, or a file ERT reads differently, is left to ERT.
+    return it1->second.size() == size_t(ecl_file_get_num_named_kw(ecl_file1, keyword.c_str()))
+        && it2->second.size() == size_t(ecl_file_get_num_named_kw(ecl_file2, keyword.c_str()));
+}
+
+
+
+void ECLFilesComparator::getMappedKeywordData(std::vector<double>& values1, std::vector<double>& values2, const std::string& keyword, int occurrence1, int occurrence2) const {
+    const auto& kw1 = mapped_file1->keywords()[ mapped_occurrences1.at(keyword).at(occurrence1) ];
+    const auto& kw2 = mapped_file2->keywords()[ mapped_occurrences2.at(keyword).at(occurrence2) ];
+    if (kw1.count != kw2.count) {
+        OPM_THROW(std::runtime_error, "For keyword " << keyword << ":"
+                << "\nOccurrence in first file " << occurrence1
+                << "\nOccurrence in second file " << occurrence2
+                << "\nCells in first file: " << kw1.count
+                << "\nCells in second file: " << kw2.count
+                << "\nThe number of cells differ.");
+    }
+
+    values1.resize(kw1.count);
+    values2.resize(kw2.count);
+    mapped_file1->read(kw1, values1.data());
+    mapped_file2->read(kw2, values2.data());
+}
+
+
+
 template <typename T>
 void ECLFilesComparator::printValuesForCell(const std::string& /*keyword*/, int occurrence1, int occurrence2, size_t cell, const T& value1, const T& value2) const {
     int i, j, k;
@@ -149,6 +203,14 @@ ECLFilesComparator::ECLFilesComparator(int file_type_arg, const std::string& bas
     if (ecl_grid2 == nullptr) {
         OPM_THROW(std::invalid_argument, "Error opening second grid file. " << basename2);
     }
+
+    // The keyword data of unformatted files is read through memory maps, ERT is only used for the keyword list and types.
+    if (Opm::out::MappedEclFile::unformatted(file1) && Opm::out::MappedEclFile::unformatted(file2)) {
+        mapped_file1.reset(new Opm::out::MappedEclFile(file1));
+        mapped_file2.reset(new Opm::out::MappedEclFile(file2));
+        mapped_occurrences1 = indexOccurrences(*mapped_file1);
+        mapped_occurrences2 = indexOccurrences(*mapped_file2);
+    }
     unsigned int numKeywords1 = ecl_file_get_num_distinct_kw(ecl_file1);
     unsigned int numKeywords2 = ecl_file_get_num_distinct_kw(ecl_file2);
     keywords1.reserve(numKeywords1);
@@ -179,6 +241,15 @@ ECLFilesComparator::~ECLFilesComparator() {
 
 
 
+void ECLFilesComparator::disableMappedFiles() {
+    mapped_file1.reset();
+    mapped_file2.reset();
+    mapped_occurrences1.clear();
+    mapped_occurrences2.clear();
+}
+
+
+
 void ECLFilesComparator::printKeywords() const {
     std::cout << "\nKeywords in the first file:\n";
     for (const auto& it : keywords1) {
@@ -265,12 +336,10 @@ void RegressionTest::printResultsForKeyword(const std::string& keyword) const {
     std::cout << "Deviation results for keyword " << keyword << " of type "
         << ecl_type_get_name(ecl_file_iget_named_data_type(ecl_file1, keyword.c_str(), 0))
         << ":\n";
-    const double absDeviationAverage = average(absDeviation);
-    const double relDeviationAverage = average(relDeviation);
-    std::cout << "Average absolute deviation = " << absDeviationAverage  << std::endl;
-    std::cout << "Median absolute deviation  = " << median(absDeviation) << std::endl;
-    std::cout << "Average relative deviation = " << relDeviationAverage  << std::endl;
-    std::cout << "Median relative deviation  = " << median(relDeviation) << "\n\n";
+    std::cout << "Average absolute deviation = " << deviationStats.averageAbs() << std::endl;
+    std::cout << "Median absolute deviation  = " << absHistogram.median()     << std::endl;
+    std::cout << "Average relative deviation = " << deviationStats.averageRel() << std::endl;
+    std::cout << "Median relative deviation  = " << relHistogram.median()     << "\n\n";
 }
 
 
@@ -325,55 +394,130 @@ void RegressionTest::intComparisonForOccurrence(const std::string& keyword, int
 
 
 
-void RegressionTest::doubleComparisonForOccurrence(const std::string& keyword, int occurrence1, int occurrence2) {
-    ecl_kw_type* ecl_kw1 = nullptr;
-    ecl_kw_type* ecl_kw2 = nullptr;
-    const unsigned int numCells = getEclKeywordData(ecl_kw1, ecl_kw2, keyword, occurrence1, occurrence2);
-    std::vector<double> values1(numCells), values2(numCells);
-    ecl_kw_get_data_as_double(ecl_kw1, values1.data());
-    ecl_kw_get_data_as_double(ecl_kw2, values2.data());
-
-    auto it = std::find(keywordDisallowNegatives.begin(), keywordDisallowNegatives.end(), keyword);
-    for (size_t cell = 0; cell < values1.size(); cell++) {
-        deviationsForCell(values1[cell], values2[cell], keyword, occurrence1, occurrence2, cell, it == keywordDisallowNegatives.end());
+void RegressionTest::compareOccurrence(const std::vector<double>& values1, const std::vector<double>& values2, bool allowNegativeValues,
+                                       OccurrenceDeviations& deviations, DeviationHistogram& absDeviations, DeviationHistogram& relDeviations) const {
+    const double absTolerance = getAbsTolerance();
+    const double relTolerance = getRelTolerance();
+    deviations.stats = DeviationKernels::cellDeviations(values1.data(), values2.data(), values1.size(),
+                                                        absTolerance, relTolerance, allowNegativeValues,
+                                                        &absDeviations, &relDeviations);
+    deviations.errors.clear();
+    if (deviations.stats.numErrors == 0)
+        return;
+
+    for (size_t cell = deviations.stats.firstError; cell < values1.size(); cell++) {
+        double val1 = values1[cell];
+        double val2 = values2[cell];
+        if (!allowNegativeValues) {
+            if (val1 < 0) {
+                if (std::abs(val1) > absTolerance)
+                    deviations.errors.push_back({CellError::NegativeFirst, cell, val1, val2, Deviation()});
+                val1 = 0;
+            }
+            if (val2 < 0) {
+                if (std::abs(val2) > absTolerance)
+                    deviations.errors.push_back({CellError::NegativeSecond, cell, val1, val2, Deviation()});
+                val2 = 0;
+            }
+        }
+        Deviation dev = calculateDeviations(val1, val2);
+        if (dev.abs > absTolerance && dev.rel > relTolerance) {
+            deviations.errors.push_back({CellError::Tolerance, cell, val1, val2, dev});
+        }
     }
 }
 
 
 
-void RegressionTest::deviationsForCell(double val1, double val2, const std::string& keyword, int occurrence1, int occurrence2, size_t cell, bool allowNegativeValues) {
-    double absTolerance = getAbsTolerance();
-    double relTolerance = getRelTolerance();
-    if (!allowNegativeValues) {
-        if (val1 < 0) {
-            if (std::abs(val1) > absTolerance) {
-                printValuesForCell(keyword, occurrence1, occurrence2, cell, val1, val2);
+void RegressionTest::reportOccurrence(const std::string& keyword, int occurrence1, int occurrence2, const OccurrenceDeviations& deviations) {
+    const double absTolerance = getAbsTolerance();
+    const double relTolerance = getRelTolerance();
+    for (const auto& error : deviations.errors) {
+        printValuesForCell(keyword, occurrence1, occurrence2, error.cell, error.val1, error.val2);
+        switch (error.kind) {
+            case CellError::NegativeFirst:
                 HANDLE_ERROR(std::runtime_error, "Negative value in first file, "
                         << "which in absolute value exceeds the absolute tolerance of " << absTolerance << ".");
-            }
-            val1 = 0;
-        }
-        if (val2 < 0) {
-            if (std::abs(val2) > absTolerance) {
-                printValuesForCell(keyword, occurrence1, occurrence2, cell, val1, val2);
+                break;
+            case CellError::NegativeSecond:
                 HANDLE_ERROR(std::runtime_error, "Negative value in second file, "
                         << "which in absolute value exceeds the absolute tolerance of " << absTolerance << ".");
-            }
-            val2 = 0;
+                break;
+            case CellError::Tolerance:
+                HANDLE_ERROR(std::runtime_error, "Deviations exceed tolerances."
+                        << "\nThe absolute deviation is " << error.dev.abs << ", and the tolerance limit is " << absTolerance << "."
+                        << "\nThe relative deviation is " << error.dev.rel << ", and the tolerance limit is " << relTolerance << ".");
+                break;
         }
     }
-    Deviation dev = calculateDeviations(val1, val2);
-    if (dev.abs > absTolerance && dev.rel > relTolerance) {
-        printValuesForCell(keyword, occurrence1, occurrence2, cell, val1, val2);
-        HANDLE_ERROR(std::runtime_error, "Deviations exceed tolerances."
-                << "\nThe absolute deviation is " << dev.abs << ", and the tolerance limit is " << absTolerance << "."
-                << "\nThe relative deviation is " << dev.rel << ", and the tolerance limit is " << relTolerance << ".");
+    deviationStats.merge(deviations.stats);
+}
+
+
+
+void RegressionTest::doubleComparison(const std::string& keyword, const std::vector<std::pair<int, int>>& occurrences) {
+    auto it = std::find(keywordDisallowNegatives.begin(), keywordDisallowNegatives.end(), keyword);
+    const bool allowNegativeValues = it == keywordDisallowNegatives.end();
+
+    if (!keywordMapped(keyword)) {
+        std::vector<double> values1, values2;
+        OccurrenceDeviations deviations;
+        for (const auto& occurrence : occurrences) {
+            ecl_kw_type* ecl_kw1 = nullptr;
+            ecl_kw_type* ecl_kw2 = nullptr;
+            const unsigned int numCells = getEclKeywordData(ecl_kw1, ecl_kw2, keyword, occurrence.first, occurrence.second);
+            values1.resize(numCells);
+            values2.resize(numCells);
+            ecl_kw_get_data_as_double(ecl_kw1, values1.data());
+            ecl_kw_get_data_as_double(ecl_kw2, values2.data());
+
+            compareOccurrence(values1, values2, allowNegativeValues, deviations, absHistogram, relHistogram);
+            reportOccurrence(keyword, occurrence.first, occurrence.second, deviations);
+        }
+        return;
     }
-    if (dev.abs != -1) {
-        absDeviation.push_back(dev.abs);
+
+    /*
+      The occurrences are compared in batches of one occurrence per
+      thread, and each batch is reported before the next batch is
+      compared; an error therefore stops the comparison at most one
+      batch later than a serial comparison would.
+    */
+    const auto numValues = mapped_file1->keywords()[ mapped_occurrences1.at(keyword).front() ].count;
+    const size_t numThreads = std::min(occurrences.size(),
+                                       Opm::out::parallel::num_threads(occurrences.size() * numValues, min_values_per_thread));
+
+    std::vector<std::vector<double>> values1(numThreads), values2(numThreads);
+    std::vector<OccurrenceDeviations> deviations(numThreads);
+    std::vector<std::exception_ptr> errors(numThreads);
+
+    // The histograms only hold counts, merging them in any order gives the same result.
+    std::vector<DeviationHistogram> absHistograms(numThreads), relHistograms(numThreads);
+
+    for (size_t first = 0; first < occurrences.size(); first += numThreads) {
+        const size_t batchSize = std::min(numThreads, occurrences.size() - first);
+        Opm::out::parallel::run(batchSize, [&](size_t t) {
+            const auto& occurrence = occurrences[first + t];
+            try {
+                getMappedKeywordData(values1[t], values2[t], keyword, occurrence.first, occurrence.second);
+                compareOccurrence(values1[t], values2[t], allowNegativeValues, deviations[t], absHistograms[t], relHistograms[t]);
+            } catch (...) {
+                errors[t] = std::current_exception();
+            }
+        });
+
+        for (size_t t = 0; t < batchSize; t++) {
+            if (errors[t])
+                std::rethrow_exception(errors[t]);
+
+            const auto& occurrence = occurrences[first + t];
+            reportOccurrence(keyword, occurrence.first, occurrence.second, deviations[t]);
+        }
     }
-    if (dev.rel != -1) {
-        relDeviation.push_back(dev.rel);
+
+    for (size_t t = 0; t < numThreads; t++) {
+        absHistogram.merge(absHistograms[t]);
+        relHistogram.merge(relHistograms[t]);
     }
 }
 
@@ -455,20 +599,25 @@ void RegressionTest::resultsForKeyword(const std::string& keyword) {
     switch(kw_type) {
         case ECL_DOUBLE_TYPE:
         case ECL_FLOAT_TYPE:
+        {
             std::cout << "Comparing " << keyword << "...";
+            std::vector<std::pair<int, int>> occurrences;
             if (onlyLastOccurrence) {
-                doubleComparisonForOccurrence(keyword, occurrences1 - 1, occurrences2 - 1);
+                occurrences.emplace_back(occurrences1 - 1, occurrences2 - 1);
             }
             else {
                 for (unsigned int occurrence = 0; occurrence < occurrences1; ++occurrence) {
-                    doubleComparisonForOccurrence(keyword, occurrence, occurrence);
+                    occurrences.emplace_back(occurrence, occurrence);
                 }
             }
+            doubleComparison(keyword, occurrences);
             std::cout << "done." << std::endl;
             printResultsForKeyword(keyword);
-            absDeviation.clear();
-            relDeviation.clear();
+            deviationStats = DeviationStats();
+            absHistogram.clear();
+            relHistogram.clear();
             return;
+        }
         case ECL_INT_TYPE:
             std::cout << "Comparing " << keyword << "...";
             if (onlyLastOccurrence) {
@@ -20,9 +20,14 @@
 #ifndef ECLFILESCOMPARATOR_HPP
 #define ECLFILESCOMPARATOR_HPP
 
+#include <map>
+#include <memory>
+#include <utility>
 #include <vector>
 #include <string>
 
+#include <opm/test_util/DeviationKernels.hpp>
+
 struct ecl_file_struct; //!< Prototype for eclipse file struct, from ERT library.
 typedef struct ecl_file_struct ecl_file_type;
 
@@ -31,6 +36,8 @@ typedef struct ecl_grid_struct ecl_grid_type;
 struct ecl_kw_struct; //!< Prototype for eclipse keyword struct, from ERT library.
 typedef struct ecl_kw_struct ecl_kw_type;
 
+namespace Opm { namespace out { class MappedEclFile; } }
+
 
 /*! \brief Deviation struct.
     \details The member variables are default initialized to -1,
@@ -60,6 +67,10 @@ class ECLFilesComparator {
         ecl_file_type* ecl_file2 = nullptr;
         ecl_grid_type* ecl_grid2 = nullptr;
         std::vector<std::string> keywords1, keywords2;
+        //! Memory mapped views of unformatted files, nullptr for formatted files.
+        std::unique_ptr<Opm::out::MappedEclFile> mapped_file1, mapped_file2;
+        //! Positions of the occurrences of each keyword in the mapped files.
+        std::map<std::string, std::vector<size_t>> mapped_occurrences1, mapped_occurrences2;
         bool throwOnError = true; //!< Throw on first error
         mutable size_t num_errors = 0;
 
@@ -74,6 +85,12 @@ class ECLFilesComparator {
         //! \param[in] occurrence Which keyword occurrence to consider.
         //! \details This function stores keyword data for the given keyword and occurrence in #ecl_kw1 and #ecl_kw2, and returns the number of cells (for which the keyword has a value at the occurrence). If the number of cells differ for the two cases, an exception is thrown.
         unsigned int getEclKeywordData(ecl_kw_type*& ecl_kw1, ecl_kw_type*& ecl_kw2, const std::string& keyword, int occurrence1, int occurrence2) const;
+        //! \brief Checks if a keyword can be read from the memory mapped files.
+        //! \details True if both files are mapped and the number of occurrences in the mapped files matches the number found by ERT.
+        bool keywordMapped(const std::string& keyword) const;
+        //! \brief Reads numeric keyword data for a given occurrence from the memory mapped files.
+        //! \details As getEclKeywordData(), but the values are decoded directly from the mapped files into values1 and values2. This function does not touch the ERT file objects, and can be called from several threads at once. Requires keywordMapped(keyword).
+        void getMappedKeywordData(std::vector<double>& values1, std::vector<double>& values2, const std::string& keyword, int occurrence1, int occurrence2) const;
         //! \brief Prints values for a given keyword, occurrence and cell
         //! \param[in] keyword Which keyword to consider.
         //! \param[in] occurrence Which keyword occurrence to consider.
@@ -96,12 +113,19 @@ class ECLFilesComparator {
         //! \brief Closing the ECLIPSE files.
         ~ECLFilesComparator();
 
+        ECLFilesComparator(const ECLFilesComparator&) = delete;
+        ECLFilesComparator& operator=(const ECLFilesComparator&) = delete;
+
         //! \brief Set whether to throw on errors or not.
         void throwOnErrors(bool dothrow) { throwOnError = dothrow; }
 
         //! \brief Returns the number of errors encountered in the performed comparisons.
         size_t getNoErrors() const { return num_errors; }
 
+        //! \brief Read all keyword data through ERT, also for unformatted files.
+        //! \details Closes the memory mapped files, so the floating point keywords are compared serially. Mainly useful to check the parallel comparison against the serial one.
+        void disableMappedFiles();
+
         //! \brief Returns the ECLIPSE filetype of this
         int getFileType() const {return file_type;}
         //! \brief Returns the absolute tolerance stored as a private member variable in the class
@@ -137,15 +161,16 @@ class ECLFilesComparator {
 
 class RegressionTest: public ECLFilesComparator {
     private:
-        // These vectors store absolute and relative deviations, respecively. Note that they are whiped clean for every new keyword comparison.
-        std::vector<double> absDeviation, relDeviation;
+        // The absolute and relative deviations, and their distributions for the medians. Note that they are whiped clean for every new keyword comparison.
+        DeviationStats deviationStats;
+        DeviationHistogram absHistogram, relHistogram;
         // Keywords which should not contain negative values, i.e. uses allowNegativeValues = false in deviationsForCell():
         const std::vector<std::string> keywordDisallowNegatives = {"SGAS", "SWAT", "PRESSURE"};
 
         // Only compare last occurrence
         bool onlyLastOccurrence = false;
 
-        // Prints results stored in absDeviation and relDeviation.
+        // Prints results stored in deviationStats and the histograms.
         void printResultsForKeyword(const std::string& keyword) const;
 
         // Function which compares data at specific occurrences and for a specific keyword type. The functions takes two occurrence inputs to also be able to
@@ -154,12 +179,35 @@ class RegressionTest: public ECLFilesComparator {
         void boolComparisonForOccurrence(const std::string& keyword, int occurrence1, int occurrence2) const;
         void charComparisonForOccurrence(const std::string& keyword, int occurrence1, int occurrence2) const;
         void intComparisonForOccurrence(const std::string& keyword, int occurrence1, int occurrence2) const;
-        void doubleComparisonForOccurrence(const std::string& keyword, int occurrence1, int occurrence2);
-        // deviationsForCell throws an exception if both the absolute deviation AND the relative deviation
-        // are larger than absTolerance and relTolerance, respectively. In addition,
-        // if allowNegativeValues is passed as false, an exception will be thrown when the absolute value
-        // of a negative value exceeds absTolerance. If no exceptions are thrown, the absolute and relative deviations are added to absDeviation and relDeviation.
-        void deviationsForCell(double val1, double val2, const std::string& keyword, int occurrence1, int occurrence2, size_t cell, bool allowNegativeValues = true);
+
+        // The deviations and the tolerance violations found in one occurrence of a floating point keyword, in cell order.
+        struct CellError {
+            enum Kind { NegativeFirst, NegativeSecond, Tolerance };
+            Kind kind;
+            size_t cell;
+            double val1, val2;
+            Deviation dev;
+        };
+        struct OccurrenceDeviations {
+            DeviationStats stats;
+            std::vector<CellError> errors;
+        };
+
+        // Compares the values of one occurrence, the result is stored in deviations and the deviations are added to the histograms.
+        // A violation is recorded if both the absolute deviation AND the relative deviation are larger than absTolerance and
+        // relTolerance, respectively. In addition, if allowNegativeValues is passed as false, a violation is recorded when the
+        // absolute value of a negative value exceeds absTolerance, and the value is then treated as zero. The values are compared
+        // with DeviationKernels::cellDeviations(), the cells are only visited one by one when there are violations. Does not
+        // report anything, and can be called from several threads at once with different histograms.
+        void compareOccurrence(const std::vector<double>& values1, const std::vector<double>& values2, bool allowNegativeValues,
+                               OccurrenceDeviations& deviations, DeviationHistogram& absDeviations, DeviationHistogram& relDeviations) const;
+        // Reports the violations found by compareOccurrence() - throwing on the first one if throwOnError is set - and adds the
+        // deviations to deviationStats.
+        void reportOccurrence(const std::string& keyword, int occurrence1, int occurrence2, const OccurrenceDeviations& deviations);
+        // Compares the given (occurrence1, occurrence2) pairs of a floating point keyword. With memory mapped files the pairs are
+        // compared in parallel, and the results are reported in the order of the pairs; the result is the same as comparing the
+        // pairs one at a time.
+        void doubleComparison(const std::string& keyword, const std::vector<std::pair<int, int>>& occurrences);
     public:
         //! \brief Sets up the regression test.
         //! \param[in] file_type Specifies which filetype to be compared, possible inputs are UNRSTFILE, INITFILE and RFTFILE.
@@ -0,0 +1,58 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+#include <opm/test_util/TimeAlignment.hpp>
+
+
+TimeAlignment::TimeAlignment(const std::vector<double>& referenceTime,
+                             const std::vector<double>& checkTime,
+                             Method method) {
+    lowerIndex.reserve(referenceTime.size());
+    upperIndex.reserve(referenceTime.size());
+    weights.reserve(referenceTime.size());
+    times.reserve(referenceTime.size());
+
+    size_t checkIndex = 0;
+    for (double t : referenceTime) {
+        while (checkIndex < checkTime.size() && checkTime[checkIndex] < t)
+            checkIndex++;
+
+        if (checkIndex == checkTime.size())
+            break;
+
+        const bool between = checkIndex > 0 && checkTime[checkIndex] != t;
+        if (method == Linear && between) {
+            const double t0 = checkTime[checkIndex - 1];
+            const double t1 = checkTime[checkIndex];
+            lowerIndex.push_back(checkIndex - 1);
+            upperIndex.push_back(checkIndex);
+            weights.push_back((t - t0) / (t1 - t0));
+            times.push_back(t);
+        } else {
+            // Flow writes the old value at the time step of a change, and the new value at the
+            // next time step, so the upper limit of the step function is used.
+            lowerIndex.push_back(checkIndex);
+            upperIndex.push_back(checkIndex);
+            weights.push_back(0);
+            times.push_back(checkTime[checkIndex]);
+            if (method == Sequential)
+                checkIndex++;
+        }
+    }
+}
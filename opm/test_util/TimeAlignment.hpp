@@ -0,0 +1,103 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+#ifndef TIMEALIGNMENT_HPP
+#define TIMEALIGNMENT_HPP
+
+#include <cstddef>
+#include <vector>
+
+
+/*! \brief Values of a summary vector at the time steps of another summary vector.
+    \details The two time axes are merged once, and for each reference
+             time step the two time steps of the checked vector to take
+             the value from are stored together with an interpolation
+             weight. The alignment only depends on the time axes, so one
+             alignment is used for all the keywords of two summary files,
+             and the values of one keyword are found in a single loop.
+
+             With Sequential the value at the first checked time step at
+             or after the reference time step is used, i.e. the upper limit
+             of the step function, and each checked time step is used for
+             at most one reference time step: the next reference time step
+             starts the search after it. UnitStep is the same, except that
+             a checked time step may be used for several reference time
+             steps. With Linear the value is interpolated between the
+             checked time steps on either side of the reference time step.
+             A reference time step before the first checked time step uses
+             the first checked value with all the methods.
+
+             The reference time steps after the last checked time step
+             can not be compared, size() is the number of reference time
+             steps which are aligned. Both time axes must be sorted.
+ */
+class TimeAlignment {
+    public:
+        enum Method {
+            Sequential, //!< Use the value at the next checked time step which is not used already.
+            UnitStep,   //!< Use the value at the next checked time step.
+            Linear      //!< Interpolate linearly between the checked time steps.
+        };
+
+        TimeAlignment(const std::vector<double>& referenceTime,
+                      const std::vector<double>& checkTime,
+                      Method method = Sequential);
+
+        //! \brief The number of reference time steps with a checked value.
+        size_t size() const { return weights.size(); }
+
+        //! \brief The checked time step before, or at, reference time step i.
+        size_t lower(size_t i) const { return lowerIndex[i]; }
+        //! \brief The checked time step at, or after, reference time step i.
+        size_t upper(size_t i) const { return upperIndex[i]; }
+        //! \brief The weight of upper(i) in the value at reference time step i.
+        double weight(size_t i) const { return weights[i]; }
+        //! \brief The time of the value at reference time step i: the checked time if one checked value is used, otherwise the reference time.
+        double time(size_t i) const { return times[i]; }
+
+        //! \brief The checked value at reference time step i.
+        double value(const double* checkData, size_t i) const {
+            const double lo = checkData[lowerIndex[i]];
+            const double hi = checkData[upperIndex[i]];
+            return lo + weights[i] * (hi - lo);
+        }
+
+        //! \brief The checked values at all the aligned reference time steps.
+        //! \param[in] checkData The values of the checked vector, one for each checked time step.
+        //! \param[out] values Room for size() values.
+        void apply(const double* checkData, double* values) const {
+            const size_t n = size();
+            const size_t* lowerIdx = lowerIndex.data();
+            const size_t* upperIdx = upperIndex.data();
+            const double* w = weights.data();
+            for (size_t i = 0; i < n; i++) {
+                const double lo = checkData[lowerIdx[i]];
+                const double hi = checkData[upperIdx[i]];
+                values[i] = lo + w[i] * (hi - lo);
+            }
+        }
+
+    private:
+        std::vector<size_t> lowerIndex;
+        std::vector<size_t> upperIndex;
+        std::vector<double> weights;
+        std::vector<double> times;
+};
+
+#endif
@@ -17,6 +17,7 @@
    */
 
 #include <opm/test_util/summaryComparator.hpp>
+#include <opm/output/eclipse/Parallel.hpp>
 #include <ert/ecl/ecl_sum.h>
 #include <ert/util/stringlist.h>
 #include <ert/util/int_vector.h>
@@ -25,6 +26,16 @@
 #include <cmath>
 #include <numeric>
 
+namespace {
+
+    // Summary values read or compared by one thread, below this the work is done serially.
+    const size_t min_values_per_thread = 1 << 16;
+
+    // Time steps which are transposed together, so that the writes to each keyword are contiguous.
+    const size_t steps_per_block = 16;
+
+}
+
 SummaryComparator::SummaryComparator(const char* basename1, const char* basename2, double absoluteTol, double relativeTol){
     ecl_sum1 = ecl_sum_fread_alloc_case(basename1, ":");
     ecl_sum2 = ecl_sum_fread_alloc_case(basename2, ":");
@@ -86,18 +97,50 @@ void SummaryComparator::setTimeVecs(std::vector<double> &timeVec1,
 void SummaryComparator::getDataVecs(std::vector<double> &dataVec1,
                                     std::vector<double> &dataVec2,
                                     const char* keyword){
+    const int paramsIndex1 = ecl_sum_get_general_var_params_index( ecl_sum1 , keyword );
     dataVec1.reserve(ecl_sum_get_data_length(ecl_sum1));
     for (int time_index = 0; time_index < ecl_sum_get_data_length(ecl_sum1); time_index++){
-        dataVec1.push_back(ecl_sum_iget(ecl_sum1, time_index, ecl_sum_get_general_var_params_index( ecl_sum1 , keyword )));
+        dataVec1.push_back(ecl_sum_iget(ecl_sum1, time_index, paramsIndex1));
     }
+    const int paramsIndex2 = ecl_sum_get_general_var_params_index( ecl_sum2 , keyword );
     dataVec2.reserve(ecl_sum_get_data_length(ecl_sum2));
     for (int time_index = 0; time_index < ecl_sum_get_data_length(ecl_sum2); time_index++){
-
-        dataVec2.push_back(ecl_sum_iget(ecl_sum2, time_index, ecl_sum_get_general_var_params_index( ecl_sum2 , keyword )));
+        dataVec2.push_back(ecl_sum_iget(ecl_sum2, time_index, paramsIndex2));
     }
 }
 
 
+void SummaryComparator::getDataColumns(ecl_sum_type* ecl_sum,
+                                       const std::vector<const char*>& keywords,
+                                       std::vector<double>& columns){
+    const size_t numSteps = ecl_sum_get_data_length(ecl_sum);
+    const size_t numKeys = keywords.size();
+    columns.resize(numKeys * numSteps);
+    if (numSteps == 0 || numKeys == 0)
+        return;
+
+    std::vector<int> paramsIndex;
+    paramsIndex.reserve(numKeys);
+    for (const char* keyword : keywords)
+        paramsIndex.push_back(ecl_sum_get_general_var_params_index(ecl_sum, keyword));
+
+    // ecl_sum_iget() only reads the loaded data, so the time steps can be read concurrently.
+    const size_t numBlocks = (numSteps + steps_per_block - 1) / steps_per_block;
+    const size_t numThreads = std::min(numBlocks, Opm::out::parallel::num_threads(numKeys * numSteps, min_values_per_thread));
+    Opm::out::parallel::run(numThreads, [&](size_t t) {
+        for (size_t block = t; block < numBlocks; block += numThreads) {
+            const size_t first = block * steps_per_block;
+            const size_t last = std::min(numSteps, first + steps_per_block);
+            for (size_t k = 0; k < numKeys; k++) {
+                double* column = columns.data() + k * numSteps;
+                for (size_t step = first; step < last; step++)
+                    column[step] = ecl_sum_iget(ecl_sum, int(step), paramsIndex[k]);
+            }
+        }
+    });
+}
+
+
 void SummaryComparator::setDataSets(const std::vector<double>& timeVec1,
                                     const std::vector<double>& timeVec2){
     if(timeVec1.size() < timeVec2.size()){
@@ -130,28 +173,46 @@ void SummaryComparator::chooseReference(const std::vector<double>& timeVec1,
 }
 
 
-void SummaryComparator::getDeviation(size_t refIndex, size_t &checkIndex, Deviation &dev){
-    if((*referenceVec)[refIndex] == (*checkVec)[checkIndex]){
-        dev = SummaryComparator::calculateDeviations((*referenceDataVec)[refIndex], (*checkDataVec)[checkIndex]);
-        checkIndex++;
-        return;
-    }
-    else if((*referenceVec)[refIndex]<(*checkVec)[checkIndex]){
-        double value = SummaryComparator::unitStep((*checkDataVec)[checkIndex]);
-        /*Must be a little careful here. Flow writes out old value first,
-          than changes value. Say there should be a change in production rate from A to B at timestep 300.
-          Then the data of time step 300 is A and the next timestep will have value B. Must use the upper limit. */
-        dev = SummaryComparator::calculateDeviations((*referenceDataVec)[refIndex], value);
-        checkIndex++;
-        return;
-    }
-    else{
-        checkIndex++;
-        getDeviation(refIndex, checkIndex , dev);
-    }
-    if(checkIndex == checkVec->size() -1 ){
-        return;
+void SummaryComparator::chooseReferenceFile(const std::vector<double>& timeVec1,
+                                            const std::vector<double>& timeVec2){
+    const bool firstIsReference = timeVec1.size() <= timeVec2.size();
+    ecl_sum_reference = firstIsReference ? ecl_sum1 : ecl_sum2;
+    ecl_sum_check = firstIsReference ? ecl_sum2 : ecl_sum1;
+    referenceVec = firstIsReference ? &timeVec1 : &timeVec2;
+    checkVec = firstIsReference ? &timeVec2 : &timeVec1;
+}
+
+
+bool SummaryComparator::forEachKeyword(const std::vector<const char*>& keywords, size_t scratchSize,
+                                       const KeywordFunction& compare, const ReportFunction& report){
+    const size_t numRefSteps = referenceVec->size();
+    const size_t numCheckSteps = checkVec->size();
+    const size_t valuesPerKeyword = numRefSteps + numCheckSteps;
+    const size_t batchSize = std::max<size_t>(1, maxBatchValues / std::max<size_t>(1, valuesPerKeyword));
+
+    std::vector<double> referenceColumns, checkColumns;
+    std::vector<std::vector<double>> scratch;
+    for (size_t first = 0; first < keywords.size(); first += batchSize){
+        const std::vector<const char*> batch(keywords.begin() + first,
+                                             keywords.begin() + std::min(keywords.size(), first + batchSize));
+        getDataColumns(ecl_sum_reference, batch, referenceColumns);
+        getDataColumns(ecl_sum_check, batch, checkColumns);
+
+        const size_t numThreads = std::min(batch.size(), Opm::out::parallel::num_threads(batch.size() * valuesPerKeyword, min_values_per_thread));
+        if (scratch.size() < numThreads)
+            scratch.resize(numThreads, std::vector<double>(scratchSize));
+
+        Opm::out::parallel::run(numThreads, [&](size_t t) {
+            for (size_t k = t; k < batch.size(); k += numThreads)
+                compare(first + k, referenceColumns.data() + k * numRefSteps, checkColumns.data() + k * numCheckSteps, scratch[t]);
+        });
+
+        for (size_t k = 0; k < batch.size(); k++){
+            if (!report(first + k, referenceColumns.data() + k * numRefSteps, checkColumns.data() + k * numCheckSteps))
+                return false;
+        }
     }
+    return true;
 }
 
 
@@ -165,7 +226,7 @@ void SummaryComparator::printUnits(){
 }
 
 
-//Called only when the keywords are equal in the getDeviations()-function
+//Called only when the keywords are equal in both files
 const char* SummaryComparator::getUnit(const char* keyword){
     return ecl_sum_get_unit(ecl_sum_fileShort, keyword);
 }
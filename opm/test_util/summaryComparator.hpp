@@ -24,6 +24,7 @@
 #include <iomanip>
 #include <vector>
 #include <algorithm>
+#include <functional>
 #include <string>
 
 
@@ -62,6 +63,8 @@ class SummaryComparator {
         ecl_sum_type * ecl_sum2                = nullptr; //!< Struct that contains file2
         ecl_sum_type * ecl_sum_fileShort       = nullptr; //!< For keeping track of the file with most/fewest timesteps
         ecl_sum_type * ecl_sum_fileLong        = nullptr; //!< For keeping track of the file with most/fewest timesteps
+        ecl_sum_type * ecl_sum_reference       = nullptr; //!< The file the reference data is read from, see chooseReferenceFile()
+        ecl_sum_type * ecl_sum_check           = nullptr; //!< The file the checked data is read from, see chooseReferenceFile()
         stringlist_type* keys1                 = nullptr; //!< For storing all the keywords of file1
         stringlist_type* keys2                 = nullptr; //!< For storing all the keywords of file2
         stringlist_type * keysShort            = nullptr; //!< For keeping track of the file with most/fewest keywords
@@ -73,13 +76,15 @@ class SummaryComparator {
         bool printKeyword = false; //!< Boolean value for choosing whether to print the keywords or not
         bool printSpecificKeyword = false; //!< Boolean value for choosing whether to print the vectors of a keyword or not
         bool throwOnError = true; //!< Throw on first error
+        size_t maxBatchValues = size_t(1) << 24; //!< Upper limit on the number of values read from both files for one batch of keywords in forEachKeyword()
 
-        //! \brief Calculate deviation between two data values and stores it in a Deviation struct.
-        //! \param[in] refIndex Index in reference data
-        //! \param[in] checkindex Index in data to be checked.
-        //! \param[out] dev Holds the result from the comparison on return.
-        //! \details Uses the #referenceVec as basis, and checks its values against the values in #checkDataVec. The function is reccursive, and will update the iterative index j of the #checkVec until #checkVec[j] >= #referenceVec[i]. \n When #referenceVec and #checkVec have the same time value (i.e. #referenceVec[i] == #checkVec[j]) a direct comparison is used, \n when this is not the case, when #referenceVec[i] do not excist as an element in #checkVec, a value is generated, either by the principle of unit step or by interpolation.
-        void getDeviation(size_t refIndex, size_t &checkIndex, Deviation &dev);
+        //! \brief Called by forEachKeyword() for each keyword, from several threads at once.
+        //! \details The arguments are the index of the keyword, its reference data and its checked data, with one value for each time step of #referenceVec and #checkVec, \n and a scratch vector which is only used by the calling thread.
+        typedef std::function<void(size_t, const double*, const double*, std::vector<double>&)> KeywordFunction;
+
+        //! \brief Called by forEachKeyword() for each keyword, on the calling thread and in the order of the keywords.
+        //! \details The arguments are as for KeywordFunction. Returns false to stop the processing of the keywords.
+        typedef std::function<bool(size_t, const double*, const double*)> ReportFunction;
 
         //! \brief Figure out which data file contains the most / less timesteps and assign member variable pointers accordingly.
         //! \param[in] timeVec1 Data from first file
@@ -100,6 +105,30 @@ class SummaryComparator {
         void getDataVecs(std::vector<double> &dataVec1,
                          std::vector<double> &dataVec2, const char* keyword);
 
+        //! \brief Read the data for several keywords from one file into one keyword-major vector.
+        //! \param[in] ecl_sum The file to read from.
+        //! \param[in] keywords The keywords of interest, which must all be present in the file.
+        //! \param[out] columns On return the value of keywords[k] at time step i is columns[k*numSteps + i], where numSteps is the number of time steps in the file.
+        //! \details The params index of each keyword is looked up once, and each time step (PARAMS block) is visited once for all the keywords, i.e. the data is transposed into one contiguous array per keyword. The time steps are split over several threads.
+        static void getDataColumns(ecl_sum_type* ecl_sum, const std::vector<const char*>& keywords, std::vector<double>& columns);
+
+        //! \brief Sets the file with the fewer time steps as the reference, for the keyword batches of forEachKeyword().
+        //! \param[in] timeVec1 The time steps of file 1.
+        //! \param[in] timeVec2 The time steps of file 2.
+        //! \details The reference is chosen as in chooseReference(). #referenceVec and #checkVec are set to the time vectors, and #ecl_sum_reference and #ecl_sum_check to the corresponding files.
+        void chooseReferenceFile(const std::vector<double>& timeVec1,
+                                 const std::vector<double>& timeVec2);
+
+        //! \brief Reads the data of the keywords in batches, and processes the keywords of each batch in parallel.
+        //! \param[in] keywords The keywords of interest, which must be present in both files.
+        //! \param[in] scratchSize The size of the scratch vector passed to compare.
+        //! \param[in] compare Called once for each keyword of a batch, from several threads at once.
+        //! \param[in] report Called once for each keyword of a batch, in the order of the keywords, after compare has returned for all the keywords of the batch.
+        //! \details Requires chooseReferenceFile(). A batch holds as many keywords as there is room for in #maxBatchValues values from both files, but at least one, \n and the data of a batch is read with getDataColumns(). The keyword index passed to the functions is the position in keywords.
+        //! \return False if report returned false, in which case the remaining keywords are skipped, true otherwise.
+        bool forEachKeyword(const std::vector<const char*>& keywords, size_t scratchSize,
+                            const KeywordFunction& compare, const ReportFunction& report);
+
         //! \brief Sets one data set as a basis and the other as values to check against.
         //! \param[in] timeVec1 Used to figure out which dataset that have the more/fewer time steps.
         //! \param[in] timeVec2 Used to figure out which dataset that have the more/fewer time steps.
@@ -175,6 +204,9 @@ class SummaryComparator {
 
         //! \brief Set whether to throw on errors or not.
         void throwOnErrors(bool dothrow) { throwOnError = dothrow; }
+
+        //! \brief Sets the upper limit on the number of values which are read from both files for one batch of keywords. By default 2^24.
+        void setMaxBatchValues(size_t values) { maxBatchValues = values; }
 };
 
 #endif
@@ -18,10 +18,36 @@
 
 
 #include <opm/test_util/summaryIntegrationTest.hpp>
+#include <opm/test_util/DeviationKernels.hpp>
+#include <opm/test_util/TimeAlignment.hpp>
 #include <opm/common/ErrorMacros.hpp>
 #include <ert/ecl/ecl_sum.h>
 #include <ert/util/stringlist.h>
+#include <algorithm>
 #include <cmath>
+#include <unordered_set>
+
+namespace {
+
+    const size_t npos = std::numeric_limits<size_t>::max();
+
+    // The Riemann sum of dataVec over timeVec, see IntegrationTest::integrate(); four independent partial sums so that the loop is vectorized.
+    double riemannSum(const double* timeVec, const double* dataVec, size_t size) {
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        size_t i = 1;
+        for (; i + 4 <= size; i += 4) {
+            s0 += (timeVec[i] - timeVec[i - 1]) * dataVec[i];
+            s1 += (timeVec[i + 1] - timeVec[i]) * dataVec[i + 1];
+            s2 += (timeVec[i + 2] - timeVec[i + 1]) * dataVec[i + 2];
+            s3 += (timeVec[i + 3] - timeVec[i + 2]) * dataVec[i + 3];
+        }
+        for (; i < size; i++)
+            s0 += (timeVec[i] - timeVec[i - 1]) * dataVec[i];
+
+        return (s0 + s1) + (s2 + s3);
+    }
+
+}
 
 
 void IntegrationTest::getIntegrationTest(){
@@ -43,40 +69,39 @@ void IntegrationTest::getIntegrationTest(){
     std::string keywordWithGreatestErrorRatio;
     double greatestRatio = 0;
 
-    //Iterates over all keywords from the restricted file, use iterator "ivar". Searches for a  match in the file with more keywords, use the itarator "jvar".
+    //Iterates over all keywords from the restricted file, use iterator "ivar", and looks for a match in the file with more keywords. The keywords up to the first one without a match are checked.
+    std::unordered_set<std::string> keywordsLong;
+    for (int jvar = 0; jvar < stringlist_get_size(keysLong); jvar++){
+        keywordsLong.insert(stringlist_iget(keysLong, jvar));
+    }
+    std::vector<const char*> keywords;
+    bool missingKeyword = false;
     while(ivar < stringlist_get_size(keysShort)){
         const char* keyword = stringlist_iget(keysShort, ivar);
+        std::string keywordString(keyword);
+        ivar++;
 
         if(oneOfTheMainVariables){
-            std::string keywordString(keyword);
             std::string substr = keywordString.substr(0,4);
             if(substr!= mainVariable){
-                ivar++;
                 continue;
             }
         }
-        for (int jvar = 0; jvar < stringlist_get_size(keysLong); jvar++){
-
-            if (strcmp(keyword, stringlist_iget(keysLong, jvar)) == 0){ //When the keywords are equal, proceed in comparing summary files.
-                /*	if(!checkUnits(keyword)){
-                    OPM_THROW(std::runtime_error, "For keyword " << keyword << " the unit of the two files is not equal. Not possible to compare.");
-                    } //Comparing the unit of the two vectors.*/
-                checkForKeyword(timeVec1, timeVec2, keyword);
-                if(findVectorWithGreatestErrorRatio){
-                    WellProductionVolume volume = getSpecificWellVolume(timeVec1,timeVec2, keyword);
-                    findGreatestErrorRatio(volume,greatestRatio, keyword, keywordWithGreatestErrorRatio);
-                }
+        if (keywordsLong.count(keywordString) == 0){
+            if(!allowDifferentAmountOfKeywords){
+                missingKeyword = true;
                 break;
             }
-            //will only enter here if no keyword match
-            if(jvar == stringlist_get_size(keysLong)-1){
-                if(!allowDifferentAmountOfKeywords){
-                    OPM_THROW(std::invalid_argument, "No match on keyword");
-                }
-            }
+            continue;
         }
-        ivar++;
+        keywords.push_back(keyword);
+    }
+
+    checkKeywords(timeVec1, timeVec2, keywords, greatestRatio, keywordWithGreatestErrorRatio);
+    if(missingKeyword){
+        OPM_THROW(std::invalid_argument, "No match on keyword");
     }
+
     if(findVectorWithGreatestErrorRatio){
         std::cout << "The keyword " << keywordWithGreatestErrorRatio << " had the greatest error ratio, which was " << greatestRatio << std::endl;
     }
@@ -154,72 +179,94 @@ void IntegrationTest::findGreatestErrorRatio(const WellProductionVolume& volume,
 }
 
 
+void IntegrationTest::checkKeywords(const std::vector<double>& timeVec1,
+                                    const std::vector<double>& timeVec2,
+                                    const std::vector<const char*>& keywords,
+                                    double& greatestRatio,
+                                    std::string& greatestErrorRatio){
+    const bool checkVolumes = findVolumeError || oneOfTheMainVariables;
+    if (!allowSpikes && !checkVolumes && !findVectorWithGreatestErrorRatio){
+        return;
+    }
+
+    chooseReferenceFile(timeVec1, timeVec2);
+
+    // Looked up serially, since it reads the smspec data of the files.
+    std::vector<WellProductionVolume*> accumulators(keywords.size(), nullptr);
+    if (checkVolumes){
+        for (size_t k = 0; k < keywords.size(); k++)
+            accumulators[k] = volumeAccumulator(keywords[k]);
+    }
+
+    // The time axes are the same for all the keywords.
+    const TimeAlignment alignment(*referenceVec, *checkVec, TimeAlignment::Sequential);
+    const ErrorIntegral errorIntegral(*referenceVec, *checkVec);
+    const size_t numCompared = alignment.size();
+
+    std::vector<SpikeCheck> spikes(keywords.size());
+    std::vector<WellProductionVolume> volumes(keywords.size());
+    forEachKeyword(keywords, allowSpikes ? numCompared : 0,
+                   [&](size_t k, const double* referenceData, const double* checkData, std::vector<double>& values) {
+                       if (allowSpikes){
+                           alignment.apply(checkData, values.data());
+                           spikes[k] = findSpikes(referenceData, values.data(), numCompared);
+                       }
+                       if (accumulators[k] || findVectorWithGreatestErrorRatio){
+                           volumes[k].total = riemannSum(referenceVec->data(), referenceData, referenceVec->size());
+                           volumes[k].error = errorIntegral(referenceData, checkData);
+                       }
+                   },
+                   // Same order of checks as checkForKeyword() followed by getSpecificWellVolume().
+                   [&](size_t k, const double*, const double*) {
+                       const char* keyword = keywords[k];
+                       if (allowSpikes){
+                           reportSpikes(keyword, spikes[k]);
+                       }
+                       if (accumulators[k]){
+                           checkErrorRatio(keyword, volumes[k]);
+                           *accumulators[k] += volumes[k];
+                       }
+                       if (findVectorWithGreatestErrorRatio){
+                           checkErrorRatio(keyword, volumes[k]);
+                           findGreatestErrorRatio(volumes[k], greatestRatio, keyword, greatestErrorRatio);
+                       }
+                       return true;
+                   });
+}
+
+
 void IntegrationTest::volumeErrorCheck(const char* keyword){
+    WellProductionVolume* accumulator = volumeAccumulator(keyword);
+    if (accumulator){
+        *accumulator += getWellProductionVolume(keyword);
+    }
+}
+
+
+WellProductionVolume* IntegrationTest::volumeAccumulator(const char* keyword){
     const smspec_node_type * node = ecl_sum_get_general_var_node (ecl_sum_fileShort ,keyword);//doesn't matter which ecl_sum_file one uses, the kewyord SHOULD be equal in terms of smspec data.
     bool hist = smspec_node_is_historical(node);
     /* returns true if the keyword corresponds to a summary vector "history".
        E.g. WOPRH, where the last character, 'H', indicates that it is a HISTORY vector.*/
     if(hist){
-        return;//To make sure we do not include history vectors.
-    }
-    if (!mainVariable.empty()){
-        std::string keywordString(keyword);
-        std::string firstFour = keywordString.substr(0,4);
-
-        if(mainVariable == firstFour && firstFour == "WOPR"){
-            if(firstFour == "WOPR"){
-                WellProductionVolume result =  getWellProductionVolume(keyword);
-                WOP += result;
-                return;
-            }
-        }
-        if(mainVariable == firstFour && firstFour == "WWPR"){
-            if(firstFour == "WWPR"){
-                WellProductionVolume result = getWellProductionVolume(keyword);
-                WWP += result;
-                return;
-            }
-        }
-        if(mainVariable == firstFour && firstFour == "WGPR"){
-            if(firstFour == "WGPR"){
-                WellProductionVolume result = getWellProductionVolume(keyword);
-                WGP += result;
-                return;
-            }
-        }
-        if(mainVariable == firstFour && firstFour == "WBHP"){
-            if(firstFour == "WBHP"){
-                WellProductionVolume result = getWellProductionVolume(keyword);
-                WBHP += result;
-                return;
-            }
-        }
+        return nullptr;//To make sure we do not include history vectors.
     }
-    updateVolumeError(keyword);
-}
-
 
-void IntegrationTest::updateVolumeError(const char* keyword){
     std::string keywordString(keyword);
     std::string firstFour = keywordString.substr(0,4);
-
     if(firstFour == "WOPR"){
-        WellProductionVolume result =  getWellProductionVolume(keyword);
-        WOP += result;
+        return &WOP;
     }
     if(firstFour == "WWPR"){
-        WellProductionVolume result = getWellProductionVolume(keyword);
-        WWP += result;
+        return &WWP;
     }
     if(firstFour == "WGPR"){
-        WellProductionVolume result = getWellProductionVolume(keyword);
-        WGP += result;
-
+        return &WGP;
     }
     if(firstFour == "WBHP"){
-        WellProductionVolume result = getWellProductionVolume(keyword);
-        WBHP += result;
+        return &WBHP;
     }
+    return nullptr;
 }
 
 
@@ -230,12 +277,17 @@ WellProductionVolume IntegrationTest::getWellProductionVolume(const char * keywo
     WellProductionVolume wPV;
     wPV.total = total;
     wPV.error = error;
+    checkErrorRatio(keyword, wPV);
+    return wPV;
+}
+
+
+void IntegrationTest::checkErrorRatio(const char* keyword, const WellProductionVolume& wPV){
     if(wPV.total != 0 && wPV.total-wPV.error > getAbsTolerance()){
         if( (wPV.error/wPV.total > getRelTolerance()) && throwExceptionForTooGreatErrorRatio){
             OPM_THROW(std::runtime_error, "For the keyword "<< keyword << " the error ratio was " << wPV.error/wPV.total << " which is greater than the tolerance " << getRelTolerance());
         }
     }
-    return wPV;
 }
 
 
@@ -267,30 +319,70 @@ void IntegrationTest::evaluateWellProductionVolume(){
 
 
 void IntegrationTest::checkWithSpikes(const char* keyword){
+    const TimeAlignment alignment(*referenceVec, *checkVec, TimeAlignment::Sequential);
+    std::vector<double> values(alignment.size());
+    alignment.apply(checkDataVec->data(), values.data());
+    reportSpikes(keyword, findSpikes(referenceDataVec->data(), values.data(), values.size()));
+}
+
+
+IntegrationTest::SpikeCheck IntegrationTest::findSpikes(const double* referenceData, const double* checkData, size_t size){
+    const double absTol = getAbsTolerance();
+    const double relTol = getRelTolerance();
+    const size_t blockSize = DeviationKernels::block_size;
+    unsigned char exceeds[DeviationKernels::block_size];
+
+    SpikeCheck spikes;
     int errorOccurrences = 0;
-    size_t jvar = 0 ;
-    bool spikeCurrent = false;
-    Deviation deviation;
-
-    for (size_t ivar = 0; ivar < referenceVec->size(); ivar++){
-        int errorOccurrencesPrev = errorOccurrences;
-        bool spikePrev = spikeCurrent;
-        getDeviation(ivar,jvar, deviation);
-        errorOccurrences += checkDeviation(deviation);
-        if (errorOccurrences != errorOccurrencesPrev){
-            spikeCurrent = true;
-        } else{
-            spikeCurrent = false;
+    bool spikePrev = false;
+    for (size_t first = 0; first < size; first += blockSize){
+        const size_t n = std::min(blockSize, size - first);
+        size_t numExceeding = 0;
+        for (size_t i = 0; i < n; i++){
+            // Same test as checkDeviation() on the deviation from calculateDeviations().
+            const double a = referenceData[first + i];
+            const double b = checkData[first + i];
+            const double absDev = std::abs(a - b);
+            const double hi = std::max(std::abs(a), std::abs(b));
+            const double relDev = hi != 0 ? absDev / hi : 0;
+            exceeds[i] = relDev > relTol && absDev > absTol;
+            numExceeding += exceeds[i];
         }
-        if(spikePrev&&spikeCurrent){
-            std::cout << "For keyword " << keyword << " at time step " << (*referenceVec)[ivar] <<std::endl;
-            OPM_THROW(std::invalid_argument, "For keyword " << keyword << " at time step " << (*referenceVec)[ivar] << ", wwo deviations in a row exceed the limit. Not a spike value. Integration test fails." );
+
+        if (numExceeding == 0){
+            spikePrev = false;
+            continue;
         }
-        if(errorOccurrences > this->spikeLimit){
-            std::cout << "For keyword " << keyword << std::endl;
-            OPM_THROW(std::invalid_argument, "For keyword " << keyword << " too many spikes in the vector. Integration test fails.");
+
+        for (size_t i = 0; i < n; i++){
+            const bool spikeCurrent = exceeds[i];
+            errorOccurrences += spikeCurrent;
+            if (spikePrev && spikeCurrent){
+                spikes.failedStep = first + i;
+                spikes.twoInARow = true;
+                return spikes;
+            }
+            if (errorOccurrences > this->spikeLimit){
+                spikes.failedStep = first + i;
+                return spikes;
+            }
+            spikePrev = spikeCurrent;
         }
     }
+    return spikes;
+}
+
+
+void IntegrationTest::reportSpikes(const char* keyword, const SpikeCheck& spikes){
+    if (spikes.failedStep == npos){
+        return;
+    }
+    if (spikes.twoInARow){
+        std::cout << "For keyword " << keyword << " at time step " << (*referenceVec)[spikes.failedStep] <<std::endl;
+        OPM_THROW(std::invalid_argument, "For keyword " << keyword << " at time step " << (*referenceVec)[spikes.failedStep] << ", wwo deviations in a row exceed the limit. Not a spike value. Integration test fails." );
+    }
+    std::cout << "For keyword " << keyword << std::endl;
+    OPM_THROW(std::invalid_argument, "For keyword " << keyword << " too many spikes in the vector. Integration test fails.");
 }
 
 
@@ -319,16 +411,10 @@ bool IntegrationTest::checkUnits(const char * keyword){
 
 double IntegrationTest::integrate(const std::vector<double>& timeVec,
                                   const std::vector<double>& dataVec){
-    double totalSum = 0;
     if(timeVec.size() != dataVec.size()){
         OPM_THROW(std::runtime_error, "The size of the time vector does not match the size of the data vector.");
     }
-    for(size_t i = 0; i < timeVec.size()-1; i++){
-        double width = timeVec[i+1] - timeVec[i];
-        double height = dataVec[i+1];
-        totalSum += getRectangleArea(height, width);
-    }
-    return totalSum;
+    return riemannSum(timeVec.data(), dataVec.data(), timeVec.size());
 }
 
 
@@ -336,6 +422,15 @@ double IntegrationTest::integrateError(const std::vector<double>& timeVec1,
                                        const std::vector<double>& dataVec1,
                                        const std::vector<double>& timeVec2,
                                        const std::vector<double>& dataVec2){
+    if(timeVec1.size() != dataVec1.size() || timeVec2.size() != dataVec2.size() ){
+        OPM_THROW(std::runtime_error, "The size of the time vector does not match the size of the data vector.");
+    }
+    return ErrorIntegral(timeVec1, timeVec2)(dataVec1.data(), dataVec2.data());
+}
+
+
+IntegrationTest::ErrorIntegral::ErrorIntegral(const std::vector<double>& timeVec1,
+                                              const std::vector<double>& timeVec2){
     // When the data corresponds to a rate the integration will become a Riemann
     // sum.  This function calculates the Riemann sum of the error.  The reason why
     // a Riemann sum is used is because of the way the data is written to file.
@@ -353,49 +448,47 @@ double IntegrationTest::integrateError(const std::vector<double>& timeVec1,
     // someDataVector[ivar] instead of someDataVector[ivar-1]
     //
     // (which intuition is saying is the correct value to use).
+    //
+    // The rectangles only depend on the time steps, so they are found here once:
+    // in every case the height is |dataVec1[i] - dataVec2[j]| for the current i and j.
 
-    if(timeVec1.size() != dataVec1.size() || timeVec2.size() != dataVec2.size() ){
-        OPM_THROW(std::runtime_error, "The size of the time vector does not match the size of the data vector.");
+    if(timeVec1.empty() || timeVec2.empty()){
+        return;
     }
-    double errorSum = 0;
-    double rightEdge, leftEdge, width;
     size_t i = 1;
     size_t j = 1;
-    leftEdge = timeVec1[0];
-    while(i < timeVec1.size()){
-        if(j == timeVec2.size() ){
-            break;
-        }
-        if(timeVec1[i] == timeVec2[j]){
-            rightEdge = timeVec1[i];
-            width = rightEdge - leftEdge;
-            double dev = std::fabs(dataVec1[i] - dataVec2[j]);
-            errorSum += getRectangleArea(dev, width);
-            leftEdge = rightEdge;
-            i++;
-            j++;
-            continue;
-        }
-        if(timeVec1[i] < timeVec2[j]){
-            rightEdge = timeVec1[i];
-            width = rightEdge - leftEdge;
-            double value = unitStep(dataVec2[j]);
-            double dev = std::fabs(dataVec1[i]-value);
-            errorSum += getRectangleArea(dev, width);
-            leftEdge = rightEdge;
-            i++;
-            continue;
-        }
-        if(timeVec2[j] < timeVec1[i]){
-            rightEdge = timeVec2[j];
-            width = rightEdge - leftEdge;
-            double value = unitStep(dataVec1[i]);
-            double dev = std::fabs(dataVec2[j]-value);
-            errorSum += getRectangleArea(dev, width);
-            leftEdge = rightEdge;
-            j++;
-            continue;
-        }
+    double leftEdge = timeVec1[0];
+    while(i < timeVec1.size() && j < timeVec2.size()){
+        const double rightEdge = std::min(timeVec1[i], timeVec2[j]);
+        widths.push_back(rightEdge - leftEdge);
+        index1.push_back(i);
+        index2.push_back(j);
+        leftEdge = rightEdge;
+
+        const bool step1 = timeVec1[i] <= timeVec2[j];
+        const bool step2 = timeVec2[j] <= timeVec1[i];
+        i += step1;
+        j += step2;
+    }
+}
+
+
+double IntegrationTest::ErrorIntegral::operator()(const double* dataVec1, const double* dataVec2) const {
+    const size_t size = widths.size();
+    const double* w = widths.data();
+    const size_t* i1 = index1.data();
+    const size_t* i2 = index2.data();
+
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t k = 0;
+    for (; k + 4 <= size; k += 4){
+        s0 += getRectangleArea(std::fabs(dataVec1[i1[k]] - dataVec2[i2[k]]), w[k]);
+        s1 += getRectangleArea(std::fabs(dataVec1[i1[k + 1]] - dataVec2[i2[k + 1]]), w[k + 1]);
+        s2 += getRectangleArea(std::fabs(dataVec1[i1[k + 2]] - dataVec2[i2[k + 2]]), w[k + 2]);
+        s3 += getRectangleArea(std::fabs(dataVec1[i1[k + 3]] - dataVec2[i2[k + 3]]), w[k + 3]);
+    }
+    for (; k < size; k++){
+        s0 += getRectangleArea(std::fabs(dataVec1[i1[k]] - dataVec2[i2[k]]), w[k]);
     }
-    return errorSum;
+    return (s0 + s1) + (s2 + s3);
 }
@@ -18,6 +18,7 @@
    */
 
 #include <opm/test_util/summaryComparator.hpp>
+#include <limits>
 
 //! \brief Struct for storing the total area under a graph.
 //! \details Used when plotting summary vector against time. In most cases this represents a volume.
@@ -51,6 +52,40 @@ class IntegrationTest: public SummaryComparator {
         WellProductionVolume WGP;//!< WellProductionVolume struct for storing the total production volume and total error volume of all the keywords which start with WGPR
         WellProductionVolume WBHP; //!< WellProductionVolume struct for storing the value of the area under the graph when plotting summary vector/deviation vector against time.This is for keywords starting with WBHP. \nNote: the name of the struct may be misleading, this is not an actual volume.
 
+        //! \brief The Riemann sum of the error between two summary vectors, for any data on two fixed time axes.
+        //! \details The two time axes are merged once, as in integrateError(). For each interval of the merged axis the width and the index of the value of each vector to use are stored, so the error of one keyword is a single loop over the intervals.
+        class ErrorIntegral {
+            public:
+                ErrorIntegral(const std::vector<double>& timeVec1, const std::vector<double>& timeVec2);
+
+                //! \brief The integrated error; dataVec1 and dataVec2 hold one value for each time step of timeVec1 and timeVec2.
+                double operator()(const double* dataVec1, const double* dataVec2) const;
+
+            private:
+                std::vector<double> widths;
+                std::vector<size_t> index1;
+                std::vector<size_t> index2;
+        };
+
+        //! \brief The result of the spike check of one keyword.
+        struct SpikeCheck {
+            size_t failedStep = std::numeric_limits<size_t>::max(); //!< The reference time step where the check fails, or the maximum size_t if it passes.
+            bool twoInARow = false; //!< True if the check fails because two deviations in a row exceed the limit, false if there are too many spikes.
+        };
+
+        //! \brief Runs the checks of the integration test for a list of keywords.
+        //! \param[in] timeVec1 A std::vector<double> that contains the time steps of file 1.
+        //! \param[in] timeVec2 A std::vector<double> that contains the time steps of file 2.
+        //! \param[in] keywords The keywords to check, they must be present in both files.
+        //! \param[in,out] greatestRatio The greatest error ratio, see findGreatestErrorRatio().
+        //! \param[in,out] greatestErrorRatio The keyword with the greatest error ratio.
+        //! \details The keywords are processed in batches with SummaryComparator::forEachKeyword(): the spike check and the integrated volumes of the keywords in a batch are computed in parallel, \n and then the results are checked, accumulated and reported in the order of the keywords, so the outcome is the same as calling checkForKeyword() for each keyword.
+        void checkKeywords(const std::vector<double>& timeVec1,
+                           const std::vector<double>& timeVec2,
+                           const std::vector<const char*>& keywords,
+                           double& greatestRatio,
+                           std::string& greatestErrorRatio);
+
 
         //! \brief The function gathers the correct data for comparison for a specific keyword
         //! \param[in] timeVec1 A std::vector<double> that contains the time steps of file 1.
@@ -77,9 +112,19 @@ class IntegrationTest: public SummaryComparator {
 
         //! \brief The function is a regression test which allows spikes.
         //! \param[in] keyword The keyword of interest, the keyword the summary vectors "belong" to.
-        //! \details The function requires the protected member variables referenceVec, referenceDataVec, checkVec and checkDataVec to be stored with data, which is staisfied if it is called by checkForKeyword. \n It compares the two vectors value by value, and if the deviation is unsatisfying, the errorOccurrenceCounter is incremented. If the errorOccurrenceCounter becomes greater than the errorOccurrenceLimit, \n a exception is thrown. The function will allow spike values, however, if two values in a row exceed the deviation limit, they are no longer spikes, and an exception is thrown.
+        //! \details The function requires the protected member variables referenceVec, referenceDataVec, checkVec and checkDataVec to be stored with data, which is staisfied if it is called by checkForKeyword. \n It compares the two vectors value by value, with the checked values aligned by TimeAlignment::Sequential, and if the deviation is unsatisfying, the errorOccurrenceCounter is incremented. If the errorOccurrenceCounter becomes greater than the errorOccurrenceLimit, \n a exception is thrown. The function will allow spike values, however, if two values in a row exceed the deviation limit, they are no longer spikes, and an exception is thrown.
         void checkWithSpikes(const char* keyword);
 
+        //! \brief Finds the reference time step where checkWithSpikes() fails.
+        //! \param[in] referenceData The reference values.
+        //! \param[in] checkData The checked values, aligned with the reference values by TimeAlignment::Sequential.
+        //! \param[in] size The number of values.
+        //! \details The deviations of a block of values are tested against the tolerances in one branch free loop, and the blocks are only scanned value by value if they have a violation. \n The function only reads member variables, and can be called concurrently.
+        SpikeCheck findSpikes(const double* referenceData, const double* checkData, size_t size);
+
+        //! \brief Writes an error message and throws if the spike check failed.
+        void reportSpikes(const char* keyword, const SpikeCheck& spikes);
+
         //! \brief Caluculates a deviation, throws exceptions and writes and error message.
         //! \param[in] deviation Deviation struct
         //! \param[out] int Returns 0/1, depending on wheter the deviation exceeded the limit or not.
@@ -92,13 +137,16 @@ class IntegrationTest: public SummaryComparator {
         //! \details The function calculates the total production volume and total error volume of a keyword, by the trapezoid integral method. \n The function throws and exception if the total error volume is negative. The function returns the results as a struct.
         WellProductionVolume getWellProductionVolume(const char* keyword);
 
+        //! \brief Throws if the error ratio of a volume is too great, see #throwExceptionForTooGreatErrorRatio.
+        void checkErrorRatio(const char* keyword, const WellProductionVolume& volume);
+
         //! \brief The function function works properly when the private member variables are set (after running the integration test which findVolumeError = true). \n It prints out the total production volume, the total error volume and the error ratio.
         void evaluateWellProductionVolume();
 
-        //! \brief The function calculates the total production volume and total error volume
+        //! \brief Finds the member WellProductionVolume variable which the volumes of a keyword are added to.
         //! \param keyword The keyword of interest
-        //! \details The function uses the data that is stored in the member variable vectors. It calculates the total production volume \n and the total error volume of the specified keyword, and adds the result to the private member WellProductionVolume variables of the class.
-        void updateVolumeError(const char* keyword);
+        //! \details Returns nullptr for history vectors and for keywords which are not WOPR, WWPR, WGPR or WBHP.
+        WellProductionVolume* volumeAccumulator(const char* keyword);
 
         //! \brief Finds the keyword which has the greates error volume ratio
         //! \param[in] volume WellProductionVolume struct which contains the data used for comparison
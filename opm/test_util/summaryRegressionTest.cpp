@@ -17,10 +17,13 @@
    */
 
 #include <opm/test_util/summaryRegressionTest.hpp>
+#include <opm/test_util/DeviationKernels.hpp>
 #include <opm/common/ErrorMacros.hpp>
 #include <ert/ecl/ecl_sum.h>
 #include <ert/util/stringlist.h>
+#include <atomic>
 #include <string>
+#include <unordered_set>
 
 void RegressionTest::getRegressionTest(){
     std::vector<double> timeVec1, timeVec2;
@@ -51,26 +54,31 @@ void RegressionTest::getRegressionTest(){
     }
 
 
-    //Iterates over all keywords from the restricted file, use iterator "ivar". Searches for a  match in the file with more keywords, use the iterator "jvar".
-    bool throwAtEnd = false;
+    //Iterates over all keywords from the restricted file, use iterator "ivar", and looks for a match in the file with more keywords. The keywords up to the first one without a match are compared.
+    std::unordered_set<std::string> keywordsLong;
+    for (int jvar = 0; jvar < stringlist_get_size(keysLong); jvar++){
+        keywordsLong.insert(stringlist_iget(keysLong, jvar));
+    }
+    std::vector<const char*> keywords;
+    const char* missingKeyword = nullptr;
     while(ivar < stringlist_get_size(keysShort)){
         const char* keyword = stringlist_iget(keysShort, ivar);
         std::string keywordString(keyword);
-        for (int jvar = 0; jvar < stringlist_get_size(keysLong); jvar++){
-            if (strcmp(keyword, stringlist_iget(keysLong, jvar)) == 0){ //When the keywords are equal, proceed in comparing summary files.
-                if (isRestartFile && keywordString.substr(3,1)=="T"){
-                    break;
-                }
-                throwAtEnd |= !checkForKeyword(timeVec1, timeVec2, keyword);
-                break;
-            }
-            //will only enter here if no keyword match
-            if(jvar == stringlist_get_size(keysLong)-1){
-                std::cout << "Could not find keyword: " << stringlist_iget(keysShort, ivar) << std::endl;
-                OPM_THROW(std::runtime_error, "No match on keyword");
-            }
-        }
         ivar++;
+        if (keywordsLong.count(keywordString) == 0){
+            missingKeyword = keyword;
+            break;
+        }
+        if (isRestartFile && keywordString.substr(3,1)=="T"){
+            continue;
+        }
+        keywords.push_back(keyword);
+    }
+
+    bool throwAtEnd = !compareKeywords(timeVec1, timeVec2, keywords);
+    if (missingKeyword){
+        std::cout << "Could not find keyword: " << missingKeyword << std::endl;
+        OPM_THROW(std::runtime_error, "No match on keyword");
     }
     if (throwAtEnd)
       OPM_THROW(std::runtime_error, "Regression test failed.");
@@ -89,7 +97,7 @@ void RegressionTest::getRegressionTest(const char* keyword){
         if (isRestartFile && keywordString.substr(3,1)=="T"){
             return;
         }
-        if (checkForKeyword(timeVec1, timeVec2, keyword))
+        if (compareKeywords(timeVec1, timeVec2, {keyword}))
           std::cout << "Regression test succeeded." << std::endl;
         else
           OPM_THROW(std::runtime_error, "Regression test failed");
@@ -102,15 +110,14 @@ void RegressionTest::getRegressionTest(const char* keyword){
 
 
 
-bool RegressionTest::checkDeviation(Deviation deviation, const char* keyword, int refIndex, int checkIndex){
+bool RegressionTest::checkDeviation(Deviation deviation, const char* keyword, double refTime, double refValue, double checkTime, double checkValue){
     double absTol = getAbsTolerance();
     double relTol = getRelTolerance();
 
     if (deviation.rel > relTol && deviation.abs > absTol){
         std::cout << "For keyword " << keyword  << std::endl;
-        std::cout << "(days, reference value) and (days, check value) = (" << (*referenceVec)[refIndex] << ", " << (*referenceDataVec)[refIndex]
-            << ") and (" << (*checkVec)[checkIndex-1] << ", " << (*checkDataVec)[checkIndex-1] << ")\n";
-        // -1 in [checkIndex -1] because checkIndex is updated after leaving getDeviation function
+        std::cout << "(days, reference value) and (days, check value) = (" << refTime << ", " << refValue
+            << ") and (" << checkTime << ", " << checkValue << ")\n";
         std::cout << "The absolute deviation is " << deviation.abs << ". The tolerance limit is " << absTol << std::endl;
         std::cout << "The relative deviation is " << deviation.rel << ". The tolerance limit is " << relTol << std::endl;
         HANDLE_ERROR(std::runtime_error, "Deviation exceed the limit.");
@@ -121,23 +128,59 @@ bool RegressionTest::checkDeviation(Deviation deviation, const char* keyword, in
 
 
 
-bool RegressionTest::checkForKeyword(std::vector<double>& timeVec1, std::vector<double>& timeVec2, const char* keyword){
-    std::vector<double> dataVec1, dataVec2;
-    getDataVecs(dataVec1,dataVec2,keyword);
-    chooseReference(timeVec1, timeVec2,dataVec1,dataVec2);
-    return startTest(keyword);
+bool RegressionTest::compareKeywords(const std::vector<double>& timeVec1, const std::vector<double>& timeVec2,
+                                     const std::vector<const char*>& keywords){
+    chooseReferenceFile(timeVec1, timeVec2);
+    const TimeAlignment alignment(*referenceVec, *checkVec, interpolation);
+
+    const double absTol = getAbsTolerance();
+    const double relTol = getRelTolerance();
+    const size_t numCompared = alignment.size();
+
+    // With earlyExit the keywords after the first known failure are skipped. The keywords in front of it
+    // are always compared, so the failure which is reported is the first one in keyword order.
+    std::vector<DeviationStats> stats(keywords.size());
+    std::atomic<size_t> firstFailure(DeviationStats::npos);
+    bool passed = true;
+    forEachKeyword(keywords, numCompared,
+                   [&](size_t k, const double* referenceData, const double* checkData, std::vector<double>& values) {
+                       if (earlyExit && k > firstFailure.load(std::memory_order_relaxed))
+                           return;
+
+                       alignment.apply(checkData, values.data());
+                       stats[k] = DeviationKernels::summaryDeviations(referenceData, values.data(), numCompared, absTol, relTol);
+
+                       if (stats[k].numErrors > 0){
+                           size_t current = firstFailure.load(std::memory_order_relaxed);
+                           while (k < current && !firstFailure.compare_exchange_weak(current, k, std::memory_order_relaxed)) {}
+                       }
+                   },
+                   [&](size_t k, const double* referenceData, const double* checkData) {
+                       if (stats[k].numErrors == 0)
+                           return true;
+
+                       reportKeyword(keywords[k], referenceData, checkData, alignment, stats[k]);
+                       passed = false;
+                       return !earlyExit;
+                   });
+
+    return passed;
 }
 
 
 
-bool RegressionTest::startTest(const char* keyword){
-    size_t jvar = 0;
-    Deviation deviation;
-    bool result = true;
-    for (size_t ivar = 0; ivar < referenceVec->size(); ivar++){
-        getDeviation(ivar, jvar, deviation);//Reads from the protected member variables in the super class.
-        result = checkDeviation(deviation, keyword,ivar, jvar);
+void RegressionTest::reportKeyword(const char* keyword, const double* referenceData, const double* checkData,
+                                   const TimeAlignment& alignment, const DeviationStats& stats){
+    for (size_t ivar = stats.firstError; ivar < alignment.size(); ivar++){
+        const double checkValue = alignment.value(checkData, ivar);
+        Deviation deviation = calculateDeviations(referenceData[ivar], checkValue);
+        const bool passed = checkDeviation(deviation, keyword, (*referenceVec)[ivar], referenceData[ivar],
+                                           alignment.time(ivar), checkValue);
+        if (!passed && earlyExit)
+            return;
     }
 
-    return result;
+    std::cout << "For keyword " << keyword << " " << stats.numErrors << " of " << alignment.size()
+              << " time steps exceed the limits. The largest absolute deviation is " << stats.maxAbs
+              << " and the largest relative deviation is " << stats.maxRel << "." << std::endl;
 }
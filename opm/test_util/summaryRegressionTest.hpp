@@ -21,33 +21,45 @@
 #define SUMMARYREGRESSIONTEST_HPP
 
 #include <opm/test_util/summaryComparator.hpp>
+#include <opm/test_util/TimeAlignment.hpp>
+
+struct DeviationStats;
 
 //! \details  The class inherits from the SummaryComparator class, which takes care of all file reading. \n The RegressionTest class compares the values from the two different files and throws exceptions when the deviation is unsatisfying.
 class RegressionTest: public SummaryComparator {
     private:
-        //! \brief Gathers the correct data for comparison for a specific keyword
+        //! \brief The regression test for a list of keywords
         //! \param[in] timeVec1 The time steps of file 1.
         //! \param[in] timeVec2 The time steps of file 2.
-        //! \param[in] keyword The keyword of interest
-        //! \details The function prepares a regression test by gathering the data, stroing it into two vectors, \n deciding which is to be used as a reference/basis and calling the test function.
+        //! \param[in] keywords The keywords to compare, they must be present in both files.
+        //! \details The file with the fewer time steps is used as the reference, and the two time axes are aligned once with a TimeAlignment for all the keywords. \n The keywords are processed in batches with SummaryComparator::forEachKeyword(): the keywords of a batch are compared in parallel, \n and the violations are then reported with reportKeyword(), in the order of the keywords. With #earlyExit the comparison stops at the first keyword with a violation.
         //! \return True if check passed, false otherwise.
-        bool checkForKeyword(std::vector<double>& timeVec1, std::vector<double>& timeVec2, const char* keyword);
+        bool compareKeywords(const std::vector<double>& timeVec1, const std::vector<double>& timeVec2, const std::vector<const char*>& keywords);
 
-        //! \brief The regression test
-        //! \param[in] keyword The keyword common for both the files. The vectors associated with the keyword are used for comparison.
-        //! \details Start test uses the private member variables, pointers of std::vector<double> type, which are set to point to the correct vectors in SummaryComparison::chooseReference(...). \n The function iterates over the referenceVev/basis and for each iteration it calculates the deviation with SummaryComparison::getDeviation(..) and stors it in a Deviation struct. \n SummaryComparison::getDeviation takes the int jvar as an reference input, and using it as an iterative index for the values which are to be compared with the basis. \n Thus, by updating the jvar variable every time a deviation is calculated, one keep track jvar and do not have to iterate over already checked values.
-        bool startTest(const char* keyword);
+        //! \brief Reports the violations of one keyword.
+        //! \param[in] keyword The keyword the data belongs to.
+        //! \param[in] referenceData The data of the reference file.
+        //! \param[in] checkData The data of the file which is checked.
+        //! \param[in] alignment The alignment of the checked time steps to the reference time steps.
+        //! \param[in] stats The deviations of the keyword.
+        //! \details Calls checkDeviation() for each time step from the first violation. With #earlyExit only the first violation is reported, otherwise all the violations are reported and followed by a summary of the deviations of the keyword.
+        void reportKeyword(const char* keyword, const double* referenceData, const double* checkData,
+                           const TimeAlignment& alignment, const DeviationStats& stats);
 
         //! \brief Caluculates a deviation, throws exceptions and writes and error message.
         //! \param[in] deviation Deviation struct
         //! \param[in] keyword The keyword that the data that are being compared belongs to.
-        //! \param[in] refIndex The report step of which the deviation originates from in #referenceDataVec.
-        //! \param[in] checkIndex The report step of which the deviation originates from in #checkDataVec.
+        //! \param[in] refTime The time of the reference value.
+        //! \param[in] refValue The reference value.
+        //! \param[in] checkTime The time of the checked value, see TimeAlignment::time().
+        //! \param[in] checkValue The checked value.
         //! \details The function checks the values of the Deviation struct against the absolute and relative tolerance, which are private member values of the super class. \n When comparing against the relative tolerance an additional term is added, the absolute deviation has to be greater than 1e-6 for the function to throw an exception. \n When the deviations are too great, the function writes out which keyword, and at what report step the deviation is too great before optionally throwing an exception.
         //! \return True if check passed, false otherwise.
-        bool checkDeviation(Deviation deviation, const char* keyword, int refIndex, int checkIndex);
+        bool checkDeviation(Deviation deviation, const char* keyword, double refTime, double refValue, double checkTime, double checkValue);
 
         bool isRestartFile = false; //!< Private member variable, when true the files that are being compared is a restart file vs a normal file
+        bool earlyExit = false; //!< Private member variable, when true the comparison stops at the first violation, otherwise all the violations are reported
+        TimeAlignment::Method interpolation = TimeAlignment::Sequential; //!< How the values of the checked file are found at the reference time steps
     public:
         //! \brief Constructor, creates an object of RefressionTest class.
         //! \param[in] basename1 Path to file1 without extension.
@@ -67,6 +79,15 @@ class RegressionTest: public SummaryComparator {
         //! \brief This function sets the private member variable isRestartFiles
         //! \param[in] boolean Boolean value
         void setIsRestartFile(bool boolean){this->isRestartFile = boolean;}
+
+        //! \brief This function sets the private member variable earlyExit
+        //! \param[in] boolean Boolean value
+        //! \details When earlyExit is true the test stops at the first violation, which is the fastest way to fail. Otherwise all the keywords are compared, and, when not throwing on errors, all the violations are reported.
+        void setEarlyExit(bool boolean){this->earlyExit = boolean;}
+
+        //! \brief This function sets the private member variable interpolation
+        //! \param[in] method How the values of the checked file are found at the reference time steps, by default TimeAlignment::Sequential.
+        void setInterpolation(TimeAlignment::Method method){this->interpolation = method;}
 };
 
 #endif
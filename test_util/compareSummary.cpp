@@ -40,7 +40,10 @@ void printHelp(){
     std::cout << "-h \t\tPrint help message." << std::endl << std::endl;
     std::cout << "For the regression test: " << std::endl;
     std::cout << "-r \t\tChoosing regression test (this is default)."<< std::endl;
+    std::cout << "-e \t\tStop at the first deviation which exceeds the limits. By default all the keywords are compared." << std::endl;
     std::cout << "-k keyword \tSpecify a specific keyword to compare, for example - k WOPR:PRODU1."<< std::endl;
+    std::cout << "-l \t\tInterpolate linearly between the time steps of the file with more time steps. By default the value at the next time step is used, \n\t\tand each of its time steps is compared once." << std::endl;
+    std::cout << "-u \t\tUse the value at the next time step of the file with more time steps, also when it is compared already." << std::endl;
     std::cout << "-p \t\tWill print the keywords of the files." << std::endl;
     std::cout << "-R \t\tWill allow comparison between a restarted simulation and a normal simulation. The files must end at the same time." << std::endl << std::endl;
     std::cout << "For the integration test:"<< std::endl;
@@ -80,6 +83,8 @@ int main (int argc, char ** argv){
     bool throwExceptionForTooGreatErrorRatio = true;
     bool isRestartFile = false;
     bool throwOnError = true;
+    bool earlyExit = false;
+    TimeAlignment::Method interpolation = TimeAlignment::Sequential;
     const char* keyword  = nullptr;
     const char* mainVariable = nullptr;
     int c = 0;
@@ -88,11 +93,14 @@ int main (int argc, char ** argv){
 
     //------------------------------------------------
     //For setting the options selected
-    while ((c = getopt(argc, argv, "dghik:Km:npP:rRs:vV:")) != -1) {
+    while ((c = getopt(argc, argv, "deghik:lKm:npP:rRs:uvV:")) != -1) {
         switch (c) {
             case 'd':
                 throwExceptionForTooGreatErrorRatio = false;
                 break;
+            case 'e':
+                earlyExit = true;
+                break;
             case 'g':
                 findVectorWithGreatestErrorRatio = true;
                 throwExceptionForTooGreatErrorRatio = false;
@@ -108,6 +116,9 @@ int main (int argc, char ** argv){
                 specificKeyword = true;
                 keyword = optarg;
                 break;
+            case 'l':
+                interpolation = TimeAlignment::Linear;
+                break;
             case 'K':
                 allowDifferentAmountOfKeywords = false;
                 break;
@@ -137,6 +148,9 @@ int main (int argc, char ** argv){
                 allowSpikes = true;
                 limit = atof(optarg);
                 break;
+            case 'u':
+                interpolation = TimeAlignment::UnitStep;
+                break;
             case 'v':
                 findVolumeError = true;
                 break;
@@ -179,6 +193,8 @@ int main (int argc, char ** argv){
             compare.throwOnErrors(throwOnError);
             if(printKeywords){compare.setPrintKeywords(true);}
             if(isRestartFile){compare.setIsRestartFile(true);}
+            if(earlyExit){compare.setEarlyExit(true);}
+            compare.setInterpolation(interpolation);
             if(specificKeyword){
                 compare.getRegressionTest(keyword);
             }
@@ -0,0 +1,113 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify it under the terms
+   of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+/*
+  Micro benchmark for the conversion of a double precision SI field to
+  a float keyword in output units. The "two pass" path is how the
+  restart and INIT writers used to do it: convert a copy of the field
+  in place with UnitSystem::from_si() and then narrow it element by
+  element to float. The "fused" path is out::UnitConversion, which does
+  both in one pass straight into the output buffer.
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+#include <getopt.h>
+
+#include <opm/parser/eclipse/Units/UnitSystem.hpp>
+
+#include <opm/output/eclipse/UnitConversion.hpp>
+
+using namespace Opm;
+
+namespace {
+
+void printHelp() {
+    std::cout << "convertBenchmark [-n cells] [-r repeat]" << std::endl << std::endl;
+    std::cout << "-n cells \tNumber of values in the field (default 5000000)." << std::endl;
+    std::cout << "-r repeat \tNumber of times each path is timed (default 20)." << std::endl;
+    std::cout << "-h \t\tPrint help message." << std::endl;
+}
+
+
+void twoPass( const UnitSystem& units, UnitSystem::measure m, const std::vector<double>& si, std::vector<float>& output ) {
+    auto converted = si;
+    units.from_si( m, converted );
+    for (size_t i = 0; i < converted.size(); i++)
+        output[i] = converted[i];
+}
+
+
+void fused( const UnitSystem& units, UnitSystem::measure m, const std::vector<double>& si, std::vector<float>& output ) {
+    out::UnitConversion( units, m ).apply( si.data(), si.size(), output.data() );
+}
+
+
+template <typename F>
+double bytesPerSecond( F f, const UnitSystem& units, const std::vector<double>& si, std::vector<float>& output, int repeat ) {
+    using clock = std::chrono::steady_clock;
+    std::chrono::duration< double > elapsed( 0 );
+
+    for (int r = 0; r < repeat; r++) {
+        const auto start = clock::now();
+        f( units, UnitSystem::measure::pressure, si, output );
+        elapsed += clock::now() - start;
+    }
+
+    const double bytes = double( repeat ) * si.size() * (sizeof( double ) + sizeof( float ));
+    return bytes / elapsed.count();
+}
+
+}
+
+
+int main(int argc, char ** argv) {
+    size_t num_cells = 5000000;
+    int repeat = 20;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:r:h")) != -1) {
+        switch (c) {
+            case 'n': num_cells = std::atol( optarg ); break;
+            case 'r': repeat = std::atoi( optarg ); break;
+            case 'h':
+                printHelp();
+                return 0;
+            default:
+                printHelp();
+                return 1;
+        }
+    }
+
+    const auto units = UnitSystem::newFIELD();
+    std::vector<double> si( num_cells );
+    for (size_t i = 0; i < num_cells; i++)
+        si[i] = 1e7 + i;
+
+    std::vector<float> output( num_cells );
+    const double two_pass = bytesPerSecond( twoPass, units, si, output, repeat );
+    const double one_pass = bytesPerSecond( fused, units, si, output, repeat );
+
+    std::cout << "Values: " << num_cells << " repeat: " << repeat << std::endl;
+    std::cout << "Two pass (from_si + narrow): " << two_pass / 1e6 << " MB/s" << std::endl;
+    std::cout << "Fused (UnitConversion):      " << one_pass / 1e6 << " MB/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,237 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify it under the terms
+   of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+/*
+  Small benchmark for the summary evaluation in out::Summary. The
+  program creates a deck with the same structure as the
+  tests/summary_deck.DATA test deck, but scaled up to a configurable
+  number of cells, wells, groups and report steps, and then times the
+  calls to add_timestep() and write().
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+
+#include <opm/parser/eclipse/Deck/Deck.hpp>
+#include <opm/parser/eclipse/Parser/ParseContext.hpp>
+#include <opm/parser/eclipse/Parser/Parser.hpp>
+#include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
+#include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
+#include <opm/parser/eclipse/EclipseState/Schedule/Well.hpp>
+#include <opm/parser/eclipse/EclipseState/SummaryConfig/SummaryConfig.hpp>
+
+#include <opm/output/data/Solution.hpp>
+#include <opm/output/data/Wells.hpp>
+#include <opm/output/eclipse/Summary.hpp>
+
+using namespace Opm;
+
+namespace {
+
+void printHelp() {
+    std::cout << "summaryBenchmark [-n nxyz] [-w wells] [-g groups] [-s steps]" << std::endl << std::endl;
+    std::cout << "-n nxyz \tGrid dimension in each direction, i.e. the grid has nxyz^3 cells (default 20)." << std::endl;
+    std::cout << "-w wells \tNumber of wells (default 200)." << std::endl;
+    std::cout << "-g groups \tNumber of groups, the wells are distributed evenly in the groups (default 20)." << std::endl;
+    std::cout << "-s steps \tNumber of report steps (default 100)." << std::endl;
+    std::cout << "-h \t\tPrint help message." << std::endl;
+}
+
+
+std::string createDeck( int nxyz, int num_wells, int num_groups, int num_steps ) {
+    const int num_cells = nxyz * nxyz * nxyz;
+    std::stringstream deck;
+
+    deck << "START\n10 MAI 2007 /\n"
+         << "RUNSPEC\n"
+         << "DIMENS\n " << nxyz << " " << nxyz << " " << nxyz << " /\n"
+         << "REGDIMS\n " << nxyz << " /\n"
+         << "WELLDIMS\n " << num_wells << " " << nxyz << " " << num_groups << " " << num_wells << " /\n"
+         << "OIL\nGAS\nWATER\n"
+         << "GRID\n"
+         << "DX\n" << num_cells << "*1 /\n"
+         << "DY\n" << num_cells << "*1 /\n"
+         << "DZ\n" << num_cells << "*1 /\n"
+         << "TOPS\n" << nxyz * nxyz << "*1 /\n"
+         << "PORO\n" << num_cells << "*0.2 /\n"
+         << "REGIONS\n"
+         << "FIPNUM\n";
+
+    for (int k = 0; k < nxyz; k++)
+        deck << " " << nxyz * nxyz << "*" << k + 1;
+    deck << " /\n";
+
+    deck << "SUMMARY\n";
+    for (const auto* kw : { "FOPR", "FWPR", "FGPR", "FLPR", "FOPT", "FWPT", "FGPT", "FWIR", "FGIR",
+                            "FWIT", "FGIT", "FWCT", "FGOR", "FOIP", "FGIP", "FWIP", "FPR" })
+        deck << kw << "\n";
+
+    for (const auto* kw : { "GOPR", "GWPR", "GGPR", "GLPR", "GOPT", "GWPT", "GGPT", "GWIR", "GGIR",
+                            "GWIT", "GGIT", "GWCT", "GGOR", "GOPRH", "GWPRH", "GGPRH" })
+        deck << kw << "\n/\n";
+
+    for (const auto* kw : { "WOPR", "WWPR", "WGPR", "WLPR", "WOPT", "WWPT", "WGPT", "WWIR", "WGIR",
+                            "WWIT", "WGIT", "WWCT", "WGOR", "WBHP", "WTHP", "WOPRH", "WWPRH", "WGPRH" })
+        deck << kw << "\n/\n";
+
+    for (const auto* kw : { "RPR", "ROIP", "RGIP", "RWIP", "ROPR", "RWPR", "RGPR", "ROPT" })
+        deck << kw << "\n/\n";
+
+    deck << "SCHEDULE\n"
+         << "WELSPECS\n";
+    for (int w = 0; w < num_wells; w++)
+        deck << " 'W_" << w + 1 << "' 'G_" << w % num_groups + 1 << "' "
+             << w % nxyz + 1 << " " << (w / nxyz) % nxyz + 1 << " 1* 'OIL' 7* /\n";
+    deck << "/\n";
+
+    deck << "COMPDAT\n";
+    for (int w = 0; w < num_wells; w++)
+        deck << " 'W_" << w + 1 << "' 0 0 1 " << nxyz << " 'OPEN' /\n";
+    deck << "/\n";
+
+    deck << "WCONHIST\n";
+    for (int w = 0; w < num_wells; w++)
+        deck << " 'W_" << w + 1 << "' 'OPEN' 'ORAT' 10.1 10 10.2 /\n";
+    deck << "/\n";
+
+    deck << "TSTEP\n " << num_steps << "*1 /\n";
+    return deck.str();
+}
+
+
+data::Wells createWells( const Schedule& schedule, const EclipseGrid& grid ) {
+    using rt = data::Rates::opt;
+    data::Wells wells;
+    const double day = 24 * 3600;
+
+    for (const auto* sched_well : schedule.getWells()) {
+        auto& well = wells[ sched_well->name() ];
+
+        well.rates.set( rt::wat, -10.0 / day )
+                  .set( rt::oil, -10.1 / day )
+                  .set( rt::gas, -10.2 / day );
+        well.bhp = 1e7;
+        well.thp = 1e6;
+        well.temperature = 300;
+        well.control = 1;
+
+        for (const auto& completion : sched_well->getCompletions( 0 )) {
+            const auto global_index = grid.getGlobalIndex( completion.getI(), completion.getJ(), completion.getK() );
+            if (!grid.cellActive( global_index ))
+                continue;
+
+            data::Completion c;
+            c.index = grid.activeIndex( global_index );
+            c.rates.set( rt::wat, -1.0 / day )
+                   .set( rt::oil, -1.01 / day )
+                   .set( rt::gas, -1.02 / day );
+            c.pressure = 1e7;
+            c.reservoir_rate = 1.0 / day;
+            well.completions.push_back( c );
+        }
+    }
+
+    return wells;
+}
+
+
+data::Solution createSolution( const EclipseGrid& grid ) {
+    using measure = UnitSystem::measure;
+    const auto num_active = grid.getNumActive();
+    data::Solution sol;
+
+    sol.insert( "PRESSURE", measure::pressure, std::vector<double>( num_active, 1e7 ), data::TargetType::RESTART_SOLUTION );
+    sol.insert( "SWAT", measure::identity, std::vector<double>( num_active, 0.2 ), data::TargetType::RESTART_SOLUTION );
+    sol.insert( "SGAS", measure::identity, std::vector<double>( num_active, 0.1 ), data::TargetType::RESTART_SOLUTION );
+    sol.insert( "OIP", measure::volume, std::vector<double>( num_active, 0.15 ), data::TargetType::SUMMARY );
+    sol.insert( "GIP", measure::volume, std::vector<double>( num_active, 0.05 ), data::TargetType::SUMMARY );
+    sol.insert( "WIP", measure::volume, std::vector<double>( num_active, 0.05 ), data::TargetType::SUMMARY );
+    return sol;
+}
+
+}
+
+
+int main(int argc, char ** argv) {
+    int nxyz = 20;
+    int num_wells = 200;
+    int num_groups = 20;
+    int num_steps = 100;
+    int c;
+
+    while ((c = getopt(argc, argv, "n:w:g:s:h")) != -1) {
+        switch (c) {
+            case 'n': nxyz = std::atoi( optarg ); break;
+            case 'w': num_wells = std::atoi( optarg ); break;
+            case 'g': num_groups = std::atoi( optarg ); break;
+            case 's': num_steps = std::atoi( optarg ); break;
+            case 'h':
+                printHelp();
+                return 0;
+            default:
+                printHelp();
+                return 1;
+        }
+    }
+
+    ParseContext parse_context;
+    Parser parser;
+    Deck deck( parser.parseString( createDeck( nxyz, num_wells, num_groups, num_steps ), parse_context ));
+    EclipseState es( deck, parse_context );
+    const auto& grid = es.getInputGrid();
+    Schedule schedule( deck, grid, es.get3DProperties(), es.runspec().phases(), parse_context );
+    SummaryConfig config( deck, schedule, es.getTableManager(), parse_context );
+
+    const auto wells = createWells( schedule, grid );
+    const auto solution = createSolution( grid );
+
+    using clock = std::chrono::steady_clock;
+    const auto setup_start = clock::now();
+    out::Summary summary( es, config, grid, schedule, "SUMMARY_BENCHMARK" );
+    const std::chrono::duration< double > setup_time = clock::now() - setup_start;
+
+    std::chrono::duration< double > eval_time( 0 );
+    std::chrono::duration< double > write_time( 0 );
+    for (int step = 1; step <= num_steps; step++) {
+        const auto eval_start = clock::now();
+        summary.add_timestep( step, step * 86400.0, es, schedule, wells, solution, {} );
+        const auto write_start = clock::now();
+        summary.write();
+        const auto write_end = clock::now();
+
+        eval_time += write_start - eval_start;
+        write_time += write_end - write_start;
+    }
+
+    std::cout << "Cells: " << grid.getNumActive()
+              << " wells: " << num_wells
+              << " groups: " << num_groups
+              << " report steps: " << num_steps << std::endl;
+    std::cout << "Summary setup:          " << setup_time.count() << " s" << std::endl;
+    std::cout << "add_timestep() per step: " << 1e3 * eval_time.count() / num_steps << " ms" << std::endl;
+    std::cout << "write() per step:        " << 1e3 * write_time.count() / num_steps << " ms" << std::endl;
+
+    return 0;
+}
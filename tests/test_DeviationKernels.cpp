@@ -0,0 +1,200 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE DeviationKernelsTest
+
+#include <boost/test/unit_test.hpp>
+#include <opm/test_util/DeviationKernels.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+    std::vector<double> values(size_t size, double scale, double shift) {
+        std::vector<double> vec(size);
+        for (size_t i = 0; i < size; i++)
+            vec[i] = scale * std::sin(0.1 * i) + shift;
+        return vec;
+    }
+
+    double exactMedian(std::vector<double> vec) {
+        const size_t n = vec.size() / 2;
+        std::sort(vec.begin(), vec.end());
+        if (vec.size() % 2 == 0)
+            return 0.5 * (vec[n - 1] + vec[n]);
+        return vec[n];
+    }
+
+}
+
+
+
+BOOST_AUTO_TEST_CASE(cellDeviations) {
+    const std::vector<double> v1 = {1, 0, 0, 2, -1, 4};
+    const std::vector<double> v2 = {3, 0, 5, 2,  1, 4.5};
+
+    const auto stats = DeviationKernels::cellDeviations(v1.data(), v2.data(), v1.size(), 0.1, 0.1, true);
+
+    // Cell 1 has no deviations, cell 2 only an absolute deviation.
+    BOOST_CHECK_EQUAL(stats.numAbs, 5U);
+    BOOST_CHECK_EQUAL(stats.numRel, 4U);
+    BOOST_CHECK_EQUAL(stats.maxAbs, 5.0);
+    BOOST_CHECK_CLOSE(stats.maxRel, 2.0/3, 1e-12);
+    BOOST_CHECK_CLOSE(stats.sumAbs, 2 + 5 + 0 + 0 + 0.5, 1e-12);
+    BOOST_CHECK_CLOSE(stats.sumRel, 2.0/3 + 0 + 0 + 0.5/4.5, 1e-12);
+
+    // Cell 2 violates the absolute tolerance, but has no relative deviation.
+    BOOST_CHECK_EQUAL(stats.numErrors, 2U);
+    BOOST_CHECK_EQUAL(stats.firstError, 0U);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(cellDeviationsNegative) {
+    const std::vector<float> v1 = {1, -0.05f, -2, 1};
+    const std::vector<float> v2 = {1,  0,     -2, 1};
+
+    auto stats = DeviationKernels::cellDeviations(v1.data(), v2.data(), v1.size(), 0.1, 0.1, false);
+    BOOST_CHECK_EQUAL(stats.numErrors, 1U);
+    BOOST_CHECK_EQUAL(stats.firstError, 2U);
+    // The negative values are treated as zero.
+    BOOST_CHECK_EQUAL(stats.numAbs, 2U);
+    BOOST_CHECK_EQUAL(stats.maxAbs, 0.0);
+
+    stats = DeviationKernels::cellDeviations(v1.data(), v2.data(), v1.size(), 0.1, 0.1, true);
+    BOOST_CHECK_EQUAL(stats.numErrors, 0U);
+    BOOST_CHECK_EQUAL(stats.firstError, DeviationStats::npos);
+    BOOST_CHECK_EQUAL(stats.numAbs, 4U);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(cellDeviationsBlocks) {
+    const size_t size = 3 * DeviationKernels::block_size + 17;
+    const auto v1 = values(size, 1, 2);
+    const auto v2 = values(size, 1.01, 2);
+
+    const auto stats = DeviationKernels::cellDeviations(v1.data(), v2.data(), size, 0.005, 0.003, true);
+
+    DeviationStats merged;
+    for (size_t first = 0; first < size; first += 100) {
+        const size_t n = std::min<size_t>(100, size - first);
+        merged.merge(DeviationKernels::cellDeviations(v1.data() + first, v2.data() + first, n, 0.005, 0.003, true), first);
+    }
+
+    size_t numErrors = 0;
+    size_t firstError = DeviationStats::npos;
+    double sumAbs = 0;
+    for (size_t i = 0; i < size; i++) {
+        const double d = std::abs(v1[i] - v2[i]);
+        const double rel = d / std::max(v1[i], v2[i]);
+        sumAbs += d;
+        if (d > 0.005 && rel > 0.003) {
+            if (numErrors == 0)
+                firstError = i;
+            numErrors++;
+        }
+    }
+
+    BOOST_CHECK(numErrors > 0);
+    BOOST_CHECK_EQUAL(stats.numErrors, numErrors);
+    BOOST_CHECK_EQUAL(stats.firstError, firstError);
+    BOOST_CHECK_CLOSE(stats.sumAbs, sumAbs, 1e-10);
+
+    BOOST_CHECK_EQUAL(merged.numErrors, numErrors);
+    BOOST_CHECK_EQUAL(merged.firstError, firstError);
+    BOOST_CHECK_EQUAL(merged.maxAbs, stats.maxAbs);
+    BOOST_CHECK_EQUAL(merged.maxRel, stats.maxRel);
+    BOOST_CHECK_CLOSE(merged.sumAbs, stats.sumAbs, 1e-10);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(summaryDeviations) {
+    const std::vector<double> v1 = {0, 1, 2, 3, -4, 0};
+    const std::vector<double> v2 = {0, 1, 2, 3.5, 4, 1};
+
+    const auto stats = DeviationKernels::summaryDeviations(v1.data(), v2.data(), v1.size(), 0.1, 0.1);
+
+    // Both zero gives zero relative deviation.
+    BOOST_CHECK_EQUAL(stats.numAbs, 6U);
+    BOOST_CHECK_EQUAL(stats.numRel, 6U);
+    BOOST_CHECK_EQUAL(stats.maxAbs, 8.0);
+    BOOST_CHECK_EQUAL(stats.maxRel, 2.0);
+    BOOST_CHECK_CLOSE(stats.sumAbs, 0.5 + 8 + 1, 1e-12);
+    BOOST_CHECK_EQUAL(stats.numErrors, 3U);
+    BOOST_CHECK_EQUAL(stats.firstError, 3U);
+
+    const auto none = DeviationKernels::summaryDeviations(v1.data(), v1.data(), v1.size(), 0.1, 0.1);
+    BOOST_CHECK_EQUAL(none.numErrors, 0U);
+    BOOST_CHECK_EQUAL(none.firstError, DeviationStats::npos);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(histogramMedian) {
+    DeviationHistogram histogram;
+    BOOST_CHECK_EQUAL(histogram.median(), 0.0);
+
+    histogram.add(0);
+    histogram.add(0);
+    histogram.add(5);
+    histogram.add(-1);
+    BOOST_CHECK_EQUAL(histogram.count(), 3U);
+    BOOST_CHECK_EQUAL(histogram.median(), 0.0);
+
+    const auto vec = values(1001, 1e-3, 2e-3);
+    histogram.clear();
+    for (double v : vec)
+        histogram.add(v);
+    BOOST_CHECK_CLOSE(histogram.median(), exactMedian(vec), 1.0);
+
+    // Even number of values, one of them in the overflow bin.
+    auto even = vec;
+    even.push_back(1e30);
+    histogram.add(1e30);
+    BOOST_CHECK_CLOSE(histogram.median(), exactMedian(even), 1.0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(histogramMerge) {
+    const auto vec = values(2000, 10, 11);
+
+    DeviationHistogram all, first, second;
+    for (size_t i = 0; i < vec.size(); i++) {
+        all.add(vec[i]);
+        if (i < 700)
+            first.add(vec[i]);
+        else
+            second.add(vec[i]);
+    }
+    first.merge(second);
+
+    BOOST_CHECK_EQUAL(first.count(), all.count());
+    BOOST_CHECK_EQUAL(first.median(), all.median());
+    BOOST_CHECK_CLOSE(all.median(), exactMedian(vec), 1.0);
+}
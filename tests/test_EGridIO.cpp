@@ -0,0 +1,135 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE EGridIO
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+
+#include <opm/parser/eclipse/EclipseState/Grid/EclipseGrid.hpp>
+#include <opm/parser/eclipse/EclipseState/Grid/NNC.hpp>
+
+#include <opm/output/eclipse/EGridIO.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
+
+#include <ert/ecl/ecl_endian_flip.h>
+#include <ert/ecl/ecl_file.h>
+#include <ert/ecl/ecl_kw.h>
+#include <ert/ecl/ecl_kw_magic.h>
+#include <ert/ecl/fortio.h>
+#include <ert/util/TestArea.hpp>
+
+using namespace Opm;
+
+namespace {
+
+void write( const std::string& filename, const NNC& nnc ) {
+    auto* fortio = fortio_open_writer( filename.c_str(), false, ECL_ENDIAN_FLIP );
+    EGridIO::writeNNC( fortio, nnc );
+    fortio_fclose( fortio );
+}
+
+}
+
+
+BOOST_AUTO_TEST_CASE(NNCKeywords) {
+    ERT::TestArea ta("test_EGridIO");
+
+    /* more than two data blocks in NNC1 and NNC2 */
+    NNC nnc;
+    const size_t num_nnc = 2345;
+    for (size_t i = 0; i < num_nnc; i++)
+        nnc.addNNC( 7 * i, 3 * i + 1, 0.5 * i );
+
+    write( "NNC.EGRID", nnc );
+    out::MappedEclFile file( "NNC.EGRID" );
+    BOOST_CHECK( !file.truncated() );
+    BOOST_REQUIRE_EQUAL( file.keywords().size() , 3U );
+
+    const auto* head = file.find( -1, "NNCHEAD" );
+    BOOST_REQUIRE( head );
+    BOOST_CHECK_EQUAL( head->type , "INTE" );
+    const auto nnchead = file.read_int( *head );
+    BOOST_CHECK_EQUAL( nnchead.size() , 10U );
+    BOOST_CHECK_EQUAL( nnchead[0] , int( num_nnc ) );
+    BOOST_CHECK_EQUAL( nnchead[1] , 0 );
+
+    const auto* kw1 = file.find( -1, "NNC1" );
+    const auto* kw2 = file.find( -1, "NNC2" );
+    BOOST_REQUIRE( kw1 && kw2 );
+    BOOST_CHECK_EQUAL( kw1->count , num_nnc );
+    BOOST_CHECK_EQUAL( kw2->count , num_nnc );
+    BOOST_CHECK( kw1->offset < kw2->offset );
+
+    /* the cell indices are one based, in the order of the NNC container */
+    const auto nnc1 = file.read_int( *kw1 );
+    const auto nnc2 = file.read_int( *kw2 );
+    for (size_t i = 0; i < num_nnc; i++) {
+        BOOST_CHECK_EQUAL( nnc1[i] , int( 7 * i + 1 ));
+        BOOST_CHECK_EQUAL( nnc2[i] , int( 3 * i + 2 ));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(NoNNC) {
+    ERT::TestArea ta("test_EGridIO_empty");
+
+    write( "EMPTY.EGRID", NNC() );
+    BOOST_CHECK( !out::MappedEclFile::unformatted( "EMPTY.EGRID" ) );
+}
+
+
+/*
+  ERT writes an empty NNC section after the grid; save() must replace
+  it, in both formatted and unformatted files, so that there is exactly
+  one NNCHEAD, NNC1 and NNC2 keyword.
+*/
+BOOST_AUTO_TEST_CASE(SaveGrid) {
+    ERT::TestArea ta("test_EGridIO_save");
+
+    const EclipseGrid grid( 4, 3, 2 );
+    NNC nnc;
+    nnc.addNNC( 0, 23, 1.0 );
+    nnc.addNNC( 5, 17, 2.0 );
+
+    for (const bool formatted : { false, true }) {
+        const std::string filename = formatted ? "CASE.FEGRID" : "CASE.EGRID";
+        EGridIO::save( filename, grid, nnc, ECL_METRIC_UNITS, formatted );
+
+        ecl_file_type* file = ecl_file_open( filename.c_str(), 0 );
+        BOOST_REQUIRE( file );
+        BOOST_CHECK_EQUAL( ecl_file_get_num_named_kw( file, NNCHEAD_KW ) , 1 );
+        BOOST_CHECK_EQUAL( ecl_file_get_num_named_kw( file, NNC1_KW ) , 1 );
+        BOOST_CHECK_EQUAL( ecl_file_get_num_named_kw( file, NNC2_KW ) , 1 );
+
+        const auto* nnc1 = ecl_file_iget_named_kw( file, NNC1_KW, 0 );
+        const auto* nnc2 = ecl_file_iget_named_kw( file, NNC2_KW, 0 );
+        BOOST_CHECK_EQUAL( ecl_kw_get_size( nnc1 ) , 2 );
+        BOOST_CHECK_EQUAL( ecl_kw_iget_int( nnc1, 1 ) , 6 );
+        BOOST_CHECK_EQUAL( ecl_kw_iget_int( nnc2, 1 ) , 18 );
+        ecl_file_close( file );
+    }
+}
@@ -25,8 +25,94 @@
 #define BOOST_TEST_MODULE EclFilesComparatorTest
 
 #include <boost/test/unit_test.hpp>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
 #include <opm/test_util/EclFilesComparator.hpp>
 
+#include <ert/ecl/EclKW.hpp>
+#include <ert/ecl/ecl_endian_flip.h>
+#include <ert/ecl/ecl_grid.h>
+#include <ert/ecl/ecl_kw.h>
+#include <ert/ecl/ecl_util.h>
+#include <ert/ecl/fortio.h>
+#include <ert/util/TestArea.hpp>
+
+namespace {
+
+    const int nx = 50, ny = 50, nz = 30;
+    const size_t num_cells = nx * ny * nz;
+    const int num_steps = 4;
+
+    // The cells which deviate by one percent in the second case; all the other cells deviate by a tiny amount.
+    bool deviating(size_t cell, int step) {
+        return cell % 997 == size_t(step);
+    }
+
+    // The cells with a negative PRESSURE in the first case.
+    bool negative(size_t cell, int step) {
+        return cell % 5003 == size_t(step);
+    }
+
+    float rsValue(size_t cell) {
+        return float(cell % 11) - 5.0f;
+    }
+
+    // A unified restart file with PRESSURE and RS for num_steps report steps; RS has negative values in both cases. There
+    // are no SEQNUM and INTEHEAD keywords, so the comparator does not find any wells.
+    void writeCase(const std::string& basename, bool second) {
+        ecl_grid_type* grid = ecl_grid_alloc_rectangular(nx, ny, nz, 1.0, 1.0, 1.0, nullptr);
+        ecl_grid_fwrite_EGRID2(grid, (basename + ".EGRID").c_str(), ECL_METRIC_UNITS);
+        ecl_grid_free(grid);
+
+        fortio_type* fortio = fortio_open_writer((basename + ".UNRST").c_str(), false, ECL_ENDIAN_FLIP);
+        for (int step = 0; step < num_steps; step++) {
+            std::vector<float> pressure(num_cells), rs(num_cells);
+            for (size_t cell = 0; cell < num_cells; cell++) {
+                pressure[cell] = 100.0f + step + cell % 7;
+                rs[cell] = rsValue(cell);
+                if (second) {
+                    const float factor = deviating(cell, step) ? 1.01f : 1.0f + 1e-6f;
+                    pressure[cell] *= factor;
+                    rs[cell] *= factor;
+                }
+                else if (negative(cell, step))
+                    pressure[cell] = -1.0f;
+            }
+
+            ecl_kw_fwrite(ERT::EclKW<float>("PRESSURE", pressure).get(), fortio);
+            ecl_kw_fwrite(ERT::EclKW<float>("RS", rs).get(), fortio);
+        }
+        fortio_fclose(fortio);
+    }
+
+    /*
+      Compare one keyword with throwOnErrors(false); returns the number
+      of errors, and the printed output with the average and median
+      deviations and the reported violations in output.
+    */
+    size_t compareKeyword(const std::string& keyword, bool mapped, std::string& output) {
+        RegressionTest comparator(ECL_UNIFIED_RESTART_FILE, "FIRST", "SECOND", 1e-3, 1e-4);
+        comparator.throwOnErrors(false);
+        if (!mapped)
+            comparator.disableMappedFiles();
+
+        std::ostringstream out;
+        auto* cout_buf = std::cout.rdbuf(out.rdbuf());
+        auto* cerr_buf = std::cerr.rdbuf(out.rdbuf());
+        comparator.resultsForKeyword(keyword);
+        std::cout.rdbuf(cout_buf);
+        std::cerr.rdbuf(cerr_buf);
+
+        output = out.str();
+        return comparator.getNoErrors();
+    }
+
+}
+
 BOOST_AUTO_TEST_CASE(deviation) {
     double a = 1;
     double b = 3;
@@ -70,3 +156,39 @@ BOOST_AUTO_TEST_CASE(average) {
 
     BOOST_CHECK_CLOSE(avg, 13.0/4, tol);
 }
+
+
+
+BOOST_AUTO_TEST_CASE(mappedMatchesERT) {
+    ERT::TestArea ta("test_EclFilesComparator");
+    writeCase("FIRST", false);
+    writeCase("SECOND", true);
+
+    for (const std::string keyword : { "PRESSURE", "RS" }) {
+        std::string mapped, serial;
+        const auto mappedErrors = compareKeyword(keyword, true, mapped);
+        const auto serialErrors = compareKeyword(keyword, false, serial);
+
+        BOOST_CHECK_EQUAL(mappedErrors, serialErrors);
+        BOOST_CHECK_EQUAL(mapped, serial);
+        BOOST_CHECK(mapped.find("Average absolute deviation") != std::string::npos);
+        BOOST_CHECK(mapped.find("Median relative deviation") != std::string::npos);
+    }
+
+    /*
+      A negative PRESSURE is reported and then treated as zero, which
+      only has an absolute deviation; an RS of zero has no deviation.
+    */
+    size_t pressureErrors = 0, rsErrors = 0;
+    for (int step = 0; step < num_steps; step++) {
+        for (size_t cell = 0; cell < num_cells; cell++) {
+            pressureErrors += negative(cell, step) || deviating(cell, step);
+            rsErrors += deviating(cell, step) && rsValue(cell) != 0;
+        }
+    }
+
+    std::string output;
+    BOOST_CHECK_EQUAL(compareKeyword("RS", true, output), rsErrors);
+    BOOST_CHECK_EQUAL(compareKeyword("PRESSURE", true, output), pressureErrors);
+    BOOST_CHECK(output.find("Negative value in first file") != std::string::npos);
+}
@@ -293,7 +293,7 @@ BOOST_AUTO_TEST_CASE(EclipseIOIntegration) {
 
     ERT::TestArea ta("test_ecl_writer");
 
-    auto write_and_check = [&]( int first = 1, int last = 5 ) {
+    auto write_and_check = [&]( int first = 1, int last = 5, bool async = false ) {
         ParseContext parse_context;
         auto deck = Parser().parseString( deckString, parse_context );
         auto es = Parser::parse( deck );
@@ -327,6 +327,8 @@ BOOST_AUTO_TEST_CASE(EclipseIOIntegration) {
 
         int_data.erase("STR_ULONGNAME");
         eclWriter.writeInitial( eGridProps , int_data );
+        if (async)
+            eclWriter.enableAsyncOutput( 2 );
 
         data::Wells wells;
 
@@ -345,6 +347,8 @@ BOOST_AUTO_TEST_CASE(EclipseIOIntegration) {
 				     {});
 				     
 
+            if (async)
+                eclWriter.flush();
 
             checkRestartFile( i );
         }
@@ -398,6 +402,12 @@ BOOST_AUTO_TEST_CASE(EclipseIOIntegration) {
      * the file
      */
     BOOST_CHECK_EQUAL( file_size, write_and_check( 3, 5 ) );
+
+    /*
+     * the asynchronous writer should produce exactly the same restart
+     * file as the synchronous one.
+     */
+    BOOST_CHECK_EQUAL( file_size, write_and_check( 1, 5, true ) );
 }
 
 BOOST_AUTO_TEST_CASE(OPM_XWEL) {
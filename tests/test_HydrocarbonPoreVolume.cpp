@@ -0,0 +1,104 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE HydrocarbonPoreVolume
+#include <boost/test/unit_test.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include <opm/output/data/Solution.hpp>
+#include <opm/output/eclipse/HydrocarbonPoreVolume.hpp>
+#include <opm/parser/eclipse/Units/UnitSystem.hpp>
+
+using namespace Opm;
+
+
+BOOST_AUTO_TEST_CASE(NoSwat) {
+    const std::vector< double > pv = { 1.0, 2.0, 3.0, 4.0, 5.0 };
+    const std::vector< double > p = { 10.0, 20.0, 30.0, 40.0, 50.0 };
+
+    data::Solution solution;
+    out::HydrocarbonPoreVolume hcpv;
+    hcpv.update( pv, solution );
+    BOOST_CHECK( !hcpv.hasPressure() );
+    BOOST_CHECK_EQUAL( hcpv.pressure() , 0.0 );
+    BOOST_CHECK_EQUAL( hcpv.total() , 15.0 );
+
+    /* without SWAT the weights are the pore volumes themselves */
+    BOOST_CHECK( hcpv.weights() == pv.data() );
+    BOOST_CHECK_EQUAL( hcpv.size() , pv.size() );
+
+    solution.insert( "PRESSURE", UnitSystem::measure::pressure, p, data::TargetType::RESTART_SOLUTION );
+    hcpv.update( pv, solution );
+    BOOST_CHECK( hcpv.hasPressure() );
+    BOOST_CHECK_CLOSE( hcpv.pressure() , 550.0 / 15.0 , 1e-12 );
+}
+
+
+BOOST_AUTO_TEST_CASE(WithSwat) {
+    const std::size_t num_cells = 1000003;
+    std::vector< double > pv( num_cells ), p( num_cells ), swat( num_cells );
+    for (size_t i = 0; i < num_cells; i++) {
+        pv[i] = 1.0 + 0.25 * (i % 11);
+        p[i] = 200.0 + 0.001 * i;
+        swat[i] = 0.05 * (i % 17);
+    }
+
+    data::Solution solution;
+    solution.insert( "PRESSURE", UnitSystem::measure::pressure, p, data::TargetType::RESTART_SOLUTION );
+    solution.insert( "SWAT", UnitSystem::measure::identity, swat, data::TargetType::RESTART_SOLUTION );
+
+    out::HydrocarbonPoreVolume hcpv;
+    hcpv.update( pv, solution );
+    const double* first = hcpv.weights();
+    BOOST_CHECK( first != pv.data() );
+
+    double weighted = 0, total = 0;
+    for (size_t i = 0; i < num_cells; i++) {
+        const double w = pv[i] * (1.0 - swat[i]);
+        BOOST_CHECK_EQUAL( hcpv.weights()[i] , w );
+        weighted += w * p[i];
+        total += w;
+    }
+
+    BOOST_CHECK_CLOSE( hcpv.total() , total , 1e-10 );
+    BOOST_CHECK_CLOSE( hcpv.pressure() , weighted / total , 1e-10 );
+
+    /* the second update reuses the buffer, and gives the same sums */
+    const double pressure = hcpv.pressure();
+    hcpv.update( pv, solution );
+    BOOST_CHECK( hcpv.weights() == first );
+    BOOST_CHECK_EQUAL( hcpv.pressure() , pressure );
+}
+
+
+BOOST_AUTO_TEST_CASE(WrongSize) {
+    const std::vector< double > pv( 10, 1.0 );
+    data::Solution solution;
+    solution.insert( "SWAT", UnitSystem::measure::identity, std::vector< double >( 9 ), data::TargetType::RESTART_SOLUTION );
+
+    out::HydrocarbonPoreVolume hcpv;
+    BOOST_CHECK_THROW( hcpv.update( pv, solution ), std::runtime_error );
+}
@@ -0,0 +1,407 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE MappedEclFile
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <opm/output/eclipse/MappedEclFile.hpp>
+
+using namespace Opm;
+
+namespace {
+
+/*
+  Minimal writer for big endian unformatted ECLIPSE keywords, to
+  create test files without going through ERT.
+*/
+class Writer {
+public:
+    explicit Writer( const std::string& filename, bool append = false ) :
+        stream( filename, append ? std::ios::binary | std::ios::app : std::ios::binary )
+    {}
+
+    void inte( const std::string& name, const std::vector<int>& values ) {
+        this->header( name, values.size(), "INTE" );
+        this->blocks( values, 1000, [this]( int v ) { this->be32( v ); } );
+    }
+
+    void real( const std::string& name, const std::vector<float>& values ) {
+        this->header( name, values.size(), "REAL" );
+        this->blocks( values, 1000, [this]( float v ) {
+                std::uint32_t bits;
+                std::memcpy( &bits, &v, sizeof bits );
+                this->be32( bits );
+            });
+    }
+
+    void doub( const std::string& name, const std::vector<double>& values ) {
+        this->header( name, values.size(), "DOUB" );
+        this->blocks( values, 1000, [this]( double v ) {
+                std::uint64_t bits;
+                std::memcpy( &bits, &v, sizeof bits );
+                this->be32( bits >> 32 );
+                this->be32( bits & 0xFFFFFFFF );
+            });
+    }
+
+    void chars( const std::string& name, const std::vector<std::string>& values ) {
+        this->header( name, values.size(), "CHAR" );
+        this->blocks( values, 105, [this]( const std::string& v ) {
+                std::string padded = v + std::string( 8 - v.size(), ' ' );
+                this->stream.write( padded.data(), 8 );
+            });
+    }
+
+    void mess( const std::string& name ) {
+        this->header( name, 0, "MESS" );
+    }
+
+private:
+    void be32( std::uint32_t v ) {
+        const char bytes[4] = { char( v >> 24 ), char( v >> 16 ), char( v >> 8 ), char( v ) };
+        this->stream.write( bytes, 4 );
+    }
+
+    void header( const std::string& name, std::size_t count, const std::string& type ) {
+        const auto padded = name + std::string( 8 - name.size(), ' ' );
+        this->be32( 16 );
+        this->stream.write( padded.data(), 8 );
+        this->be32( count );
+        this->stream.write( type.data(), 4 );
+        this->be32( 16 );
+    }
+
+    template <typename T, typename F>
+    void blocks( const std::vector<T>& values, std::size_t block_size, F f ) {
+        const std::size_t element_size = sizeof( T ) == 8 || std::is_same<T, std::string>::value ? 8 : 4;
+        for (std::size_t begin = 0; begin < values.size(); begin += block_size) {
+            const auto end = std::min( values.size(), begin + block_size );
+            this->be32( (end - begin) * element_size );
+            for (auto i = begin; i < end; i++)
+                f( values[i] );
+            this->be32( (end - begin) * element_size );
+        }
+    }
+
+    std::ofstream stream;
+};
+
+
+std::vector<double> sequence( std::size_t size, double offset ) {
+    std::vector<double> values( size );
+    for (std::size_t i = 0; i < size; i++)
+        values[i] = offset + 0.25 * i;
+
+    return values;
+}
+
+}
+
+
+BOOST_AUTO_TEST_CASE(ReadUnified) {
+    const std::string filename = "MAPPED_TEST.UNRST";
+    {
+        Writer writer( filename );
+        for (int step = 0; step < 3; step++) {
+            writer.inte( "SEQNUM", { step * 5 } );
+            writer.inte( "INTEHEAD", std::vector<int>( 2500, step ) );
+            writer.chars( "ZWEL", { "OP_1", "OP_2" } );
+            writer.mess( "STARTSOL" );
+            writer.doub( "PRESSURE", sequence( 2001, step ) );
+            writer.real( "SWAT", std::vector<float>( 1500, 0.5f * step ) );
+            writer.mess( "ENDSOL" );
+        }
+    }
+
+    BOOST_CHECK( out::MappedEclFile::unformatted( filename ));
+    BOOST_CHECK( !out::MappedEclFile::unformatted( "NO_SUCH_FILE.UNRST" ));
+
+    out::MappedEclFile file( filename );
+    BOOST_CHECK( file.hasReportStep( 5 ));
+    BOOST_CHECK( !file.hasReportStep( 7 ));
+    BOOST_CHECK( !file.find( 5, "NO_SUCH_KW" ));
+    BOOST_CHECK( !file.find( -1, "PRESSURE" ));
+
+    const auto* pressure = file.find( 5, "PRESSURE" );
+    BOOST_REQUIRE( pressure );
+    BOOST_CHECK_EQUAL( pressure->count , 2001U );
+    BOOST_CHECK_EQUAL( pressure->type , "DOUB" );
+    BOOST_CHECK_EQUAL( pressure->report_step , 5 );
+
+    std::vector<double> buffer( pressure->count );
+    file.read( *pressure, buffer.data() );
+    const auto expected = sequence( 2001, 1 );
+    BOOST_CHECK_EQUAL_COLLECTIONS( buffer.begin(), buffer.end(), expected.begin(), expected.end() );
+
+    const auto swat = file.read_double( *file.find( 10, "SWAT" ));
+    BOOST_CHECK_EQUAL( swat.size() , 1500U );
+    BOOST_CHECK_EQUAL( swat[1499] , 1.0 );
+
+    const auto intehead = file.read_int( *file.find( 0, "INTEHEAD" ));
+    BOOST_CHECK_EQUAL( intehead.size() , 2500U );
+    BOOST_CHECK_EQUAL( intehead[2499] , 0 );
+
+    BOOST_CHECK_THROW( file.read_int( *pressure ), std::invalid_argument );
+    BOOST_CHECK_THROW( file.read_double( *file.find( 0, "ZWEL" )), std::invalid_argument );
+
+    const auto& keywords = file.keywords();
+    BOOST_CHECK_EQUAL( keywords.size() , 21U );
+    BOOST_CHECK_EQUAL( keywords.back().name , "ENDSOL" );
+    BOOST_CHECK_EQUAL( keywords.back().report_step , 10 );
+    BOOST_CHECK_EQUAL( keywords.back().offset + 24 , file.size() );
+
+    std::remove( filename.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(ReadNonUnified) {
+    const std::string filename = "MAPPED_TEST.X0003";
+    {
+        Writer writer( filename );
+        writer.inte( "INTEHEAD", { 1, 2, 3 } );
+        writer.doub( "OPM_XWEL", { 1.5, 2.5 } );
+    }
+
+    out::MappedEclFile file( filename );
+    BOOST_CHECK( file.hasReportStep( -1 ));
+    const auto xwel = file.read_double( *file.find( -1, "OPM_XWEL" ));
+    BOOST_CHECK_EQUAL( xwel[1] , 2.5 );
+
+    std::vector<float> narrow( 2 );
+    file.read( *file.find( -1, "OPM_XWEL" ), narrow.data() );
+    BOOST_CHECK_EQUAL( narrow[0] , 1.5f );
+
+    std::remove( filename.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(Truncated) {
+    const std::string filename = "MAPPED_TEST_TRUNCATED.UNRST";
+    {
+        Writer writer( filename );
+        writer.inte( "SEQNUM", { 1 } );
+        writer.doub( "PRESSURE", sequence( 100, 0 ) );
+    }
+    {
+        std::ofstream stream( filename, std::ios::binary | std::ios::app );
+        stream.write( "\0\0\0\x10SWAT    ", 12 );
+    }
+
+    out::MappedEclFile file( filename );
+    BOOST_CHECK( file.find( 1, "PRESSURE" ));
+    BOOST_CHECK_EQUAL( file.keywords().size() , 2U );
+    BOOST_CHECK( file.truncated() );
+
+    {
+        std::ofstream stream( filename, std::ios::binary );
+        stream << "'SEQNUM  '           1 'INTE'";
+    }
+    BOOST_CHECK( !out::MappedEclFile::unformatted( filename ));
+    BOOST_CHECK_THROW( out::MappedEclFile( filename ).keywords(), std::runtime_error );
+    std::remove( filename.c_str() );
+}
+
+
+namespace {
+
+void write_step( const std::string& filename, int step, std::size_t num_cells, bool append ) {
+    Writer writer( filename, append );
+    writer.inte( "SEQNUM", { step } );
+    writer.inte( "INTEHEAD", std::vector<int>( 95, step ) );
+    writer.mess( "STARTSOL" );
+    writer.doub( "PRESSURE", sequence( num_cells, step ) );
+    writer.mess( "ENDSOL" );
+}
+
+std::size_t file_size( const std::string& filename ) {
+    std::ifstream stream( filename, std::ios::binary | std::ios::ate );
+    return stream.tellg();
+}
+
+}
+
+
+BOOST_AUTO_TEST_CASE(SidecarIndex) {
+    const std::string filename = "MAPPED_TEST_SIDECAR.UNRST";
+    const auto index_file = out::MappedEclFile::index_file( filename );
+    std::remove( index_file.c_str() );
+
+    write_step( filename, 1, 1500, false );
+    write_step( filename, 2, 1500, true );
+    out::MappedEclFile::updateIndex( filename );
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 10 * 32 );
+
+    write_step( filename, 3, 1500, true );
+    out::MappedEclFile::updateIndex( filename, 3 );
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 15 * 32 );
+
+    {
+        /*
+          Destroy the first keyword header; a scan of the file would
+          fail, but with the sidecar index the headers are not read.
+        */
+        std::fstream stream( filename, std::ios::binary | std::ios::in | std::ios::out );
+        stream.write( "XXXX", 4 );
+    }
+    {
+        out::MappedEclFile file( filename );
+        const auto* pressure = file.find( 2, "PRESSURE" );
+        BOOST_REQUIRE( pressure );
+        BOOST_CHECK_EQUAL( pressure->count , 1500U );
+        BOOST_CHECK_EQUAL( file.read_double( *pressure )[1] , 2.25 );
+        BOOST_CHECK_EQUAL( file.keywords().size() , 15U );
+        BOOST_CHECK( !file.truncated() );
+    }
+
+    /* Rewrite report step 3 with a different layout. */
+    write_step( filename, 1, 1500, false );
+    write_step( filename, 2, 1500, true );
+    write_step( filename, 3, 2500, true );
+    out::MappedEclFile::updateIndex( filename, 3 );
+    {
+        out::MappedEclFile file( filename );
+        BOOST_CHECK_EQUAL( file.find( 3, "PRESSURE" )->count , 2500U );
+        BOOST_CHECK_EQUAL( file.keywords().size() , 15U );
+        BOOST_CHECK_EQUAL( file.keywords().back().offset + 24 , file.size() );
+    }
+
+    /* A stale sidecar; the data file has been rewritten without update. */
+    write_step( filename, 1, 1500, false );
+    write_step( filename, 2, 500, true );
+    {
+        out::MappedEclFile file( filename );
+        BOOST_CHECK( !file.hasReportStep( 3 ));
+        BOOST_CHECK_EQUAL( file.find( 2, "PRESSURE" )->count , 500U );
+        BOOST_CHECK_EQUAL( file.keywords().size() , 10U );
+        BOOST_CHECK_EQUAL( file.keywords().back().offset + 24 , file.size() );
+    }
+
+    std::remove( filename.c_str() );
+    std::remove( index_file.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(SidecarIndexWriter) {
+    const std::string filename = "MAPPED_TEST_WRITER.UNRST";
+    const auto index_file = out::MappedEclFile::index_file( filename );
+    std::remove( index_file.c_str() );
+
+    const auto sidecar_name = [&index_file]( std::size_t entry ) {
+        std::ifstream stream( index_file, std::ios::binary );
+        stream.seekg( 8 + entry * 32 + 4 );
+        char name[ 8 ];
+        stream.read( name, 8 );
+        return std::string( name, 8 );
+    };
+
+    write_step( filename, 1, 1500, false );
+    out::MappedEclFile::IndexWriter writer( filename );
+    writer.update();
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 5 * 32 );
+
+    write_step( filename, 2, 1500, true );
+    writer.update( 2 );
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 10 * 32 );
+
+    {
+        /*
+          Scribble over the first entry; the writer only appends to the
+          sidecar, so the scribble survives the next update.
+        */
+        std::fstream stream( index_file, std::ios::binary | std::ios::in | std::ios::out );
+        stream.seekp( 8 + 4 );
+        stream.write( "XXXXXXXX", 8 );
+    }
+    write_step( filename, 3, 1500, true );
+    writer.update();
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 15 * 32 );
+    BOOST_CHECK_EQUAL( sidecar_name( 0 ) , "XXXXXXXX" );
+    BOOST_CHECK_EQUAL( sidecar_name( 10 ) , "SEQNUM  " );
+    {
+        std::fstream stream( index_file, std::ios::binary | std::ios::in | std::ios::out );
+        stream.seekp( 8 + 4 );
+        stream.write( "SEQNUM  ", 8 );
+    }
+
+    /* Rewrite report step 3 with a different layout. */
+    write_step( filename, 1, 1500, false );
+    write_step( filename, 2, 1500, true );
+    write_step( filename, 3, 2500, true );
+    writer.update( 3 );
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 15 * 32 );
+    {
+        out::MappedEclFile file( filename );
+        BOOST_CHECK_EQUAL( file.find( 3, "PRESSURE" )->count , 2500U );
+        BOOST_CHECK_EQUAL( file.keywords().size() , 15U );
+        BOOST_CHECK_EQUAL( file.keywords().back().offset + 24 , file.size() );
+    }
+
+    /* The data file shrinks behind the writer's back. */
+    write_step( filename, 1, 1500, false );
+    writer.update();
+    BOOST_CHECK_EQUAL( file_size( index_file ) , 8U + 5 * 32 );
+    {
+        out::MappedEclFile file( filename );
+        BOOST_CHECK_EQUAL( file.keywords().size() , 5U );
+        BOOST_CHECK( !file.hasReportStep( 2 ));
+    }
+
+    std::remove( filename.c_str() );
+    std::remove( index_file.c_str() );
+}
+
+
+BOOST_AUTO_TEST_CASE(SummarySteps) {
+    const std::string filename = "MAPPED_TEST.UNSMRY";
+    {
+        Writer writer( filename );
+        writer.inte( "SEQHDR", { 0 } );
+        writer.inte( "MINISTEP", { 0 } );
+        writer.real( "PARAMS", { 1, 2, 3 } );
+        writer.inte( "MINISTEP", { 1 } );
+        writer.real( "PARAMS", { 4, 5, 6 } );
+        writer.inte( "SEQHDR", { 0 } );
+        writer.inte( "MINISTEP", { 2 } );
+        writer.real( "PARAMS", { 7, 8, 9 } );
+    }
+
+    out::MappedEclFile::updateIndex( filename );
+    out::MappedEclFile file( filename );
+    BOOST_CHECK( !file.hasReportStep( -1 ));
+    BOOST_CHECK( file.hasReportStep( 1 ));
+    BOOST_CHECK_EQUAL( file.read_double( *file.find( 1, "PARAMS" ))[2] , 9.0 );
+    BOOST_CHECK_EQUAL( file.find( 0, "PARAMS" )->count , 3U );
+    BOOST_CHECK_EQUAL( file.keywords().size() , 8U );
+
+    std::remove( filename.c_str() );
+    std::remove( out::MappedEclFile::index_file( filename ).c_str() );
+}
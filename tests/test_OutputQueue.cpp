@@ -0,0 +1,122 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE OutputQueue
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <opm/output/eclipse/OutputQueue.hpp>
+
+using namespace Opm;
+
+
+BOOST_AUTO_TEST_CASE(CreateInvalid) {
+    BOOST_CHECK_THROW( out::OutputQueue( 0 ), std::invalid_argument );
+}
+
+
+BOOST_AUTO_TEST_CASE(TasksRunInOrder) {
+    std::vector<int> result;
+    {
+        out::OutputQueue queue( 2 );
+        for (int i = 0; i < 10; i++)
+            queue.push( [&result, i]() {
+                    std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+                    result.push_back( i );
+                });
+
+        queue.wait();
+        BOOST_CHECK_EQUAL( queue.pending() , 0U );
+        BOOST_CHECK_EQUAL( result.size() , 10U );
+    }
+
+    for (int i = 0; i < 10; i++)
+        BOOST_CHECK_EQUAL( result[i] , i );
+}
+
+
+BOOST_AUTO_TEST_CASE(DestructorWaits) {
+    int count = 0;
+    {
+        out::OutputQueue queue( 1 );
+        for (int i = 0; i < 5; i++)
+            queue.push( [&count]() { count++; });
+    }
+    BOOST_CHECK_EQUAL( count , 5 );
+}
+
+
+BOOST_AUTO_TEST_CASE(ErrorPropagation) {
+    out::OutputQueue queue( 4 );
+    int count = 0;
+
+    /* Hold the writer thread until all the tasks have been queued. */
+    std::promise<void> gate;
+    std::shared_future<void> open = gate.get_future().share();
+
+    queue.push( [&count, open]() { open.wait(); count++; });
+    queue.push( []() { throw std::runtime_error("Disk full"); });
+    queue.push( [&count]() { count++; });
+    gate.set_value();
+
+    BOOST_CHECK_THROW( queue.wait() , std::runtime_error );
+    BOOST_CHECK_EQUAL( count , 1 );
+
+    /* The error is only reported once, and the queue is still usable. */
+    BOOST_CHECK_NO_THROW( queue.wait() );
+    queue.push( [&count]() { count++; });
+    queue.wait();
+    BOOST_CHECK_EQUAL( count , 2 );
+}
+
+
+BOOST_AUTO_TEST_CASE(ErrorFromPush) {
+    out::OutputQueue queue( 1 );
+
+    queue.push( []() { throw std::runtime_error("Disk full"); });
+    while (queue.pending() > 0)
+        std::this_thread::sleep_for( std::chrono::milliseconds( 1 ));
+
+    /* The task passed to the failing push() is not queued. */
+    bool run = false;
+    BOOST_CHECK_THROW( queue.push( [&run]() { run = true; } ) , std::runtime_error );
+    queue.wait();
+    BOOST_CHECK( !run );
+}
+
+
+BOOST_AUTO_TEST_CASE(UnreportedErrorInDestructor) {
+    int count = 0;
+    BOOST_CHECK_NO_THROW( {
+        out::OutputQueue queue( 2 );
+        queue.push( [&count]() { count++; });
+        queue.push( []() { throw std::runtime_error("Disk full"); });
+    });
+    BOOST_CHECK_EQUAL( count , 1 );
+}
@@ -0,0 +1,79 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE Parallel
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <opm/output/eclipse/Parallel.hpp>
+
+using namespace Opm;
+
+
+BOOST_AUTO_TEST_CASE(RunCallsEveryIndex) {
+    for (const std::size_t n : { 0, 1, 2, 7 }) {
+        std::vector< std::atomic< int > > calls( std::max< std::size_t >( n, 1 ));
+        for (auto& c : calls)
+            c = 0;
+
+        out::parallel::run( n, [&]( std::size_t t ) { calls[ t ]++; });
+        for (const auto& c : calls)
+            BOOST_CHECK_EQUAL( c.load() , 1 );
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(WorkersAreReused) {
+    auto& pool = out::parallel::pool::instance();
+    out::parallel::run( 4, []( std::size_t ) {} );
+    const auto workers = pool.size();
+
+    std::atomic< int > sum( 0 );
+    for (int i = 0; i < 100; i++)
+        out::parallel::run( 4, [&]( std::size_t t ) { sum += t; });
+
+    BOOST_CHECK_EQUAL( sum.load() , 100 * (0 + 1 + 2 + 3) );
+    BOOST_CHECK_EQUAL( pool.size() , workers );
+}
+
+
+BOOST_AUTO_TEST_CASE(NestedAndConcurrent) {
+    std::atomic< int > calls( 0 );
+    const auto nested = [&]() {
+        for (int i = 0; i < 20; i++)
+            out::parallel::run( 4, [&]( std::size_t ) {
+                    out::parallel::run( 4, [&]( std::size_t ) { calls++; });
+                });
+    };
+
+    std::thread other( nested );
+    nested();
+    other.join();
+
+    BOOST_CHECK_EQUAL( calls.load() , 2 * 20 * 4 * 4 );
+}
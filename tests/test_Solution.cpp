@@ -99,3 +99,26 @@ BOOST_AUTO_TEST_CASE(UNITS) {
     BOOST_CHECK_EQUAL( si0 , c.data("NAME")[0] );
 }
 
+
+
+BOOST_AUTO_TEST_CASE(Assign) {
+    std::vector<double> data(100,1);
+    data::Solution c;
+    c.insert("PRESSURE", UnitSystem::measure::pressure, data , data::TargetType::RESTART_SOLUTION);
+    c.insert("SWAT", UnitSystem::measure::identity, data , data::TargetType::RESTART_SOLUTION);
+
+    data::Solution copy;
+    copy.assign( c );
+    BOOST_CHECK_EQUAL( 2U , copy.size() );
+    BOOST_CHECK_EQUAL( 1.0 , copy.data("PRESSURE")[0] );
+
+    /* Assigning a solution with the same keywords reuses the buffers. */
+    const auto* buffer = copy.data("PRESSURE").data();
+    c.data("PRESSURE")[0] = 2.0;
+    c.erase("SWAT");
+    copy.assign( c );
+    BOOST_CHECK( buffer == copy.data("PRESSURE").data() );
+    BOOST_CHECK_EQUAL( 2.0 , copy.data("PRESSURE")[0] );
+    BOOST_CHECK( !copy.has("SWAT") );
+    BOOST_CHECK( copy.at("PRESSURE").target == data::TargetType::RESTART_SOLUTION );
+}
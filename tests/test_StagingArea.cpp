@@ -0,0 +1,180 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE StagingArea
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <opm/output/eclipse/StagingArea.hpp>
+#include <opm/output/eclipse/Statistics.hpp>
+
+using namespace Opm;
+
+namespace {
+
+    data::Solution make_solution( double value ) {
+        data::Solution sol;
+        sol.insert( "PRESSURE", UnitSystem::measure::pressure,
+                    std::vector< double >( 100, value ),
+                    data::TargetType::RESTART_SOLUTION );
+        return sol;
+    }
+
+}
+
+
+BOOST_AUTO_TEST_CASE(CreateInvalid) {
+    BOOST_CHECK_THROW( out::StagingArea( 0 ), std::invalid_argument );
+}
+
+
+BOOST_AUTO_TEST_CASE(BuffersAreReused) {
+    out::StagingArea staging( 2 );
+    const std::map< std::string, std::vector< double > > extra = {{ "OPMEXTRA", { 1.0, 2.0 }}};
+
+    const double* pressure;
+    const double* opmextra;
+    {
+        auto step = staging.stage( make_solution( 1.0 ), data::Wells{}, {{ "FPR", 1.0 }}, extra );
+        BOOST_CHECK_EQUAL( staging.in_use() , 1U );
+        BOOST_CHECK_EQUAL( step->cells.data( "PRESSURE" )[ 0 ] , 1.0 );
+        BOOST_CHECK_EQUAL( step->misc_summary_values.at( "FPR" ) , 1.0 );
+        pressure = step->cells.data( "PRESSURE" ).data();
+        opmextra = step->extra_restart.at( "OPMEXTRA" ).data();
+    }
+    BOOST_CHECK_EQUAL( staging.in_use() , 0U );
+
+    auto step = staging.stage( make_solution( 2.0 ), data::Wells{}, {}, extra );
+    BOOST_CHECK( step->cells.data( "PRESSURE" ).data() == pressure );
+    BOOST_CHECK( step->extra_restart.at( "OPMEXTRA" ).data() == opmextra );
+    BOOST_CHECK_EQUAL( step->cells.data( "PRESSURE" )[ 0 ] , 2.0 );
+    BOOST_CHECK( step->misc_summary_values.empty() );
+}
+
+
+BOOST_AUTO_TEST_CASE(StageBlocksWhenFull) {
+    out::StagingArea staging( 2 );
+    const auto sol = make_solution( 1.0 );
+
+    auto first = staging.stage( sol, data::Wells{}, {}, {} );
+    auto second = staging.stage( sol, data::Wells{}, {}, {} );
+    BOOST_CHECK( first.get() != second.get() );
+    BOOST_CHECK_EQUAL( staging.in_use() , 2U );
+
+    auto third = std::async( std::launch::async, [&]() { return staging.stage( sol, data::Wells{}, {}, {} ); });
+    BOOST_CHECK( third.wait_for( std::chrono::milliseconds( 50 )) == std::future_status::timeout );
+
+    const auto* released = first.get();
+    first.reset();
+    BOOST_CHECK( third.get().get() == released );
+}
+
+
+BOOST_AUTO_TEST_CASE(HandleOutlivesStagingArea) {
+    out::StagingArea::handle step;
+    {
+        out::StagingArea staging( 1 );
+        step = staging.stage( make_solution( 1.0 ), data::Wells{}, {}, {} );
+    }
+    BOOST_CHECK_EQUAL( step->cells.data( "PRESSURE" )[ 0 ] , 1.0 );
+}
+
+
+BOOST_AUTO_TEST_CASE(WellsAreReused) {
+    out::StagingArea staging( 1 );
+
+    const auto make_wells = []( double rate, bool with_op2 ) {
+        data::Wells wells;
+        data::Rates rates;
+        rates.set( data::Rates::opt::oil, rate );
+
+        wells[ "OP1" ] = { rates, 1.0, 2.0, 3.0, 1,
+                           { { 0, rates, 4.0, rate },
+                             { 1, rates, 5.0, rate } } };
+        if( with_op2 )
+            wells[ "OP2" ] = { rates, 1.0, 2.0, 3.0, 1, { { 2, rates, 6.0, rate } } };
+
+        return wells;
+    };
+
+    const data::Well* op1;
+    const data::Completion* completions;
+    {
+        auto step = staging.stage( make_solution( 1.0 ), make_wells( 10.0, true ), {}, {} );
+        BOOST_CHECK_EQUAL( step->wells.size() , 2U );
+        op1 = &step->wells.at( "OP1" );
+        completions = step->wells.at( "OP1" ).completions.data();
+    }
+
+    auto step = staging.stage( make_solution( 1.0 ), make_wells( 20.0, false ), {}, {} );
+    BOOST_CHECK_EQUAL( step->wells.size() , 1U );
+    BOOST_CHECK( &step->wells.at( "OP1" ) == op1 );
+
+    const auto& well = step->wells.at( "OP1" );
+    BOOST_CHECK( well.completions.data() == completions );
+    BOOST_CHECK_EQUAL( well.completions.size() , 2U );
+    BOOST_CHECK_EQUAL( well.rates.get( data::Rates::opt::oil ) , 20.0 );
+    BOOST_CHECK_EQUAL( well.completions[ 1 ].pressure , 5.0 );
+    BOOST_CHECK_EQUAL( well.completions[ 1 ].reservoir_rate , 20.0 );
+    BOOST_CHECK_EQUAL( step->wells.get( "OP1", 1, data::Rates::opt::oil ) , 20.0 );
+}
+
+
+BOOST_AUTO_TEST_CASE(AllocationsAreCounted) {
+    using out::statistics::phase;
+
+    out::StagingArea staging( 1 );
+    const std::map< std::string, std::vector< double > > extra = {{ "OPMEXTRA", { 1.0, 2.0 }}};
+
+    data::Rates rates;
+    rates.set( data::Rates::opt::oil, 10.0 );
+    data::Wells wells;
+    wells[ "OP1" ] = { rates, 1.0, 2.0, 3.0, 1,
+                       { { 0, rates, 4.0, 10.0 },
+                         { 1, rates, 5.0, 10.0 } } };
+
+    out::statistics::reset();
+
+    /* The buffer, PRESSURE, the completions of OP1 and OPMEXTRA. */
+    staging.stage( make_solution( 1.0 ), wells, {}, extra );
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::stage ).allocations , 4U );
+
+    staging.stage( make_solution( 2.0 ), wells, {}, extra );
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::stage ).allocations , 4U );
+
+    data::Solution larger;
+    larger.insert( "PRESSURE", UnitSystem::measure::pressure,
+                   std::vector< double >( 200, 1.0 ),
+                   data::TargetType::RESTART_SOLUTION );
+    staging.stage( larger, wells, {}, extra );
+
+    const auto counters = out::statistics::get( phase::stage );
+    BOOST_CHECK_EQUAL( counters.allocations , 5U );
+    BOOST_CHECK_EQUAL( counters.calls , 3U );
+}
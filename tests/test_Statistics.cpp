@@ -0,0 +1,135 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE Statistics
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <opm/output/eclipse/Statistics.hpp>
+
+using namespace Opm;
+using out::statistics::phase;
+
+
+BOOST_AUTO_TEST_CASE(ScopedTimer) {
+    out::statistics::reset();
+    {
+        out::statistics::scoped_timer timer( phase::restart_save );
+        std::this_thread::sleep_for( std::chrono::milliseconds( 2 ));
+    }
+
+    const auto c = out::statistics::get( phase::restart_save );
+    BOOST_CHECK_EQUAL( c.calls , 1U );
+    BOOST_CHECK( c.seconds >= 0.002 );
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::restart_load ).calls , 0U );
+}
+
+
+BOOST_AUTO_TEST_CASE(ScopedWrite) {
+    out::statistics::reset();
+    {
+        out::statistics::scoped_timer timer( phase::restart_save );
+        {
+            out::statistics::scoped_write write( phase::restart_save, 2 );
+            std::this_thread::sleep_for( std::chrono::milliseconds( 2 ));
+        }
+        out::statistics::scoped_write header( phase::restart_save, 0 );
+    }
+
+    const auto c = out::statistics::get( phase::restart_save );
+    BOOST_CHECK_EQUAL( c.calls , 1U );
+    BOOST_CHECK_EQUAL( c.keywords , 2U );
+    BOOST_CHECK( c.write_seconds >= 0.002 );
+    BOOST_CHECK( c.write_seconds <= c.seconds );
+}
+
+
+BOOST_AUTO_TEST_CASE(CountersAndReset) {
+    out::statistics::reset();
+    out::statistics::add_bytes( phase::summary_write, 100 );
+    out::statistics::add_bytes( phase::summary_write, 50 );
+    out::statistics::add_keywords( phase::summary_write );
+    out::statistics::add_keywords( phase::summary_write, 2 );
+    out::statistics::add_allocations( phase::summary_write );
+    out::statistics::add_allocations( phase::summary_write, 4 );
+    out::statistics::add_write( phase::init_write, std::chrono::milliseconds( 3 ), 4 );
+
+    const auto summary = out::statistics::get( phase::summary_write );
+    BOOST_CHECK_EQUAL( summary.bytes , 150U );
+    BOOST_CHECK_EQUAL( summary.keywords , 3U );
+    BOOST_CHECK_EQUAL( summary.allocations , 5U );
+    BOOST_CHECK_EQUAL( summary.write_seconds , 0.0 );
+
+    const auto init = out::statistics::get( phase::init_write );
+    BOOST_CHECK_EQUAL( init.keywords , 4U );
+    BOOST_CHECK_CLOSE( init.write_seconds , 0.003 , 1e-6 );
+    BOOST_CHECK_EQUAL( init.calls , 0U );
+    BOOST_CHECK_EQUAL( init.seconds , 0.0 );
+
+    out::statistics::reset();
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::summary_write ).bytes , 0U );
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::summary_write ).allocations , 0U );
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::init_write ).keywords , 0U );
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::init_write ).write_seconds , 0.0 );
+}
+
+
+BOOST_AUTO_TEST_CASE(ConcurrentUpdates) {
+    out::statistics::reset();
+    auto add = []() {
+        for (int i = 0; i < 10000; i++)
+            out::statistics::add_bytes( phase::egrid_write, 1 );
+    };
+
+    std::thread t1( add ), t2( add );
+    t1.join();
+    t2.join();
+    BOOST_CHECK_EQUAL( out::statistics::get( phase::egrid_write ).bytes , 20000U );
+}
+
+
+BOOST_AUTO_TEST_CASE(JSON) {
+    out::statistics::reset();
+    out::statistics::add_keywords( phase::rft_write, 7 );
+    out::statistics::add_allocations( phase::rft_write, 3 );
+
+    const auto json = out::statistics::json();
+    for (std::size_t i = 0; i < out::statistics::num_phases; i++) {
+        const std::string key = std::string( "\"" ) + out::statistics::name( static_cast< phase >( i )) + "\": {";
+        BOOST_CHECK( json.find( key ) != std::string::npos );
+    }
+
+    BOOST_CHECK( json.find( "\"rft_write\": { \"calls\": 0, \"seconds\": 0.000000000, \"write_seconds\": 0.000000000, \"bytes\": 0, \"keywords\": 7, \"allocations\": 3 }" ) != std::string::npos );
+    BOOST_CHECK_EQUAL( json.front() , '{' );
+
+    /* The stream formatting is restored. */
+    std::ostringstream os;
+    out::statistics::write_json( os );
+    os << 0.5;
+    BOOST_CHECK_EQUAL( os.str().substr( os.str().size() - 5 ) , "}\n0.5" );
+}
@@ -27,14 +27,20 @@
 #include <boost/test/unit_test.hpp>
 #include <boost/date_time/posix_time/posix_time.hpp>
 
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
 #include <stdexcept>
 
 #include <ert/ecl/ecl_sum.h>
+#include <ert/util/stringlist.h>
 #include <ert/util/util.h>
 #include <ert/util/TestArea.hpp>
 
+#include <opm/output/data/IndexedWells.hpp>
 #include <opm/output/data/Wells.hpp>
 #include <opm/output/data/Cells.hpp>
+#include <opm/output/eclipse/MappedEclFile.hpp>
 #include <opm/output/eclipse/Summary.hpp>
 
 #include <opm/parser/eclipse/Deck/Deck.hpp>
@@ -1148,3 +1154,175 @@ BOOST_AUTO_TEST_CASE(EXTRA) {
     /* Override a NOT MISC variable - ignored. */
     BOOST_CHECK(  ecl_sum_get_general_var( resp , 4 , "FOPR") > 0.0 );
 }
+
+
+BOOST_AUTO_TEST_CASE(incremental_write) {
+    setup cfg( "test_incremental_write");
+
+    {
+        out::Summary writer( cfg.es, cfg.config, cfg.grid, cfg.schedule , cfg.name );
+        writer.setFlushPolicy( out::SummaryWriter::flush_policy::sync );
+        for (int step = 0; step < 3; step++) {
+            writer.add_timestep( step, step * day, cfg.es, cfg.schedule, cfg.wells , cfg.solution, { {"TCPU" , step }});
+            writer.add_timestep( step, (step + 0.5) * day, cfg.es, cfg.schedule, cfg.wells , cfg.solution, { {"TCPU" , step + 0.5 }});
+            writer.write();
+
+            /* Each report step goes to a new file: SEQHDR and two ministeps. */
+            out::MappedEclFile file( cfg.name + ".S000" + std::to_string( step ));
+            BOOST_CHECK_EQUAL( file.keywords().size() , 5U );
+            BOOST_CHECK_EQUAL( file.keywords()[0].name , "SEQHDR" );
+            BOOST_CHECK_EQUAL( file.read_int( file.keywords()[3] )[0] , 2 * step + 1 );
+        }
+    }
+
+    auto res = readsum( cfg.name );
+    const auto* resp = res.get();
+    BOOST_CHECK_EQUAL( ecl_sum_get_data_length( resp ) , 6 );
+    BOOST_CHECK_CLOSE( 1.5 , ecl_sum_get_general_var( resp , 3 , "TCPU") , 0.001);
+    BOOST_CHECK_CLOSE( 2.5 , ecl_sum_get_general_var( resp , 5 , "TCPU") , 0.001);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_evaluation) {
+    setup cfg( "test_parallel_evaluation");
+
+    for (const size_t num_threads : { 1, 4 }) {
+        out::Summary writer( cfg.es, cfg.config, cfg.grid, cfg.schedule , cfg.name + std::to_string( num_threads ));
+        writer.setEvaluationThreads( num_threads );
+        writer.set_initial( cfg.solution );
+        for (int step = 0; step < 3; step++)
+            writer.add_timestep( step, step * day, cfg.es, cfg.schedule, cfg.wells , cfg.solution, {});
+
+        writer.write();
+    }
+
+    auto serial = readsum( cfg.name + "1" );
+    auto parallel = readsum( cfg.name + "4" );
+    stringlist_type* keys = stringlist_alloc_new();
+    ecl_sum_select_matching_general_var_list( serial.get(), "*", keys );
+    BOOST_CHECK( stringlist_get_size( keys ) > 0 );
+
+    for (int i = 0; i < stringlist_get_size( keys ); i++) {
+        const char* key = stringlist_iget( keys, i );
+        BOOST_CHECK( ecl_sum_has_general_var( parallel.get(), key ) );
+        for (int step = 0; step < 3; step++)
+            BOOST_CHECK_EQUAL( ecl_sum_get_general_var( serial.get(), step, key ),
+                               ecl_sum_get_general_var( parallel.get(), step, key ) );
+    }
+
+    stringlist_free( keys );
+}
+
+BOOST_AUTO_TEST_CASE(indexed_wells) {
+    setup cfg( "test_indexed_wells");
+    const data::IndexedWells indexed( cfg.wells );
+
+    {
+        out::Summary writer( cfg.es, cfg.config, cfg.grid, cfg.schedule , cfg.name + "_WELLS" );
+        for (int step = 0; step < 3; step++)
+            writer.add_timestep( step, step * day, cfg.es, cfg.schedule, cfg.wells , cfg.solution, {});
+
+        writer.write();
+    }
+    {
+        out::Summary writer( cfg.es, cfg.config, cfg.grid, cfg.schedule , cfg.name + "_INDEXED" );
+        for (int step = 0; step < 3; step++)
+            writer.add_timestep( step, step * day, cfg.es, cfg.schedule, indexed , cfg.solution, {});
+
+        writer.write();
+    }
+
+    auto wells = readsum( cfg.name + "_WELLS" );
+    auto indexed_wells = readsum( cfg.name + "_INDEXED" );
+    stringlist_type* keys = stringlist_alloc_new();
+    ecl_sum_select_matching_general_var_list( wells.get(), "*", keys );
+    BOOST_CHECK( stringlist_get_size( keys ) > 0 );
+
+    for (int i = 0; i < stringlist_get_size( keys ); i++) {
+        const char* key = stringlist_iget( keys, i );
+        for (int step = 0; step < 3; step++)
+            BOOST_CHECK_EQUAL( ecl_sum_get_general_var( wells.get(), step, key ),
+                               ecl_sum_get_general_var( indexed_wells.get(), step, key ) );
+    }
+
+    stringlist_free( keys );
+}
+
+
+namespace {
+
+/*
+  The summary deck with a RESTART keyword in the SOLUTION section,
+  restarting from report step 1 of restart_case.
+*/
+std::string restart_deck( const std::string& restart_case ) {
+    std::ifstream stream( "summary_deck.DATA" );
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+
+    auto deck = buffer.str();
+    const auto summary = deck.find( "\nSUMMARY" );
+    deck.insert( summary, "\nSOLUTION\nRESTART\n'" + restart_case + "' 1 /\n" );
+    return deck;
+}
+
+void write_deck( const std::string& filename, const std::string& deck ) {
+    std::ofstream stream( filename );
+    stream << deck;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(restart_totals) {
+    const auto deck = restart_deck( "BASE" );
+    const auto missing_deck = restart_deck( "MISSING" );
+
+    setup base( "BASE" );
+    {
+        out::Summary writer( base.es, base.config, base.grid, base.schedule , base.name );
+        writer.add_timestep( 0, 0 * day, base.es, base.schedule, base.wells , base.solution, {});
+        writer.add_timestep( 1, 1 * day, base.es, base.schedule, base.wells , base.solution, {});
+        writer.write();
+    }
+
+    /*
+      The restart decks are written next to the base case, while the
+      restart run itself is set up in a different working directory;
+      the restart case must be found through the output directory.
+    */
+    char* cwd = util_alloc_cwd();
+    const std::string base_dir( cwd );
+    free( cwd );
+    write_deck( "RESTART.DATA", deck );
+    write_deck( "MISSING.DATA", missing_deck );
+
+    {
+        setup restart( "RESTART", (base_dir + "/RESTART.DATA").c_str() );
+        out::Summary writer( restart.es, restart.config, restart.grid, restart.schedule , restart.name );
+        writer.add_timestep( 2, 2 * day, restart.es, restart.schedule, restart.wells , restart.solution, {});
+        writer.write();
+
+        auto base_sum = readsum( base_dir + "/BASE" );
+        auto restart_sum = readsum( "RESTART" );
+        const auto base_step = ecl_sum_iget_report_end( base_sum.get(), 1 );
+        const auto restart_step = ecl_sum_iget_report_end( restart_sum.get(), 2 );
+
+        BOOST_CHECK_CLOSE( 10.1, ecl_sum_get_general_var( base_sum.get(), base_step, "WOPT:W_1" ), 1e-5 );
+        BOOST_CHECK_CLOSE( 2 * 10.1, ecl_sum_get_general_var( restart_sum.get(), restart_step, "WOPT:W_1" ), 1e-5 );
+        BOOST_CHECK_CLOSE( 2 * 20.1, ecl_sum_get_general_var( restart_sum.get(), restart_step, "WOPT:W_2" ), 1e-5 );
+        BOOST_CHECK_CLOSE( 2 * ecl_sum_get_general_var( base_sum.get(), base_step, "FOPT" ),
+                           ecl_sum_get_general_var( restart_sum.get(), restart_step, "FOPT" ), 1e-5 );
+    }
+
+    {
+        /* Without the summary of the restart case the totals start from zero. */
+        setup missing( "MISSING", (base_dir + "/MISSING.DATA").c_str() );
+        out::Summary writer( missing.es, missing.config, missing.grid, missing.schedule , missing.name );
+        writer.add_timestep( 2, 2 * day, missing.es, missing.schedule, missing.wells , missing.solution, {});
+        writer.write();
+
+        auto missing_sum = readsum( "MISSING" );
+        const auto missing_step = ecl_sum_iget_report_end( missing_sum.get(), 2 );
+        BOOST_CHECK_CLOSE( 2 * 10.1, ecl_sum_get_general_var( missing_sum.get(), missing_step, "WOPT:W_1" ), 1e-5 );
+        BOOST_CHECK_CLOSE( 2 * 20.1, ecl_sum_get_general_var( missing_sum.get(), missing_step, "WOPT:W_2" ), 1e-5 );
+    }
+}
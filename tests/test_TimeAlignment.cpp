@@ -0,0 +1,132 @@
+/*
+   Copyright 2017 Statoil ASA.
+
+   This file is part of the Open Porous Media project (OPM).
+
+   OPM is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   OPM is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+   */
+
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE TimeAlignmentTest
+
+#include <boost/test/unit_test.hpp>
+#include <opm/test_util/TimeAlignment.hpp>
+
+#include <vector>
+
+
+BOOST_AUTO_TEST_CASE(sameTimeSteps) {
+    const std::vector<double> time = {0, 1, 2, 3};
+    const std::vector<double> data = {5, 6, 7, 8};
+
+    const TimeAlignment alignment(time, time);
+    BOOST_CHECK_EQUAL(alignment.size(), 4U);
+
+    std::vector<double> values(alignment.size());
+    alignment.apply(data.data(), values.data());
+    BOOST_CHECK(values == data);
+
+    for (size_t i = 0; i < alignment.size(); i++) {
+        BOOST_CHECK_EQUAL(alignment.lower(i), i);
+        BOOST_CHECK_EQUAL(alignment.upper(i), i);
+        BOOST_CHECK_EQUAL(alignment.time(i), time[i]);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(sequential) {
+    const std::vector<double> refTime   = {0, 1.5, 1.7, 3, 4};
+    const std::vector<double> checkTime = {0, 1, 2, 3};
+    const std::vector<double> checkData = {10, 11, 12, 13};
+
+    // Sequential is the default.
+    const TimeAlignment alignment(refTime, checkTime);
+
+    // Each checked time step is used once, so the checked vector ends after 1.7.
+    BOOST_CHECK_EQUAL(alignment.size(), 3U);
+
+    std::vector<double> values(alignment.size());
+    alignment.apply(checkData.data(), values.data());
+
+    // 1.5 takes the value at 2, and 1.7 the value at the checked time step after it.
+    const std::vector<double> expected = {10, 12, 13};
+    BOOST_CHECK(values == expected);
+    BOOST_CHECK_EQUAL(alignment.time(1), 2.0);
+    BOOST_CHECK_EQUAL(alignment.time(2), 3.0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(unitStep) {
+    const std::vector<double> refTime   = {0, 1.5, 1.7, 3, 4};
+    const std::vector<double> checkTime = {0, 1, 2, 3};
+    const std::vector<double> checkData = {10, 11, 12, 13};
+
+    const TimeAlignment alignment(refTime, checkTime, TimeAlignment::UnitStep);
+
+    // The last reference time step is after the end of the checked vector.
+    BOOST_CHECK_EQUAL(alignment.size(), 4U);
+
+    std::vector<double> values(alignment.size());
+    alignment.apply(checkData.data(), values.data());
+
+    // Both 1.5 and 1.7 take the value at the next checked time step.
+    const std::vector<double> expected = {10, 12, 12, 13};
+    BOOST_CHECK(values == expected);
+    BOOST_CHECK_EQUAL(alignment.time(1), 2.0);
+    BOOST_CHECK_EQUAL(alignment.time(2), 2.0);
+    BOOST_CHECK_EQUAL(alignment.value(checkData.data(), 3), 13.0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(linear) {
+    const std::vector<double> refTime   = {-1, 0, 1.5, 2.75, 3};
+    const std::vector<double> checkTime = {0, 1, 2, 3};
+    const std::vector<double> checkData = {10, 11, 12, 16};
+
+    const TimeAlignment alignment(refTime, checkTime, TimeAlignment::Linear);
+    BOOST_CHECK_EQUAL(alignment.size(), 5U);
+
+    std::vector<double> values(alignment.size());
+    alignment.apply(checkData.data(), values.data());
+
+    // Before the first checked time step the first value is used.
+    BOOST_CHECK_EQUAL(values[0], 10.0);
+    BOOST_CHECK_EQUAL(values[1], 10.0);
+    BOOST_CHECK_CLOSE(values[2], 11.5, 1e-12);
+    BOOST_CHECK_CLOSE(values[3], 15.0, 1e-12);
+    BOOST_CHECK_EQUAL(values[4], 16.0);
+
+    BOOST_CHECK_EQUAL(alignment.lower(2), 1U);
+    BOOST_CHECK_EQUAL(alignment.upper(2), 2U);
+    BOOST_CHECK_CLOSE(alignment.weight(2), 0.5, 1e-12);
+    BOOST_CHECK_EQUAL(alignment.time(2), 1.5);
+    BOOST_CHECK_EQUAL(alignment.time(4), 3.0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(empty) {
+    const std::vector<double> time = {0, 1};
+
+    BOOST_CHECK_EQUAL(TimeAlignment(time, {}).size(), 0U);
+    BOOST_CHECK_EQUAL(TimeAlignment({}, time).size(), 0U);
+    BOOST_CHECK_EQUAL(TimeAlignment({2, 3}, time, TimeAlignment::Linear).size(), 0U);
+}
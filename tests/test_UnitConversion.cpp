@@ -0,0 +1,109 @@
+/*
+  Copyright 2017 Statoil ASA.
+
+  This file is part of the Open Porous Media project (OPM).
+
+  OPM is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  OPM is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with OPM.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "config.h"
+
+#if HAVE_DYNAMIC_BOOST_TEST
+#define BOOST_TEST_DYN_LINK
+#endif
+
+#define BOOST_TEST_MODULE UnitConversion
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include <opm/output/eclipse/UnitConversion.hpp>
+#include <opm/parser/eclipse/Units/UnitSystem.hpp>
+
+using namespace Opm;
+
+
+BOOST_AUTO_TEST_CASE(Identity) {
+    const std::vector<double> data = { 1.0, -2.5, 1e10, 0.1 };
+    const out::UnitConversion conversion;
+    BOOST_CHECK( conversion.identity() );
+
+    const auto output = conversion.apply< float >( data );
+    BOOST_CHECK_EQUAL( output.size() , data.size() );
+    for (size_t i = 0; i < data.size(); i++)
+        BOOST_CHECK_EQUAL( output[i] , float( data[i] ));
+
+    const auto metric = UnitSystem::newMETRIC();
+    BOOST_CHECK( out::UnitConversion( metric, UnitSystem::measure::identity ).identity() );
+}
+
+
+BOOST_AUTO_TEST_CASE(SameAsUnitSystem) {
+    std::vector<double> data;
+    for (int i = 0; i < 1001; i++)
+        data.push_back( 1e3 * i - 5e5 );
+
+    for (const auto& units : { UnitSystem::newMETRIC(), UnitSystem::newFIELD() }) {
+        for (const auto m : { UnitSystem::measure::pressure,
+                              UnitSystem::measure::temperature,
+                              UnitSystem::measure::volume,
+                              UnitSystem::measure::transmissibility }) {
+            const out::UnitConversion conversion( units, m );
+
+            auto expected = data;
+            units.from_si( m, expected );
+
+            const auto as_double = conversion.apply< double >( data );
+            const auto as_float = conversion.apply< float >( data );
+            for (size_t i = 0; i < data.size(); i++) {
+                BOOST_CHECK_CLOSE( as_double[i] , expected[i] , 1e-10 );
+                BOOST_CHECK_CLOSE( as_float[i] , float( expected[i] ) , 1e-4 );
+            }
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(RawBuffer) {
+    const std::vector<double> data( 17, 2e5 );
+    std::vector<float> output( data.size() + 1, -1 );
+    const out::UnitConversion conversion( UnitSystem::newMETRIC(), UnitSystem::measure::pressure );
+
+    conversion.apply( data.data(), data.size(), output.data() );
+    for (size_t i = 0; i < data.size(); i++)
+        BOOST_CHECK_CLOSE( output[i] , 2.0f , 1e-4 );
+
+    /* Nothing is written beyond the end. */
+    BOOST_CHECK_EQUAL( output.back() , -1 );
+}
+
+
+BOOST_AUTO_TEST_CASE(Gather) {
+    std::vector<double> data;
+    for (int i = 0; i < 10; i++)
+        data.push_back( 1e5 * i );
+
+    const std::vector<size_t> index = { 9, 0, 3, 3, 7 };
+    std::vector<float> output( index.size() );
+    const auto metric = UnitSystem::newMETRIC();
+    const out::UnitConversion conversion( metric, UnitSystem::measure::pressure );
+
+    conversion.gather( data.data(), index.data(), index.size(), output.data() );
+    for (size_t i = 0; i < index.size(); i++)
+        BOOST_CHECK_CLOSE( output[i] , float( metric.from_si( UnitSystem::measure::pressure, data[index[i]] )) , 1e-4 );
+
+    std::vector<double> identity( index.size() );
+    out::UnitConversion().gather( data.data(), index.data(), index.size(), identity.data() );
+    for (size_t i = 0; i < index.size(); i++)
+        BOOST_CHECK_EQUAL( identity[i] , data[index[i]] );
+}
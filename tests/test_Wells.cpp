@@ -29,6 +29,8 @@
 #include <stdexcept>
 
 #include <opm/output/data/Wells.hpp>
+#include <opm/output/data/IndexedWells.hpp>
+#include <opm/output/data/RatesTable.hpp>
 
 using namespace Opm;
 using rt = data::Rates::opt;
@@ -127,3 +129,135 @@ BOOST_AUTO_TEST_CASE(get_completions) {
     BOOST_CHECK_EQUAL( 0.0, wellRates.get("OP_2" , 10000 , data::Rates::opt::wat) );
     BOOST_CHECK_EQUAL( 26.41 , wellRates.get( "OP_2" , 188 , data::Rates::opt::wat));
 }
+
+
+BOOST_AUTO_TEST_CASE(indexed_wells) {
+    data::Rates r1, r2, rc1, rc2, rc3;
+    r1.set( data::Rates::opt::wat, 5.67 );
+    r1.set( data::Rates::opt::oil, 6.78 );
+
+    rc1.set( data::Rates::opt::wat, 20.41 );
+    rc2.set( data::Rates::opt::wat, 23.19 );
+    rc3.set( data::Rates::opt::wat, 26.41 );
+
+    data::Well w1, w2;
+    w1.rates = r1;
+    w1.bhp = 1.23;
+    w1.thp = 0.12;
+    w1.temperature = 3.45;
+    w1.control = 1;
+    w1.completions.push_back( { 88, rc1, 30.45, 123.45 } );
+    w1.completions.push_back( { 288, rc2, 33.19, 67.89 } );
+
+    w2.rates = r2;
+    w2.bhp = 2.34;
+    w2.control = 2;
+    w2.completions.push_back( { 188, rc3, 36.22, 19.28 } );
+
+    data::Wells wellRates;
+    wellRates["OP_1"] = w1;
+    wellRates["OP_2"] = w2;
+
+    const data::IndexedWells wells( wellRates );
+    BOOST_CHECK_EQUAL( 2U, wells.size() );
+    BOOST_CHECK_EQUAL( 3U, wells.numCompletions() );
+    BOOST_CHECK_EQUAL( data::IndexedWells::npos, wells.id( "NO_SUCH_WELL" ) );
+
+    const auto op1 = wells.id( "OP_1" );
+    const auto op2 = wells.id( "OP_2" );
+    BOOST_CHECK_EQUAL( "OP_1", wells.name( op1 ) );
+    BOOST_CHECK_EQUAL( "OP_2", wells.name( op2 ) );
+    BOOST_CHECK_EQUAL( 1.23, wells.bhp( op1 ) );
+    BOOST_CHECK_EQUAL( 0.12, wells.thp( op1 ) );
+    BOOST_CHECK_EQUAL( 3.45, wells.temperature( op1 ) );
+    BOOST_CHECK_EQUAL( 2, wells.control( op2 ) );
+    BOOST_CHECK( wells.flowing( op1 ) );
+    BOOST_CHECK( !wells.flowing( op2 ) );
+    BOOST_CHECK_EQUAL( 2, wells.completions_end( op1 ) - wells.completions_begin( op1 ) );
+    BOOST_CHECK_EQUAL( 1, wells.completions_end( op2 ) - wells.completions_begin( op2 ) );
+
+    BOOST_CHECK( !wells.completion( op1, 188 ) );
+    BOOST_CHECK_EQUAL( 33.19, wells.completion( op1, 288 )->pressure );
+    BOOST_CHECK_EQUAL( 19.28, wells.completion( op2, 188 )->reservoir_rate );
+
+    /* The same semantics as the map based container. */
+    BOOST_CHECK_EQUAL( 0.0, wells.get( "NO_SUCH_WELL" , data::Rates::opt::wat ) );
+    BOOST_CHECK_EQUAL( 0.0, wells.get( "OP_1" , data::Rates::opt::gas ) );
+    BOOST_CHECK_EQUAL( 5.67 , wells.get( "OP_1" , data::Rates::opt::wat ) );
+    BOOST_CHECK_EQUAL( 0.0, wells.get( "OP_2" , 10000 , data::Rates::opt::wat ) );
+    BOOST_CHECK_EQUAL( 26.41 , wells.get( "OP_2" , 188 , data::Rates::opt::wat ) );
+    BOOST_CHECK_EQUAL( 23.19 , wells.get( op1 , 288 , data::Rates::opt::wat ) );
+
+    BOOST_CHECK_EQUAL( data::IndexedWells::no_row, wells.completion_row( op1, 188 ) );
+    BOOST_CHECK_EQUAL( data::IndexedWells::no_row, wells.completion_row( data::IndexedWells::npos, 188 ) );
+    const auto row = wells.completion_row( op2, 188 );
+    BOOST_CHECK_EQUAL( 26.41, wells.completion_rates().get( row, data::Rates::opt::wat, 0.0 ) );
+    BOOST_CHECK_EQUAL( 5.67, wells.well_rates().get( op1, data::Rates::opt::wat, 0.0 ) );
+    BOOST_CHECK_EQUAL( 20.41 + 23.19 + 26.41, wells.completion_rates().sum( data::Rates::opt::wat ) );
+
+    const auto roundtrip = wells.wells();
+    BOOST_CHECK_EQUAL( 2U, roundtrip.size() );
+    BOOST_CHECK_EQUAL( 2U, roundtrip.at( "OP_1" ).completions.size() );
+    BOOST_CHECK_EQUAL( 288, roundtrip.at( "OP_1" ).completions[1].index );
+    BOOST_CHECK_EQUAL( 2.34, roundtrip.at( "OP_2" ).bhp );
+    BOOST_CHECK_EQUAL( 26.41 , roundtrip.get( "OP_2" , 188 , data::Rates::opt::wat ) );
+
+    data::IndexedWells added;
+    BOOST_CHECK_EQUAL( 0, added.add( "OP_2", w2 ) );
+    BOOST_CHECK_EQUAL( 1, added.add( "OP_1", w1 ) );
+    BOOST_CHECK_THROW( added.add( "OP_1", w1 ), std::invalid_argument );
+    BOOST_CHECK_EQUAL( 20.41 , added.get( "OP_1" , 88 , data::Rates::opt::wat ) );
+}
+
+
+BOOST_AUTO_TEST_CASE(rates_table) {
+    data::RatesTable table;
+    std::vector< data::Rates > rates( 11 );
+
+    for( size_t i = 0; i < rates.size(); i++ ) {
+        rates[ i ].set( rt::wat, i % 2 == 0 ? double( i ) : -double( i ) );
+        if( i % 3 == 0 )
+            rates[ i ].set( rt::oil, 0.5 * i );
+        if( i == 7 )
+            rates[ i ].set( rt::reservoir_gas, 100 );
+
+        BOOST_CHECK_EQUAL( i, table.push_back( rates[ i ] ) );
+    }
+
+    BOOST_CHECK_EQUAL( rates.size(), table.size() );
+    BOOST_CHECK_EQUAL( 10U, data::RatesTable::column_index( rt::reservoir_gas ) );
+    BOOST_CHECK_THROW( data::RatesTable::column_index( static_cast< rt >( 3 ) ), std::invalid_argument );
+
+    /* Unset values are stored as zero, and get() honours the mask. */
+    BOOST_CHECK( table.has( 3, rt::oil ) );
+    BOOST_CHECK( !table.has( 4, rt::oil ) );
+    BOOST_CHECK_EQUAL( -1.0, table.get( 4, rt::oil, -1.0 ) );
+    BOOST_CHECK_EQUAL( 0.0, table.column( rt::oil )[ 4 ] );
+    BOOST_CHECK_EQUAL( 100, table.rates( 7 ).get( rt::reservoir_gas ) );
+    BOOST_CHECK( !table.rates( 7 ).has( rt::oil ) );
+
+    /* wat: 0, -1, 2, -3, ..., 10 */
+    BOOST_CHECK_EQUAL( 5.0, table.sum( rt::wat ) );
+    BOOST_CHECK_EQUAL( 30.0, table.injected( rt::wat ) );
+    BOOST_CHECK_EQUAL( 25.0, table.produced( rt::wat ) );
+    BOOST_CHECK_EQUAL( 9.0, table.sum( rt::oil ) );
+    BOOST_CHECK_EQUAL( 0.0, table.sum( rt::gas ) );
+
+    const data::RatesTable::rows index_set = { 1, 2, 3, 6, 6, 9 };
+    BOOST_CHECK_EQUAL( 1.0, table.sum( rt::wat, index_set ) );
+    BOOST_CHECK_EQUAL( 14.0, table.injected( rt::wat, index_set ) );
+    BOOST_CHECK_EQUAL( 13.0, table.produced( rt::wat, index_set ) );
+    BOOST_CHECK_EQUAL( 0.0, table.produced( rt::oil, index_set ) );
+
+    double injected = 0, produced = 0;
+    for( const auto row : index_set ) {
+        const auto v = rates[ row ].get( rt::oil, 0.0 );
+        if( v > 0 ) injected += v; else produced -= v;
+    }
+    BOOST_CHECK_EQUAL( injected, table.injected( rt::oil, index_set ) );
+    BOOST_CHECK_EQUAL( produced, table.produced( rt::oil, index_set ) );
+
+    table.clear();
+    BOOST_CHECK_EQUAL( 0U, table.size() );
+    BOOST_CHECK_EQUAL( 0.0, table.sum( rt::wat ) );
+}
@@ -20,6 +20,18 @@
 #include "config.h"
 #include <opm/test_util/summaryComparator.hpp>
 #include <opm/test_util/summaryIntegrationTest.hpp>
+#include <opm/test_util/summaryRegressionTest.hpp>
+
+#include <ert/ecl/ecl_sum.h>
+#include <ert/util/TestArea.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
 
 #if HAVE_DYNAMIC_BOOST_TEST
@@ -30,6 +42,100 @@
 #include <boost/test/unit_test.hpp>
 
 
+namespace {
+
+    const size_t numWells = 5;
+
+    double summaryValue(size_t well, size_t step) {
+        return 1000.0 * well + step;
+    }
+
+    // Writes a summary case with WOPR for the wells W0, ..., W4 at numSteps daily time steps; the value of well k at step i is
+    // summaryValue(k, i), and deviation is added to the values of deviatingWell at deviatingSteps, or at all the steps if it is empty.
+    void writeSummary(const std::string& name, size_t numSteps, size_t deviatingWell = numWells, double deviation = 0,
+                      const std::vector<size_t>& deviatingSteps = {}) {
+        ecl_sum_type* sum = ecl_sum_alloc_writer(name.c_str(), false, true, ":", 0, true, 10, 10, 10);
+        std::vector<const smspec_node_type*> nodes;
+        for (size_t well = 0; well < numWells; well++)
+            nodes.push_back(ecl_sum_add_var(sum, "WOPR", ("W" + std::to_string(well)).c_str(), 0, "SM3/DAY", 0));
+
+        for (size_t step = 0; step < numSteps; step++) {
+            auto* tstep = ecl_sum_add_tstep(sum, int(step) + 1, step * 86400.0);
+            for (size_t well = 0; well < numWells; well++) {
+                const bool deviating = well == deviatingWell
+                    && (deviatingSteps.empty() || std::find(deviatingSteps.begin(), deviatingSteps.end(), step) != deviatingSteps.end());
+                ecl_sum_tstep_set_from_node(tstep, nodes[well], summaryValue(well, step) + (deviating ? deviation : 0));
+            }
+        }
+        ecl_sum_fwrite(sum);
+        ecl_sum_free(sum);
+    }
+
+    const std::vector<const char*> wellKeywords = {"WOPR:W0", "WOPR:W1", "WOPR:W2", "WOPR:W3", "WOPR:W4"};
+
+    // Exposes the keyword batches of SummaryComparator, and records the calls to the per keyword functions.
+    class BatchComparator : public SummaryComparator {
+        public:
+            BatchComparator(const char* basename1, const char* basename2) :
+                SummaryComparator(basename1, basename2, 0, 0) {
+                setTimeVecs(timeVec1, timeVec2);
+                chooseReferenceFile(timeVec1, timeVec2);
+            }
+
+            void columns(bool first, std::vector<double>& data) {
+                getDataColumns(first ? ecl_sum1 : ecl_sum2, wellKeywords, data);
+            }
+
+            size_t numReferenceSteps() const { return referenceVec->size(); }
+            size_t numCheckSteps() const { return checkVec->size(); }
+
+            // The calls in the order they are made: ('c', k) for the compare function and ('r', k) for the report function.
+            // The report function returns false for keyword stopAt.
+            bool run(size_t stopAt = numWells) {
+                calls.clear();
+                return forEachKeyword(wellKeywords, 3,
+                                      [&](size_t k, const double* referenceData, const double* checkData, std::vector<double>& scratch) {
+                                          if (scratch.size() != 3 || !hasValues(k, referenceData, numReferenceSteps())
+                                              || !hasValues(k, checkData, numCheckSteps()))
+                                              wrongData = true;
+                                          std::lock_guard<std::mutex> guard(lock);
+                                          calls.emplace_back('c', k);
+                                      },
+                                      [&](size_t k, const double* referenceData, const double* checkData) {
+                                          if (!hasValues(k, referenceData, numReferenceSteps())
+                                              || !hasValues(k, checkData, numCheckSteps()))
+                                              wrongData = true;
+                                          calls.emplace_back('r', k);
+                                          return k != stopAt;
+                                      });
+            }
+
+            std::vector<std::pair<char, size_t>> calls;
+            std::atomic<bool> wrongData{false};
+
+        private:
+            static bool hasValues(size_t well, const double* data, size_t numSteps) {
+                for (size_t step = 0; step < numSteps; step++)
+                    if (data[step] != summaryValue(well, step))
+                        return false;
+                return true;
+            }
+
+            std::vector<double> timeVec1, timeVec2;
+            std::mutex lock;
+    };
+
+    // The calls of BatchComparator::run() with the keywords replaced by the batch they belong to.
+    std::vector<std::pair<char, size_t>> batchCalls(const BatchComparator& comparator, size_t batchSize) {
+        std::vector<std::pair<char, size_t>> calls;
+        for (const auto& call : comparator.calls)
+            calls.emplace_back(call.first, call.second / batchSize);
+        return calls;
+    }
+
+}
+
+
 BOOST_AUTO_TEST_CASE(deviation){
     double a = 5;
     double b = 10;
@@ -97,3 +203,141 @@ BOOST_AUTO_TEST_CASE(integration) {
     BOOST_CHECK_EQUAL(val4,0);
     BOOST_CHECK_EQUAL(val5,24.5);
 }
+
+
+BOOST_AUTO_TEST_CASE(integrationLongVectors) {
+    std::vector<double> time1, data1, time2, data2;
+    for (int i = 0; i <= 100; i++) {
+        time1.push_back(i);
+        data1.push_back(2);
+    }
+    for (int i = 0; i <= 200; i++) {
+        time2.push_back(0.5*i);
+        data2.push_back(i % 2 == 0 ? 2 : 3);
+    }
+
+    BOOST_CHECK_EQUAL(IntegrationTest::integrate(time1, data1), 200);
+    BOOST_CHECK_EQUAL(IntegrationTest::integrate(time2, data2), 250);
+
+    // The error is 1 on every other half step.
+    BOOST_CHECK_EQUAL(IntegrationTest::integrateError(time1, data1, time2, data2), 50);
+    BOOST_CHECK_EQUAL(IntegrationTest::integrateError(time2, data2, time1, data1), 50);
+
+    BOOST_CHECK_EQUAL(IntegrationTest::integrate({}, {}), 0);
+    BOOST_CHECK_EQUAL(IntegrationTest::integrate({1}, {5}), 0);
+    BOOST_CHECK_EQUAL(IntegrationTest::integrateError({}, {}, time1, data1), 0);
+}
+
+
+
+BOOST_AUTO_TEST_CASE(dataColumns) {
+    ERT::TestArea ta("test_compareSummary_columns");
+    writeSummary("FIRST", 12);
+    writeSummary("SECOND", 10);
+
+    BatchComparator comparator("FIRST", "SECOND");
+    std::vector<double> data;
+    comparator.columns(true, data);
+
+    // Keyword-major: the values of keyword k are columns[k*numSteps + step].
+    BOOST_CHECK_EQUAL(data.size(), numWells * 12);
+    for (size_t well = 0; well < numWells; well++)
+        for (size_t step = 0; step < 12; step++)
+            BOOST_CHECK_EQUAL(data[well * 12 + step], summaryValue(well, step));
+
+    // The file with the fewer time steps is the reference.
+    BOOST_CHECK_EQUAL(comparator.numReferenceSteps(), 10U);
+    BOOST_CHECK_EQUAL(comparator.numCheckSteps(), 12U);
+}
+
+
+BOOST_AUTO_TEST_CASE(keywordBatches) {
+    ERT::TestArea ta("test_compareSummary_batches");
+    writeSummary("FIRST", 10);
+    writeSummary("SECOND", 12);
+
+    BatchComparator comparator("FIRST", "SECOND");
+    const size_t valuesPerKeyword = 10 + 12;
+
+    // Room for two keywords per batch; each batch is compared before it is reported.
+    comparator.setMaxBatchValues(2 * valuesPerKeyword + 1);
+    BOOST_CHECK(comparator.run());
+    BOOST_CHECK(!comparator.wrongData);
+    const std::vector<std::pair<char, size_t>> twoPerBatch = {{'c', 0}, {'c', 0}, {'r', 0}, {'r', 0},
+                                                              {'c', 1}, {'c', 1}, {'r', 1}, {'r', 1},
+                                                              {'c', 2}, {'r', 2}};
+    BOOST_CHECK(batchCalls(comparator, 2) == twoPerBatch);
+    BOOST_CHECK_EQUAL(comparator.calls[2].second, 0U);
+    BOOST_CHECK_EQUAL(comparator.calls[3].second, 1U);
+
+    // A batch holds at least one keyword.
+    comparator.setMaxBatchValues(1);
+    BOOST_CHECK(comparator.run());
+    std::vector<std::pair<char, size_t>> onePerBatch;
+    for (size_t k = 0; k < numWells; k++) {
+        onePerBatch.emplace_back('c', k);
+        onePerBatch.emplace_back('r', k);
+    }
+    BOOST_CHECK(comparator.calls == onePerBatch);
+
+    // When report returns false, the remaining keywords of the batch are not reported and the following batches are skipped.
+    comparator.setMaxBatchValues(2 * valuesPerKeyword);
+    BOOST_CHECK(!comparator.run(2));
+    const std::vector<std::pair<char, size_t>> stopped = {{'c', 0}, {'c', 0}, {'r', 0}, {'r', 0},
+                                                          {'c', 1}, {'c', 1}, {'r', 1}};
+    BOOST_CHECK(batchCalls(comparator, 2) == stopped);
+    BOOST_CHECK(!comparator.wrongData);
+}
+
+
+BOOST_AUTO_TEST_CASE(regressionBatches) {
+    ERT::TestArea ta("test_compareSummary_regression");
+    writeSummary("FIRST", 10);
+    writeSummary("SAME", 12);
+    writeSummary("DEVIATING", 12, 3, 100);
+
+    for (size_t maxBatchValues : {size_t(1), size_t(50), size_t(1) << 24}) {
+        {
+            RegressionTest compare("FIRST", "SAME", 1e-3, 1e-3);
+            compare.setMaxBatchValues(maxBatchValues);
+            BOOST_CHECK_NO_THROW(compare.getRegressionTest());
+        }
+        {
+            RegressionTest compare("FIRST", "DEVIATING", 1e-3, 1e-3);
+            compare.throwOnErrors(false);
+            compare.setMaxBatchValues(maxBatchValues);
+            BOOST_CHECK_THROW(compare.getRegressionTest(), std::runtime_error);
+            BOOST_CHECK_NO_THROW(compare.getRegressionTest("WOPR:W2"));
+            BOOST_CHECK_THROW(compare.getRegressionTest("WOPR:W3"), std::runtime_error);
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_CASE(integrationSpikes) {
+    ERT::TestArea ta("test_compareSummary_spikes");
+    writeSummary("FIRST", 10);
+    writeSummary("SPIKE", 12, 2, 100, {4});
+    writeSummary("SPIKES", 12, 2, 100, {4, 5});
+
+    for (size_t maxBatchValues : {size_t(1), size_t(1) << 24}) {
+        {
+            IntegrationTest compare("FIRST", "SPIKE", 1e-3, 1e-3);
+            compare.setAllowSpikes(true);
+            compare.setMaxBatchValues(maxBatchValues);
+            BOOST_CHECK_NO_THROW(compare.getIntegrationTest());
+            compare.setSpikeLimit(0);
+            BOOST_CHECK_THROW(compare.getIntegrationTest(), std::invalid_argument);
+        }
+        {
+            // Two deviations in a row are not a spike.
+            IntegrationTest compare("FIRST", "SPIKES", 1e-3, 1e-3);
+            compare.setAllowSpikes(true);
+            compare.setMaxBatchValues(maxBatchValues);
+            BOOST_CHECK_THROW(compare.getIntegrationTest(), std::invalid_argument);
+            BOOST_CHECK_NO_THROW(compare.getIntegrationTest("WOPR:W1"));
+            BOOST_CHECK_THROW(compare.getIntegrationTest("WOPR:W2"), std::invalid_argument);
+        }
+    }
+}
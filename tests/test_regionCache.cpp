@@ -32,6 +32,8 @@
 #include <opm/parser/eclipse/EclipseState/EclipseState.hpp>
 #include <opm/parser/eclipse/EclipseState/Schedule/Schedule.hpp>
 #include <opm/output/eclipse/RegionCache.hpp>
+#include <opm/output/eclipse/HydrocarbonPoreVolume.hpp>
+#include <opm/output/eclipse/RegionReduction.hpp>
 #include <opm/parser/eclipse/Parser/ParseContext.hpp>
 #include <opm/parser/eclipse/Parser/Parser.hpp>
 
@@ -73,3 +75,86 @@ BOOST_AUTO_TEST_CASE(create) {
         }
     }
 }
+
+
+BOOST_AUTO_TEST_CASE(region_sets) {
+    ParseContext parseContext;
+    Parser parser;
+    Deck deck( parser.parseFile( path, parseContext ));
+    EclipseState es(deck , parseContext );
+    const EclipseGrid& grid = es.getInputGrid();
+    Schedule schedule( deck, grid, es.get3DProperties(), es.runspec().phases(), ParseContext() );
+    const auto& properties = es.get3DProperties();
+    out::RegionCache rc({ "FIPNUM", "EQLNUM", "PVTNUM", "SATNUM" }, properties, grid, schedule);
+
+    BOOST_CHECK( rc.hasRegionSet( "SATNUM" ));
+    BOOST_CHECK( !rc.hasRegionSet( "MULTNUM" ));
+    BOOST_CHECK( rc.cells( "MULTNUM", 1 ).empty() );
+    BOOST_CHECK_EQUAL( rc.cells( 1 ).size() , rc.cells( "FIPNUM", 1 ).size() );
+
+    for (const auto& set : { "FIPNUM", "EQLNUM", "PVTNUM", "SATNUM" }) {
+        const auto& property = properties.getIntGridProperty( set );
+        const auto& regions = rc.regions( set );
+        BOOST_CHECK( regions == properties.getRegions( set ));
+
+        for (const auto region_id : regions) {
+            const auto expected = property.cellsEqual( region_id, grid );
+            const auto cells = rc.cells( set, region_id );
+            BOOST_CHECK_EQUAL_COLLECTIONS( cells.begin(), cells.end(), expected.begin(), expected.end() );
+        }
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(region_reduction) {
+    ParseContext parseContext;
+    Parser parser;
+    Deck deck( parser.parseFile( path, parseContext ));
+    EclipseState es(deck , parseContext );
+    const EclipseGrid& grid = es.getInputGrid();
+    Schedule schedule( deck, grid, es.get3DProperties(), es.runspec().phases(), ParseContext() );
+    out::RegionCache rc(es.get3DProperties() , grid, schedule);
+
+    const auto num_active = grid.getNumActive();
+    std::vector< double > oip( num_active ), pressure( num_active ), swat( num_active ), pv( num_active );
+    for (size_t i = 0; i < num_active; i++) {
+        oip[i] = 1.0 + i;
+        pressure[i] = 100.0 + 0.5 * i;
+        swat[i] = 0.1 + 0.001 * (i % 100);
+        pv[i] = 2.0 + 0.25 * (i % 7);
+    }
+
+    data::Solution solution;
+    solution.insert( "OIP", UnitSystem::measure::volume, oip, data::TargetType::RESTART_SOLUTION );
+    solution.insert( "PRESSURE", UnitSystem::measure::pressure, pressure, data::TargetType::RESTART_SOLUTION );
+    solution.insert( "SWAT", UnitSystem::measure::identity, swat, data::TargetType::RESTART_SOLUTION );
+
+    out::RegionReduction reduction( rc, "FIPNUM", num_active );
+    reduction.addField( "OIP" );
+    reduction.addField( "GIP" );
+    reduction.addPressure();
+    out::HydrocarbonPoreVolume hcpv;
+    hcpv.update( pv, solution );
+    reduction.update( solution, hcpv );
+
+    for (const auto region_id : rc.regions( "FIPNUM" )) {
+        double sum = 0, weighted = 0, hcpv = 0;
+        for (const auto cell : rc.cells( region_id )) {
+            sum += oip[cell];
+            const double w = pv[cell] * (1.0 - swat[cell]);
+            weighted += w * pressure[cell];
+            hcpv += w;
+        }
+
+        BOOST_CHECK_EQUAL( reduction.sum( "OIP", region_id ) , sum );
+        BOOST_CHECK_EQUAL( reduction.sum( "GIP", region_id ) , 0.0 );
+        if (hcpv > 0)
+            BOOST_CHECK_EQUAL( reduction.pressure( region_id ) , weighted / hcpv );
+    }
+
+    BOOST_CHECK_EQUAL( reduction.sum( "WIP", 1 ) , 0.0 );
+    BOOST_CHECK_EQUAL( reduction.sum( "OIP", 1000 ) , 0.0 );
+
+    solution.insert( "GIP", UnitSystem::measure::volume, std::vector< double >( 3 ), data::TargetType::RESTART_SOLUTION );
+    BOOST_CHECK_THROW( reduction.update( solution, hcpv ), std::runtime_error );
+}